@@ -4,6 +4,10 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
+#include <mutex>
+
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 
 #include "revng/ABI/Definition.h"
@@ -175,6 +179,52 @@ public:
   void dump() const debug_function;
 };
 
+/// Memoizes the layouts of prototypes.
+///
+/// Computing a layout is expensive and the same prototype is usually requested
+/// many more times than there are distinct prototypes (e.g., once per call
+/// site). Layouts are cached by prototype definition and by a version stamp of
+/// the model it belongs to: whenever a different stamp is provided, all the
+/// cached layouts are dropped. It's up to the user to ensure the stamp changes
+/// every time the model might have been modified, TupleTree::readOnlyVersion
+/// provides such a stamp for read-only models.
+///
+/// All the methods are thread-safe and the returned layouts remain valid after
+/// the cache has been invalidated, so a single instance can be shared across
+/// all the passes of a pipeline run (see LayoutCache::shared).
+class LayoutCache {
+private:
+  std::mutex Mutex;
+  /// 0 is the stamp of unversioned lookups
+  uint64_t ModelVersion = 0;
+  llvm::DenseMap<const model::TypeDefinition *, std::shared_ptr<const Layout>>
+    Layouts;
+
+public:
+  /// \p ModelVersion must not be 0
+  std::shared_ptr<const Layout> get(const model::TypeDefinition &Prototype,
+                                    uint64_t ModelVersion);
+
+  /// Same as the other overload, the stamp is the readOnlyVersion of \p Model.
+  /// If \p Model is not read-only, the layout is computed without caching it.
+  std::shared_ptr<const Layout> get(const model::TypeDefinition &Prototype,
+                                    const TupleTree<model::Binary> &Model);
+
+  /// Same as the other overloads, but without a stamp: meant for caches whose
+  /// lifetime is limited to a region where the model is not modified. Mixing
+  /// it with the versioned lookups drops the cached layouts at every switch.
+  std::shared_ptr<const Layout> get(const model::TypeDefinition &Prototype);
+
+  void clear();
+
+  /// The instance shared by all the users within the process
+  static LayoutCache &shared();
+
+private:
+  std::shared_ptr<const Layout> getImpl(const model::TypeDefinition &Prototype,
+                                        uint64_t ModelVersion);
+};
+
 inline std::span<const model::Register::Values>
 calleeSavedRegisters(const model::CABIFunctionDefinition &Prototype) {
   return abi::Definition::get(Prototype.ABI()).CalleeSavedRegisters();
@@ -278,6 +278,11 @@ public:
     return AnyPC;
   }
 
+  const std::map<MetaAddress, llvm::BasicBlock *> &jumpTargets() {
+    parseRoot();
+    return JumpTargets;
+  }
+
   llvm::BasicBlock *unexpectedPC() {
     parseRoot();
     return UnexpectedPC;
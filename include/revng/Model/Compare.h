@@ -0,0 +1,42 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstddef>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+
+namespace model {
+
+struct YAMLComparison {
+  bool Matches = false;
+  /// Number of nodes of the reference matched by the largest partial match
+  size_t MatchedNodes = 0;
+  size_t ReferenceNodes = 0;
+};
+
+/// Check whether the YAML document \p Reference is contained in \p Input
+///
+/// Both documents are seen as graphs whose nodes are the mappings, the
+/// sequences and the scalars in sequences, and whose edges are the mapping
+/// entries, the sequence elements and the `/TypeDefinitions/` references. The
+/// reference is contained in the input if each of its nodes can be mapped to a
+/// distinct node of the input preserving the edges and such that:
+///
+/// * scalars are equal;
+/// * the scalar entries of the mappings of the reference, except for `ID`, are
+///   present in the input with the same value. An entry named `-Key` requires
+///   `Key` to be absent and a mapping or sequence entry named `$Key` requires
+///   `Key` to have the same size;
+///
+/// If \p Exact is true, mappings must have the same scalar entries and the
+/// elements of the sequences must appear in the same position.
+///
+/// These are the semantics of `revng model compare`.
+llvm::Expected<YAMLComparison>
+compareYAML(llvm::StringRef Reference, llvm::StringRef Input, bool Exact);
+
+} // namespace model
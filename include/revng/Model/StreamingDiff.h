@@ -0,0 +1,46 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstddef>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/TupleTree/TupleTreeDiff.h"
+
+namespace model {
+
+/// Compute the diff between the serialized models \p Old and \p New and write
+/// it to \p Output as it is computed.
+///
+/// The top-level collections of the model (`Functions`, `TypeDefinitions` and
+/// so on) are processed one element at a time, walking the two serializations
+/// in lockstep, so the peak memory usage is bounded by the size of the largest
+/// element rather than by the size of the model. Elements that are textually
+/// identical are not even deserialized.
+///
+/// This requires the collections to be serialized in block style and sorted,
+/// as `serialize` emits them. Collections in any other layout are loaded as a
+/// whole, if the elements are not sorted an error is returned.
+///
+/// \return the number of changes.
+llvm::Expected<size_t> streamingDiff(llvm::StringRef Old,
+                                     llvm::StringRef New,
+                                     llvm::raw_ostream &Output);
+
+/// Apply \p Diff to the serialized model \p Model and write the result to
+/// \p Output
+///
+/// Only the elements of the top-level collections affected by \p Diff are
+/// deserialized, all the others are copied verbatim. The same requirements of
+/// streamingDiff apply.
+llvm::Error streamingApply(llvm::StringRef Model,
+                           const TupleTreeDiff<model::Binary> &Diff,
+                           llvm::raw_ostream &Output);
+
+} // namespace model
@@ -0,0 +1,85 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace ptml {
+
+/// Renders a PTML document as plain text, optionally colorizing it with ANSI
+/// escape sequences according to the `data-token` attribute of the enclosing
+/// elements.
+///
+/// The input is processed in a single pass and can be fed in chunks of any
+/// size: the memory used is proportional to the nesting depth of the document
+/// and to the size of the largest tag, not to the size of the document.
+class TextRenderer {
+private:
+  enum class State {
+    Text,
+    Tag,
+    Entity
+  };
+
+  /// Sentinel for elements without a color
+  static constexpr uint8_t NoColor = 0;
+
+private:
+  llvm::raw_ostream &OS;
+  bool Color = false;
+  std::string Indent;
+
+  State Current = State::Text;
+  /// Content of the tag or of the entity being parsed
+  std::string Pending;
+  /// Quote character enclosing the attribute value being parsed, if any
+  char Quote = 0;
+
+  /// Color of each of the currently open elements
+  llvm::SmallVector<uint8_t, 16> Colors;
+  /// Color of the last escape sequence emitted
+  uint8_t Emitted = NoColor;
+
+  std::string ErrorMessage;
+
+public:
+  TextRenderer(llvm::raw_ostream &OS, bool Color, llvm::StringRef Indent = "") :
+    OS(OS), Color(Color), Indent(Indent.str()) {}
+
+public:
+  /// Process the next chunk of the document
+  void feed(llvm::StringRef Chunk);
+
+  /// Signal the end of the document
+  ///
+  /// \return an error if the document was malformed.
+  llvm::Error finish();
+
+public:
+  /// Render the whole \p Document into \p OS
+  static llvm::Error render(llvm::raw_ostream &OS,
+                            llvm::StringRef Document,
+                            bool Color,
+                            llvm::StringRef Indent = "") {
+    TextRenderer Renderer(OS, Color, Indent);
+    Renderer.feed(Document);
+    return Renderer.finish();
+  }
+
+private:
+  void handleTag(llvm::StringRef Tag);
+  void handleEntity(llvm::StringRef Entity);
+  void emitText(llvm::StringRef Text);
+  void setColor(uint8_t NewColor);
+  void fail(const llvm::Twine &Message);
+};
+
+} // namespace ptml
@@ -4,13 +4,24 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <optional>
+
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 
 #include "revng/Pipeline/Invokable.h"
 #include "revng/Pipeline/Pipe.h"
 
 namespace pipeline {
 
+/// Analyses can declare the names of the globals they might change in a
+/// `WrittenGlobals` static member. Analyses not declaring it are assumed to
+/// possibly change any global.
+template<typename T>
+concept DeclaresWrittenGlobals = requires() {
+  { T::WrittenGlobals.size() };
+};
+
 template<typename Analysis>
 class AnalysisWrapperImpl;
 
@@ -31,6 +42,10 @@ public:
   virtual std::unique_ptr<AnalysisWrapperBase>
   clone(std::vector<std::string> NewRunningContainersNames = {}) const = 0;
 
+  /// \return the names of the globals the analysis might change, or
+  ///         std::nullopt if it might change any of them.
+  virtual std::optional<std::vector<std::string>> getWrittenGlobals() const = 0;
+
   void invalidate(const GlobalTupleTreeDiff &Diff,
                   ContainerToTargetsMap &Map,
                   const ContainerSet &Containers) const override {
@@ -73,6 +88,17 @@ public:
     return Invokable.getPipe().AcceptedKinds.at(ContainerIndex);
   }
 
+  std::optional<std::vector<std::string>> getWrittenGlobals() const override {
+    if constexpr (DeclaresWrittenGlobals<Analysis>) {
+      std::vector<std::string> Result;
+      for (llvm::StringRef Name : Analysis::WrittenGlobals)
+        Result.push_back(Name.str());
+      return Result;
+    } else {
+      return std::nullopt;
+    }
+  }
+
   void dump(std::ostream &OS, size_t Indentation) const override {
     Invokable.dump(OS, Indentation);
   }
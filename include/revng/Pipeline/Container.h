@@ -5,6 +5,7 @@
 //
 
 #include <memory>
+#include <string>
 #include <system_error>
 #include <type_traits>
 #include <vector>
@@ -47,6 +48,32 @@ public:
   }
 };
 
+/// A frozen copy of the content of a container, that can be stored while the
+/// container it has been taken from keeps being modified.
+///
+/// Snapshots do not depend on any state shared with the container, they can be
+/// stored from a different thread.
+class ContainerSnapshot {
+public:
+  virtual ~ContainerSnapshot() = default;
+
+  /// Same as ContainerBase::store, on the content at the time the snapshot was
+  /// taken
+  virtual llvm::Error store(const revng::FilePath &Path) const = 0;
+};
+
+/// A snapshot holding the serialized content of a container
+class SerializedContainerSnapshot : public ContainerSnapshot {
+private:
+  std::string Serialized;
+
+public:
+  explicit SerializedContainerSnapshot(std::string Serialized) :
+    Serialized(std::move(Serialized)) {}
+
+  llvm::Error store(const revng::FilePath &Path) const override;
+};
+
 class ContainerBase {
 private:
   template<typename Derived>
@@ -123,6 +150,15 @@ public:
   /// loaded from the provided path.
   virtual llvm::Error load(const revng::FilePath &Path);
 
+  /// Returns a copy of the content of this container that can be stored later
+  /// from another thread, producing the same result this->store would produce
+  /// now.
+  ///
+  /// The default implementation stores a clone of the whole container.
+  /// Containers whose clones share state with the original (e.g., an
+  /// llvm::LLVMContext) must override it.
+  virtual std::unique_ptr<ContainerSnapshot> snapshot() const;
+
   /// Checks that the content of the this container is valid.
   virtual llvm::Error verify() const { return enumerate().verify(*this); }
 
@@ -160,6 +160,9 @@ public:
   llvm::Error store(const revng::DirectoryPath &DirectoryPath) const;
   llvm::Error load(const revng::DirectoryPath &DirectoryPath);
 
+  /// Take a snapshot of each instantiated container, indexed by name
+  llvm::StringMap<std::unique_ptr<ContainerSnapshot>> snapshot() const;
+
   std::vector<revng::FilePath>
   getWrittenFiles(const revng::DirectoryPath &DirectoryPath) const;
 
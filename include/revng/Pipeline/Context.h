@@ -123,10 +123,31 @@ public:
     return *llvm::cast<ContainerType>(ToReturn);
   }
 
+public:
+  /// A copy of the globals and of the commit index, that can be stored while
+  /// the context keeps being modified
+  class Snapshot {
+  private:
+    GlobalsMap Globals;
+    uint64_t CommitIndex = 0;
+
+  public:
+    Snapshot(GlobalsMap Globals, uint64_t CommitIndex) :
+      Globals(std::move(Globals)), CommitIndex(CommitIndex) {}
+
+  public:
+    uint64_t getCommitIndex() const { return CommitIndex; }
+
+    /// Same as Context::store, on the content at the time of the snapshot
+    llvm::Error store(const revng::DirectoryPath &Path) const;
+  };
+
 public:
   llvm::Error store(const revng::DirectoryPath &Path) const;
   llvm::Error load(const revng::DirectoryPath &Path);
 
+  Snapshot snapshot() const { return Snapshot(Globals, CommitIndex); }
+
 public:
   void collectReadFields(const TargetInContainer &Target,
                          llvm::StringMap<PathTargetBimap> &Out) const {
@@ -67,6 +67,12 @@ public:
   virtual std::optional<std::string>
   serializePath(const TupleTreePath &Path) const = 0;
 
+  /// Serialize the element at \p Path into \p OS.
+  ///
+  /// \return false if there's no such element or if it cannot be serialized.
+  virtual bool serializeAt(llvm::raw_ostream &OS,
+                           const TupleTreePath &Path) const = 0;
+
   virtual void collectReadFields(const TargetInContainer &Target,
                                  PathTargetBimap &Out) = 0;
   virtual void clearAndResume() const = 0;
@@ -189,6 +195,48 @@ public:
     return pathAsString<Object>(Path);
   }
 
+private:
+  struct SerializeElementVisitor {
+    llvm::raw_ostream &OS;
+    bool Serialized = false;
+
+    template<typename T, size_t I, typename K>
+    void visitTupleElement(K &Element) {
+      visit(Element);
+    }
+
+    template<typename T, size_t I, typename K, typename KindType>
+    void visitPolymorphicElement(KindType, K &Element) {
+      visit(Element);
+    }
+
+    template<typename T, typename K, typename KeyT>
+    void visitContainerElement(KeyT, K &Element) {
+      visit(Element);
+    }
+
+    template<typename K>
+    void visit(K &Element) {
+      if constexpr (Yamlizable<std::remove_const_t<K>>) {
+        ::serialize(OS, Element);
+        Serialized = true;
+      }
+    }
+  };
+
+public:
+  bool serializeAt(llvm::raw_ostream &OS,
+                   const TupleTreePath &Path) const override {
+    const Object &Root = *Value;
+    SerializeElementVisitor Visitor{ OS };
+    if (Path.size() == 0)
+      Visitor.visit(Root);
+    else if (not callByPath(Visitor, Path, Root))
+      return false;
+
+    return Visitor.Serialized;
+  }
+
   void collectReadFields(const TargetInContainer &Target,
                          PathTargetBimap &Out) override {
     const TupleTree<Object> &AsConst = Value;
@@ -4,8 +4,11 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/ADT/ArrayRef.h"
+
 #include "revng/Pipeline/Global.h"
 #include "revng/Storage/Path.h"
+#include "revng/Support/Assert.h"
 
 namespace pipeline {
 class GlobalsMap {
@@ -120,6 +123,18 @@ public:
     return MaybeGlobal.get()->createNew(GlobalName, Buffer);
   }
 
+  /// Create a copy containing only the globals named in \p Names
+  GlobalsMap cloneFiltered(llvm::ArrayRef<std::string> Names) const {
+    GlobalsMap Result;
+    for (const std::string &Name : Names) {
+      auto It = Map.find(Name);
+      revng_assert(It != Map.end());
+      Result.Map.try_emplace(Name, It->second->clone());
+    }
+
+    return Result;
+  }
+
   llvm::Expected<std::unique_ptr<Global>> clone(llvm::StringRef GlobalName) {
     auto MaybeGlobal = get(GlobalName);
     if (!MaybeGlobal)
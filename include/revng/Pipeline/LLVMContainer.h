@@ -4,8 +4,13 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <mutex>
+
+#include "llvm/Support/MemoryBuffer.h"
+
 #include "revng/Pipeline/ContainerEnumerator.h"
 #include "revng/Pipeline/Pipe.h"
+#include "revng/Storage/ReadableFile.h"
 #include "revng/Support/ModuleStatistics.h"
 
 inline Logger<> ModuleStatisticsLogger("module-statistics");
@@ -29,7 +34,28 @@ private:
   using ThisType = LLVMContainer;
 
 private:
-  std::unique_ptr<llvm::Module> Module;
+  /// Always present: while the container is pending, this is an empty module
+  /// providing the llvm::LLVMContext to parse the actual module with
+  mutable std::unique_ptr<llvm::Module> Module;
+
+  /// The file the container has been loaded from, if the module has not been
+  /// parsed yet. See ::load.
+  /// This is usually memory mapped: only the pages that are actually read are
+  /// loaded from disk. StorageClients replace files on commit rather than
+  /// overwriting them, so it stays valid even if ::store writes to its path.
+  mutable std::unique_ptr<revng::ReadableFile> Pending;
+
+  /// The targets of the pending module, as recorded by ::store
+  mutable TargetsList PendingTargets;
+
+  /// The pending module itself, i.e., what follows the list of targets in
+  /// Pending, and its hash as recorded by ::store
+  mutable llvm::StringRef PendingBody;
+  mutable uint64_t PendingHash = 0;
+
+  /// Protects Pending, PendingTargets and Module while the module is
+  /// materialized by const accessors
+  mutable std::mutex PendingMutex;
 
 public:
   inline static const llvm::StringRef MIMEType = "text/x.llvm.ir";
@@ -55,8 +81,15 @@ public:
   }
 
 public:
-  const llvm::Module &getModule() const { return *Module; }
-  llvm::Module &getModule() { return *Module; }
+  const llvm::Module &getModule() const {
+    materialize();
+    return *Module;
+  }
+
+  llvm::Module &getModule() {
+    materialize();
+    return *Module;
+  }
 
 public:
   std::unique_ptr<ContainerBase>
@@ -65,18 +98,46 @@ public:
   llvm::Error extractOne(llvm::raw_ostream &OS,
                          const Target &Target) const override;
 
+  TargetsList enumerate() const final;
+
 public:
   llvm::Error serialize(llvm::raw_ostream &OS) const final;
 
   llvm::Error deserialize(const llvm::MemoryBuffer &Buffer) final;
 
+  /// Same as ContainerBase::store, but the file starts with a comment listing
+  /// the targets of the container, so that ::load can avoid parsing it
+  llvm::Error store(const revng::FilePath &Path) const final;
+
+  /// If the file has been produced by ::store, only read the list of its
+  /// targets: the module is checked against the hash recorded along with them
+  /// and parsed the first time it's actually needed
+  llvm::Error load(const revng::FilePath &Path) final;
+
+  /// Clones would share the llvm::LLVMContext, which is not thread safe:
+  /// serialize the module in memory instead
+  std::unique_ptr<ContainerSnapshot> snapshot() const final;
+
   void clear() final {
+    std::lock_guard<std::mutex> Lock(PendingMutex);
+    Pending.reset();
+    PendingTargets = {};
+    PendingBody = {};
+    PendingHash = 0;
     Module = std::make_unique<llvm::Module>("revng.module",
                                             Module->getContext());
   }
 
 private:
   void mergeBackImpl(ThisType &&OtherContainer) final;
+
+  /// Parse the pending module, if any
+  void materialize() const;
+
+  llvm::Expected<std::unique_ptr<llvm::Module>>
+  parse(const llvm::MemoryBuffer &Buffer) const;
+
+  void serializeWithTargets(llvm::raw_ostream &OS) const;
 };
 
 } // namespace pipeline
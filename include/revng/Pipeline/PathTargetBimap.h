@@ -7,6 +7,7 @@
 #include <string>
 #include <tuple>
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/YAMLTraits.h"
 
@@ -121,6 +122,14 @@ public:
   bool contains(const TargetInContainer &Target) const {
     return ReverseMap.find(Target) != ReverseMap.end();
   }
+
+  llvm::ArrayRef<TupleTreePath>
+  getPaths(const TargetInContainer &Target) const {
+    auto Iter = ReverseMap.find(Target);
+    if (Iter == ReverseMap.end())
+      return {};
+    return Iter->second;
+  }
 };
 
 } // namespace pipeline
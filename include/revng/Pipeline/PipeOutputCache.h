@@ -0,0 +1,122 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "revng/Pipeline/ContainerSet.h"
+#include "revng/Pipeline/Context.h"
+#include "revng/Pipeline/PathTargetBimap.h"
+#include "revng/Pipeline/Pipe.h"
+#include "revng/Pipeline/Target.h"
+#include "revng/TupleTree/TupleTreePath.h"
+
+namespace pipeline {
+
+/// In-memory, content-addressed store of the results of pipe invocations.
+///
+/// An invocation is identified by a hash of the name of the pipe, of the
+/// requested targets and of the content of the input targets of the pipe.
+/// Globals are not part of the key: each entry records the paths of the
+/// globals read while producing its targets, along with a hash of their value.
+/// If an invocation with the same key has already been executed and the values
+/// at those paths did not change, the produced targets and their invalidation
+/// metadata are restored instead of running the pipe again.
+///
+/// The cache is disabled unless `-pipe-output-cache-size` is not zero.
+class PipeOutputCache {
+public:
+  struct Statistics {
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    /// Entries found but dropped since a global they read has changed
+    uint64_t Invalidations = 0;
+  };
+
+private:
+  struct ReadPath {
+    std::string GlobalName;
+    TargetInContainer Target;
+    TupleTreePath Path;
+  };
+
+  struct Entry {
+    /// Serialized produced targets of each non-const container
+    std::vector<std::pair<std::string, std::string>> Containers;
+    std::vector<ReadPath> ReadPaths;
+    /// Hash of the values of the globals at ReadPaths
+    std::string ReadValuesHash;
+
+    size_t size() const;
+  };
+
+  using EntryList = std::list<std::pair<std::string, Entry>>;
+
+private:
+  /// Most recently used entries first
+  EntryList Entries;
+  llvm::StringMap<EntryList::iterator> Index;
+  size_t Size = 0;
+  llvm::StringMap<Statistics> PipeStatistics;
+
+public:
+  static PipeOutputCache &get();
+
+public:
+  bool isEnabled() const;
+
+  /// Compute the key of the invocation of \p Pipe on the \p Slice of \p Input
+  /// producing \p Requested.
+  std::string computeKey(const PipeWrapper &Pipe,
+                         const ContainerSet &Input,
+                         const ContainerToTargetsMap &Slice,
+                         const ContainerToTargetsMap &Requested) const;
+
+  /// Restore the results of the invocation identified by \p Key into \p Input
+  /// and the invalidation metadata of \p Pipe.
+  ///
+  /// \note This method reads the globals, hence it must not be invoked while
+  ///       tracking the read fields.
+  ///
+  /// \return false if the invocation is not in the cache or if the globals it
+  ///         read have changed since.
+  bool restore(llvm::StringRef Key,
+               const Context &Context,
+               PipeWrapper &Pipe,
+               ContainerSet &Input);
+
+  /// Record the results of the invocation of \p Pipe identified by \p Key.
+  ///
+  /// \note This method reads the globals, hence it must not be invoked while
+  ///       tracking the read fields.
+  void record(std::string Key,
+              const Context &Context,
+              const PipeWrapper &Pipe,
+              const ContainerSet &Output,
+              const ContainerToTargetsMap &Produced);
+
+  const llvm::StringMap<Statistics> &statistics() const {
+    return PipeStatistics;
+  }
+
+  void clear();
+
+private:
+  void evict();
+  void erase(llvm::StringMap<EntryList::iterator>::iterator It);
+
+  static std::optional<std::string>
+  hashReadValues(const Context &Context, const std::vector<ReadPath> &Reads);
+};
+
+} // namespace pipeline
@@ -4,8 +4,10 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
@@ -17,6 +19,7 @@
 #include "revng/Pipeline/ContainerFactorySet.h"
 #include "revng/Pipeline/Description/PipelineDescription.h"
 #include "revng/Pipeline/GlobalTupleTreeDiff.h"
+#include "revng/Pipeline/GlobalsMap.h"
 #include "revng/Pipeline/KindsRegistry.h"
 #include "revng/Pipeline/Step.h"
 #include "revng/Pipeline/Target.h"
@@ -77,6 +80,13 @@ public:
   void getDiffInvalidations(const GlobalTupleTreeDiff &Diff,
                             pipeline::TargetInStepSet &Out) const;
 
+private:
+  using OptionalNames = std::optional<std::vector<std::string>>;
+
+  /// Copy the globals named in \p Names, or all of them if \p Names is
+  /// std::nullopt
+  GlobalsMap snapshotGlobals(const OptionalNames &Names) const;
+
 public:
   Step &operator[](llvm::StringRef Name) { return getStep(Name); }
   const Step &operator[](llvm::StringRef Name) const { return getStep(Name); }
@@ -221,6 +231,35 @@ public:
   std::vector<revng::FilePath>
   getWrittenFiles(const revng::DirectoryPath &DirPath) const;
 
+public:
+  /// A copy of the content of all the steps and of the context, that can be
+  /// stored, even from another thread, while the runner keeps being used
+  class Snapshot {
+  private:
+    friend class Runner;
+
+    llvm::StringMap<Step::Snapshot> Steps;
+    Context::Snapshot TheContext;
+
+  private:
+    explicit Snapshot(Context::Snapshot TheContext) :
+      TheContext(std::move(TheContext)) {}
+
+  public:
+    uint64_t getCommitIndex() const { return TheContext.getCommitIndex(); }
+
+    /// Do not store \p StepName, e.g., because a more recent version of it has
+    /// already been stored
+    void dropStep(llvm::StringRef StepName) { Steps.erase(StepName); }
+
+    /// Same as Runner::store, on the content at the time of the snapshot
+    llvm::Error store(const revng::DirectoryPath &DirPath) const;
+  };
+
+  /// Take a snapshot of the current content of the runner. This is much
+  /// cheaper than store, since no serialization to storage takes place.
+  Snapshot snapshot() const;
+
 public:
   void deduceAllPossibleTargets(State &State) const;
 
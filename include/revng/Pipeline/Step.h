@@ -14,6 +14,7 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Error.h"
@@ -146,7 +147,9 @@ private:
 private:
   llvm::Error loadInvalidationMetadata(const revng::DirectoryPath &Path);
 
-  llvm::Error storeInvalidationMetadata(const revng::DirectoryPath &Path) const;
+  /// Serialize the invalidation metadata of each instantiated container,
+  /// indexed by container name
+  llvm::StringMap<std::string> serializeInvalidationMetadata() const;
 
 public:
   void addAnalysis(llvm::StringRef Name, AnalysisWrapper Analysis) {
@@ -296,10 +299,27 @@ public:
   /// status
   llvm::Error invalidate(const ContainerToTargetsMap &ToRemove);
 
+public:
+  /// A copy of the containers and of the invalidation metadata of a step, that
+  /// can be stored while the step keeps being used
+  class Snapshot {
+  private:
+    friend class Step;
+
+    llvm::StringMap<std::unique_ptr<ContainerSnapshot>> Containers;
+    llvm::StringMap<std::string> InvalidationMetadata;
+
+  public:
+    /// Same as Step::store, on the content at the time of the snapshot
+    llvm::Error store(const revng::DirectoryPath &DirPath) const;
+  };
+
 public:
   llvm::Error store(const revng::DirectoryPath &DirPath) const;
   llvm::Error load(const revng::DirectoryPath &DirPath);
 
+  Snapshot snapshot() const;
+
   std::vector<revng::FilePath>
   getWrittenFiles(const revng::DirectoryPath &DirPath) const;
 
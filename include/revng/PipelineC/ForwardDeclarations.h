@@ -56,5 +56,6 @@ typedef pipeline::TargetInStepSet rp_invalidations;
 typedef llvm::SmallVector<char, 0> rp_buffer;
 typedef pipeline::ContainerToTargetsMap rp_container_targets_map;
 typedef const pipeline::AnalysesList rp_analyses_list;
+typedef pipeline::Runner::Snapshot rp_snapshot;
 
 // NOLINTEND
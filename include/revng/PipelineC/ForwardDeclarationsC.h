@@ -24,5 +24,6 @@ typedef struct rp_invalidations rp_invalidations;
 typedef struct rp_buffer rp_buffer;
 typedef struct rp_container_targets_map rp_container_targets_map;
 typedef struct rp_analyses_list rp_analyses_list;
+typedef struct rp_snapshot rp_snapshot;
 
 // NOLINTEND
@@ -154,6 +154,24 @@ rp_manager_get_container_identifier_from_name(const rp_manager *manager,
  */
 bool rp_manager_save(rp_manager *manager);
 
+/**
+ * Take a snapshot of the pipeline, to be saved with
+ * \related rp_manager_save_snapshot. This is much faster than saving.
+ *
+ * \return owning pointer to the snapshot
+ */
+rp_snapshot * /*owning*/ rp_manager_snapshot(rp_manager *manager);
+
+/**
+ * Save on disk a snapshot taken with \related rp_manager_snapshot.
+ * Unlike all the other functions, this can be called from another thread while
+ * \p manager is being used. Snapshots older than the last saved one are
+ * ignored.
+ *
+ * \return false if there was an error while saving, true otherwise
+ */
+bool rp_manager_save_snapshot(rp_manager *manager, rp_snapshot *snapshot);
+
 /**
  * \return the step with the provided name, or NULL if not such step existed.
  */
@@ -547,6 +565,18 @@ rp_invalidations_serialize(const rp_invalidations *invalidations);
 
 /** \} */
 
+/**
+ * \defgroup rp_snapshot rp_snapshot methods
+ * \{
+ */
+
+/**
+ * Free a rp_snapshot
+ */
+void rp_snapshot_destroy(rp_snapshot *snapshot);
+
+/** \} */
+
 /**
  * \defgroup rp_buffer rp_buffer methods
  * \{
@@ -569,6 +599,33 @@ void rp_buffer_destroy(rp_buffer *buffer);
 
 /** \} */
 
+/**
+ * \defgroup rp_ptml PTML rendering
+ * \{
+ */
+
+/**
+ * Render a PTML document as text, stripping all the tags
+ *
+ * \param content_size size of \p content
+ * \param content the PTML document
+ * \param color if not 0, colorize the output with ANSI escape sequences
+ *        according to the tokens of the document
+ * \param indent string to emit after each newline, can be empty
+ * \param error if the document is malformed, will be set to the description
+ *        of the error
+ *
+ * \return 0 if the document is malformed, the rendered document otherwise
+ */
+rp_buffer * /*owning*/ rp_ptml_render(uint64_t content_size,
+                                      const char *content,
+                                      uint8_t color,
+                                      const char *indent,
+                                      rp_error *error);
+LENGTH_HINT(rp_ptml_render, 1, 0)
+
+/** \} */
+
 /**
  * \defgroup rp_container_targets_map rp_container_targets_map methods
  * \{
@@ -4,6 +4,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <array>
 #include <tuple>
 #include <vector>
 
@@ -43,6 +44,7 @@ struct ApplyDiffAnalysis {
 /// the current global, otherwise an Error is returned.
 struct VerifyDiffAnalysis {
   static constexpr auto Name = "verify-diff";
+  static constexpr std::array<const char *, 0> WrittenGlobals = {};
   constexpr static std::tuple Options = options::DiffOptions;
 
   std::vector<std::vector<pipeline::Kind *>> AcceptedKinds = {};
@@ -72,6 +74,7 @@ struct SetGlobalAnalysis {
 /// returned, otherwise the error from the `verify` is returned.
 struct VerifyGlobalAnalysis {
   static constexpr auto Name = "verify-global";
+  static constexpr std::array<const char *, 0> WrittenGlobals = {};
   constexpr static std::tuple Options = options::SetOptions;
 
   std::vector<std::vector<pipeline::Kind *>> AcceptedKinds = {};
@@ -4,6 +4,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -46,6 +47,17 @@ private:
     ContainerToEnumeration;
   std::string Description;
 
+  /// Serializes the writes to the storage, which can be issued by
+  /// storeSnapshot from a thread other than the one using the manager.
+  /// Reads, including the ones of containers materialized lazily, need no lock
+  /// since StorageClient is thread safe and replaces files atomically.
+  std::unique_ptr<std::mutex> StorageMutex = std::make_unique<std::mutex>();
+  /// Commit index of the last full store, protected by StorageMutex
+  uint64_t LastStoredCommitIndex = 0;
+  /// Commit index at which each step has last been stored on its own by
+  /// storeStepToDisk, protected by StorageMutex
+  llvm::StringMap<uint64_t> StepStoredCommitIndex;
+
 public:
   PipelineManager(PipelineManager &&Other) = default;
   PipelineManager &operator=(PipelineManager &&Other) = default;
@@ -102,6 +114,18 @@ public:
   /// the Execution directory if omitted.
   llvm::Error storeStepToDisk(llvm::StringRef StepName);
 
+  /// Take a snapshot of every step, container and global, to be stored later
+  /// with storeSnapshot. This is much cheaper than store.
+  pipeline::Runner::Snapshot snapshot() const;
+
+  /// Store a snapshot taken with snapshot() to the execution directory.
+  ///
+  /// Unlike all the other methods, this can be invoked from another thread
+  /// while the manager is being used. Stores never go back in time: a snapshot
+  /// older than the last stored one is discarded and steps stored by
+  /// storeStepToDisk after the snapshot has been taken are left untouched.
+  llvm::Error storeSnapshot(pipeline::Runner::Snapshot &&Snapshot);
+
   const pipeline::Step::AnalysisValueType &
   getAnalysis(const pipeline::AnalysisReference &Reference) const;
 
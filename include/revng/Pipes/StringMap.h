@@ -5,10 +5,13 @@
 //
 
 #include <map>
+#include <memory>
 #include <utility>
 
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/xxhash.h"
 
 #include "revng/Pipeline/Container.h"
 #include "revng/Pipeline/ContainerSet.h"
@@ -18,12 +21,20 @@
 #include "revng/Pipes/Kinds.h"
 #include "revng/Pipes/ModelGlobal.h"
 #include "revng/Pipes/TypeKind.h"
+#include "revng/Support/GzipStream.h"
 #include "revng/Support/GzipTarFile.h"
 #include "revng/Support/MetaAddress.h"
 #include "revng/Support/MetaAddress/YAMLTraits.h"
 #include "revng/Support/YAMLTraits.h"
 #include "revng/TupleTree/TupleTree.h"
 
+/// If true, string maps keep the compressed copy of each entry after
+/// serializing it, so that the entries that did not change are not compressed
+/// again the next time. This trades memory, roughly the compressed size of the
+/// container, for time, and only pays off in long-lived processes that
+/// serialize the same containers several times, such as the daemon.
+extern llvm::cl::opt<bool> CacheCompressedStringMaps;
+
 namespace detail {
 
 struct DataOffset {
@@ -98,14 +109,30 @@ public:
 
 private:
   using OffsetMap = ::detail::OffsetMap<KeyType>;
+
+  /// The data of an entry compressed as a stand-alone gzip stream, along with
+  /// the size and the hash of the uncompressed data it was produced from
+  struct CompressedEntry {
+    size_t Size = 0;
+    uint64_t Hash = 0;
+    std::shared_ptr<const std::string> Data;
+  };
+  using CompressedEntryMap = std::map<KeyType, CompressedEntry>;
+
   MapType Map;
 
+  /// The compressed entries produced by the last serialization. Entries whose
+  /// data did not change since then are copied as they are in the archive,
+  /// instead of being compressed again.
+  /// Always empty unless -cache-compressed-string-maps is enabled.
+  mutable CompressedEntryMap CompressedEntries;
+
 public:
   inline static char ID = '0';
 
 public:
   GenericStringMap(llvm::StringRef Name) :
-    pipeline::Container<GenericStringMap>(Name), Map() {
+    pipeline::Container<GenericStringMap>(Name), Map(), CompressedEntries() {
     revng_assert(&K->rank() == Rank);
   }
 
@@ -118,7 +145,10 @@ public:
   ~GenericStringMap() override = default;
 
 public:
-  void clear() override { Map.clear(); }
+  void clear() override {
+    Map.clear();
+    CompressedEntries.clear();
+  }
 
   std::unique_ptr<pipeline::ContainerBase>
   cloneFiltered(const pipeline::TargetsList &Targets) const override {
@@ -248,6 +278,10 @@ protected:
     // Other.Map.
     Other.Map.merge(std::move(this->Map));
     this->Map = std::move(Other.Map);
+
+    // Stale compressed entries are detected and dropped upon serialization
+    Other.CompressedEntries.merge(std::move(this->CompressedEntries));
+    this->CompressedEntries = std::move(Other.CompressedEntries);
   }
 
 public:
@@ -310,24 +344,55 @@ private:
       llvm::StringRef Name = Entry.Filename;
       revng_assert(Name.consume_back(ArchiveSuffix));
       KeyType Key = keyFromString(Name);
-      std::string Data = std::string(Entry.Data.data(), Entry.Data.size());
-      Map[Key] = Data;
+      Map[Key] = std::move(Entry.Data);
+    }
+  }
+
+  /// Compress \p Data, the data of the entry \p Key, unless it didn't change
+  /// since the last serialization
+  CompressedEntry compress(const KeyType &Key, const std::string &Data) const {
+    uint64_t Hash = llvm::xxHash64(Data);
+    auto It = CompressedEntries.find(Key);
+    if (It != CompressedEntries.end() and It->second.Size == Data.size()
+        and It->second.Hash == Hash) {
+      return It->second;
     }
+
+    auto Compressed = std::make_shared<std::string>();
+    llvm::raw_string_ostream Stream(*Compressed);
+    gzipCompress(Stream, { Data.data(), Data.size() });
+    Stream.flush();
+    return { .Size = Data.size(), .Hash = Hash, .Data = std::move(Compressed) };
   }
 
   OffsetMap serializeWithOffsets(llvm::raw_ostream &OS) const {
     OffsetMap Result;
+    CompressedEntryMap NewCompressedEntries;
     revng::GzipTarWriter Writer(OS);
     for (auto &[Key, Data] : Map) {
+      CompressedEntry Compressed = compress(Key, Data);
+      llvm::ArrayRef<char> CompressedData(Compressed.Data->data(),
+                                          Compressed.Data->size());
       std::string Name = keyToString(Key) + ArchiveSuffix;
-      OffsetDescriptor Offsets = Writer.append(Name,
-                                               { Data.data(), Data.size() });
+      OffsetDescriptor Offsets = Writer.appendCompressed(Name,
+                                                         Data.size(),
+                                                         CompressedData);
       Result[Key] = { .UncompressedSize = Data.size(),
                       .Start = Offsets.DataStart,
                       .End = Offsets.PaddingStart - 1 };
+      if (CacheCompressedStringMaps)
+        NewCompressedEntries.emplace_hint(NewCompressedEntries.end(),
+                                          Key,
+                                          std::move(Compressed));
     }
     Writer.close();
 
+    // Only keep the entries that are still in the container
+    if (CacheCompressedStringMaps)
+      CompressedEntries = std::move(NewCompressedEntries);
+    else
+      CompressedEntries.clear();
+
     return Result;
   }
 
@@ -0,0 +1,30 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/Pass.h"
+
+/// Replaces the jumps to `anypc` in `root` with per-site inline caches
+///
+/// Each site compares the current PC against the last targets it has observed
+/// and, on a hit, jumps to the corresponding jump target through an
+/// `indirectbr` of its own, so that each site is predicted separately. On a
+/// miss, the target is resolved through a dedicated dispatcher and recorded in
+/// the cache of the site. The size of the caches is controlled by
+/// `-indirect-jump-inline-cache-size`, 0 (the default) disables the pass.
+///
+/// \note the resulting IR employs `indirectbr`, therefore this pass is run
+///       only on the code that is going to be recompiled.
+class IndirectJumpInlineCachesPass : public llvm::ModulePass {
+public:
+  static char ID;
+
+public:
+  IndirectJumpInlineCachesPass() : llvm::ModulePass(ID) {}
+
+  void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+
+  bool runOnModule(llvm::Module &M) override;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/Pass.h"
+
+/// Inlines small QEMU helpers in `root` and isolated functions, within a budget
+///
+/// Helpers are considered in order of increasing size, then by decreasing
+/// number of call sites. All the call sites of a helper no larger than
+/// `-inline-helpers-size-threshold` instructions are inlined, as long as the
+/// instructions they add fit in `-inline-helpers-budget`. Helpers that do not
+/// fit are marked `noinline`, so that the optimization pipeline that follows
+/// does not exceed the budget on its own. Larger helpers are left to it.
+///
+/// The decision taken for each helper is reported by the `inline-helpers`
+/// logger.
+///
+/// \note QEMU helpers are internalized during lift, so a helper that is no
+///       longer called after inlining is dropped.
+class InlineSmallHelpersPass : public llvm::ModulePass {
+public:
+  static char ID;
+
+public:
+  InlineSmallHelpersPass() : llvm::ModulePass(ID) {}
+
+  bool runOnModule(llvm::Module &M) override;
+};
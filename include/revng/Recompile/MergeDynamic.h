@@ -0,0 +1,29 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/raw_ostream.h"
+
+/// Merge the dynamic portions of \p Source, the original ELF, into
+/// \p ToExtend, the ELF obtained linking the translated code, and write the
+/// result to \p Output
+///
+/// The dynamic string table, symbols, relocations and symbol versions of
+/// \p Source are appended to those of \p ToExtend in a new `PT_LOAD` segment,
+/// along with a new `.dynamic` and a hash table covering all the symbols.
+/// If \p Source is not dynamic, \p ToExtend is copied unchanged.
+///
+/// \p Base is the address where \p Source has been loaded, in case it's
+/// position independent. If \p MergeLoadSegments is set, the `PT_LOAD`
+/// segments of \p Source are copied to the output too.
+llvm::Error mergeDynamic(llvm::StringRef ToExtend,
+                         llvm::StringRef Source,
+                         llvm::raw_ostream &Output,
+                         uint64_t Base,
+                         bool MergeLoadSegments = false);
@@ -8,6 +8,13 @@
 
 namespace revng {
 
+/// A read-only view of a file obtained from a StorageClient
+///
+/// The buffer is owned by the ReadableFile and is valid as long as it's alive.
+/// Its content might be memory mapped from disk, hence users should parse it
+/// in place rather than copying it, whenever possible. Writing to the same path
+/// through a StorageClient does not affect it, since WritableFile::commit
+/// replaces the file rather than overwriting it.
 class ReadableFile {
 protected:
   ReadableFile() = default;
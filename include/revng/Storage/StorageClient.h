@@ -44,6 +44,12 @@ enum class PathType {
 /// * Local filesystem via ordinary unix paths
 /// * S3 storage via the 's3://' and 's3s://` uris
 ///
+/// StorageClients are thread safe: their methods can be called concurrently,
+/// e.g., by PipelineManager::storeSnapshot while the pipeline is producing.
+/// A written file becomes visible atomically on WritableFile::commit: readers
+/// see either the old or the new content, and ReadableFiles obtained before
+/// the commit keep seeing the old one.
+///
 /// Writing files happens in 3 steps:
 /// * A writable file is requested via ::getWritableFile
 /// * The writable file is committed via WritableFile::commit
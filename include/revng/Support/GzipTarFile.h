@@ -4,6 +4,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -68,12 +69,24 @@ public:
   GzipTarWriter &operator=(GzipTarWriter &&Other) = default;
 
   OffsetDescriptor append(llvm::StringRef Name, llvm::ArrayRef<char> Data);
+
+  /// Same as ::append, but the data of the file is provided already compressed
+  /// as a stand-alone gzip stream, e.g., the range described by a previous
+  /// OffsetDescriptor. \p Size is the size of the uncompressed data.
+  OffsetDescriptor appendCompressed(llvm::StringRef Name,
+                                    size_t Size,
+                                    llvm::ArrayRef<char> CompressedData);
   void close();
+
+private:
+  OffsetDescriptor appendImpl(llvm::StringRef Name,
+                              size_t Size,
+                              llvm::function_ref<void()> WriteData);
 };
 
 struct ArchiveEntry {
   std::string Filename;
-  llvm::SmallVector<char> Data;
+  std::string Data;
 };
 
 class GzipTarReader {
@@ -4,14 +4,43 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <map>
+#include <optional>
+
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/AssemblyAnnotationWriter.h"
 #include "llvm/IR/LLVMContext.h"
 
+#include "revng/Support/MetaAddress.h"
+
+namespace llvm {
+class Instruction;
+class Module;
+} // namespace llvm
+
+/// Provides the disassembly of the original instructions of a module
+///
+/// The `oi` metadata only records the address and the size of the original
+/// instruction: its disassembly is recorded once, as an argument of the
+/// corresponding call to `newpc`.
+class OriginalAssemblyIndex {
+private:
+  unsigned OriginalInstrMDKind;
+  std::map<MetaAddress, llvm::StringRef> Disassembly;
+
+public:
+  OriginalAssemblyIndex(const llvm::Module &M);
+
+public:
+  /// \return the disassembly of the original instruction \p I has been lifted
+  ///         from, or an empty string if it's not available.
+  llvm::StringRef get(const llvm::Instruction *I) const;
+};
+
 /// AssemblyAnnotationWriter decorating the output original assembly/PTC
 class OriginalAssemblyAnnotationWriter : public llvm::AssemblyAnnotationWriter {
 public:
   OriginalAssemblyAnnotationWriter(llvm::LLVMContext &Context) :
-    OriginalInstrMDKind(Context.getMDKindID("oi")),
     PTCInstrMDKind(Context.getMDKindID("pi")) {}
 
   ~OriginalAssemblyAnnotationWriter() override = default;
@@ -21,6 +50,8 @@ public:
                        llvm::formatted_raw_ostream &Output) override;
 
 private:
-  unsigned OriginalInstrMDKind;
   unsigned PTCInstrMDKind;
+
+  /// Built upon the first instruction we're asked to annotate
+  std::optional<OriginalAssemblyIndex> Index;
 };
@@ -0,0 +1,80 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/raw_ostream.h"
+
+/// Binary format of the traces produced by `--trace`
+///
+/// A trace starts with a header (`Magic`, a 32-bit little endian `Version`
+/// and the 32-bit PID) followed by a sequence of chunks, each one containing
+/// the events recorded by a single thread. A chunk is the ULEB128-encoded
+/// thread ID, the ULEB128-encoded size of its payload and the payload itself,
+/// a sequence of events.
+///
+/// Each event is its `EventKind`, its timestamp (in microseconds since the
+/// epoch, ULEB128), its duration (ULEB128, only for `Span`) and its name
+/// (ULEB128-encoded length followed by the characters).
+namespace ProgressTrace {
+
+inline constexpr llvm::StringLiteral Magic = "RVNGPTRC";
+inline constexpr uint32_t Version = 1;
+
+enum EventKind : uint8_t {
+  Span,
+  Instant
+};
+
+/// Maximum size of the encoding of a chunk header
+inline constexpr size_t MaxChunkHeaderSize = 20;
+
+/// Size of the encoding of an event
+size_t eventSize(EventKind Kind,
+                 llvm::StringRef Name,
+                 uint64_t Timestamp,
+                 uint64_t Duration = 0);
+
+/// Encode an event in \p Output, which must have room for eventSize bytes.
+/// Does not allocate memory, hence it can be used in signal handlers.
+///
+/// \return the number of bytes written
+size_t encodeEvent(char *Output,
+                   EventKind Kind,
+                   llvm::StringRef Name,
+                   uint64_t Timestamp,
+                   uint64_t Duration = 0);
+
+/// Append the encoding of an event to \p Buffer
+void appendEvent(std::string &Buffer,
+                 EventKind Kind,
+                 llvm::StringRef Name,
+                 uint64_t Timestamp,
+                 uint64_t Duration = 0);
+
+/// Encode a chunk header in \p Output, which must have room for
+/// MaxChunkHeaderSize bytes. Does not allocate memory.
+///
+/// \return the number of bytes written
+size_t encodeChunkHeader(char *Output, uint64_t TID, uint64_t Size);
+
+/// Append a chunk header to \p Buffer
+void appendChunkHeader(std::string &Buffer, uint64_t TID, uint64_t Size);
+
+/// Append a chunk header to \p Output
+void writeChunkHeader(llvm::raw_ostream &Output, uint64_t TID, uint64_t Size);
+
+/// Write the header of a trace to \p Output
+void writeHeader(llvm::raw_ostream &Output, uint32_t PID);
+
+/// Convert the binary trace in \p Trace to the Chrome trace event format
+llvm::Error toChromeJSON(llvm::StringRef Trace, llvm::raw_ostream &Output);
+
+} // namespace ProgressTrace
@@ -5,6 +5,7 @@
 //
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <set>
@@ -75,11 +76,20 @@ private:
   }
 };
 
+namespace revng::detail {
+
+inline std::atomic<uint64_t> NextTupleTreeReadOnlyVersion = 1;
+
+} // namespace revng::detail
+
 template<TupleTreeCompatible T>
 class TupleTree {
 private:
   std::unique_ptr<T> Root;
   bool AllReferencesAreCached = false;
+  /// Identifies the period since the tree became read-only, see
+  /// readOnlyVersion
+  uint64_t ReadOnlyVersion = 0;
 
 public:
   TupleTree() : Root(new T), AllReferencesAreCached(false) {}
@@ -92,12 +102,14 @@ public:
     if (Other.get() == nullptr) {
       Root = nullptr;
       AllReferencesAreCached = false;
+      ReadOnlyVersion = 0;
       return *this;
     }
 
     if (this != &Other) {
       *Root = *Other.Root;
       AllReferencesAreCached = false;
+      ReadOnlyVersion = 0;
       initializeUncachedReferences();
     }
     return *this;
@@ -109,9 +121,11 @@ public:
     if (Other.get() == nullptr) {
       Root = nullptr;
       AllReferencesAreCached = false;
+      ReadOnlyVersion = 0;
 
       Other.Root.reset();
       Other.AllReferencesAreCached = false;
+      Other.ReadOnlyVersion = 0;
 
       return *this;
     }
@@ -119,9 +133,11 @@ public:
     if (this != &Other) {
       Root = std::move(Other.Root);
       AllReferencesAreCached = Other.AllReferencesAreCached;
+      ReadOnlyVersion = Other.ReadOnlyVersion;
 
       Other.Root.reset();
       Other.AllReferencesAreCached = false;
+      Other.ReadOnlyVersion = 0;
     }
     return *this;
   }
@@ -229,6 +245,7 @@ private:
       Element.evictCachedTarget();
     });
     AllReferencesAreCached = false;
+    ReadOnlyVersion = 0;
   }
 
 public:
@@ -240,8 +257,10 @@ public:
 
   void cacheReferences() {
     DisableTracking Guard(*Root);
-    if (not AllReferencesAreCached)
+    if (not AllReferencesAreCached) {
       visitReferencesInternal([](auto &Element) { Element.cacheTarget(); });
+      ReadOnlyVersion = revng::detail::NextTupleTreeReadOnlyVersion++;
+    }
     AllReferencesAreCached = true;
   }
 
@@ -250,8 +269,16 @@ public:
     if (AllReferencesAreCached)
       visitReferencesInternal([](auto &E) { E.evictCachedTarget(); });
     AllReferencesAreCached = false;
+    ReadOnlyVersion = 0;
   }
 
+  /// While references are cached, the tree cannot be modified. This returns a
+  /// stamp identifying the current read-only period, unique across all the
+  /// TupleTree instances, or 0 if the tree can currently be modified.
+  ///
+  /// It can be used to key caches of data derived from the tree.
+  uint64_t readOnlyVersion() const { return ReadOnlyVersion; }
+
   template<typename Pre, typename Post>
   void visit(Pre PreCallable, Post PostCallable) const {
     using PreVisitor = typename TupleTreeVisitor<T>::template ConstVisitor<Pre>;
@@ -14,6 +14,7 @@
 #include "revng/Model/Binary.h"
 #include "revng/Model/Helpers.h"
 #include "revng/Support/Debug.h"
+#include "revng/Support/Statistics.h"
 #include "revng/Support/YAMLTraits.h"
 #include "revng/TupleTree/NamedEnumScalarTraits.h"
 
@@ -653,6 +654,69 @@ Layout::returnValueRegisters() const {
   return Result;
 }
 
+static CounterMap<std::string> LayoutCacheStatistics("layout-cache");
+
+std::shared_ptr<const Layout>
+LayoutCache::get(const model::TypeDefinition &Prototype,
+                 uint64_t ModelVersion) {
+  revng_assert(ModelVersion != 0);
+  return getImpl(Prototype, ModelVersion);
+}
+
+std::shared_ptr<const Layout>
+LayoutCache::get(const model::TypeDefinition &Prototype) {
+  return getImpl(Prototype, 0);
+}
+
+std::shared_ptr<const Layout>
+LayoutCache::getImpl(const model::TypeDefinition &Prototype,
+                     uint64_t ModelVersion) {
+  {
+    std::lock_guard Lock(Mutex);
+    if (ModelVersion != this->ModelVersion) {
+      Layouts.clear();
+      this->ModelVersion = ModelVersion;
+    }
+
+    auto It = Layouts.find(&Prototype);
+    if (It != Layouts.end()) {
+      LayoutCacheStatistics.push("hits");
+      return It->second;
+    }
+    LayoutCacheStatistics.push("misses");
+  }
+
+  // Compute the layout without holding the lock: in the worst case two threads
+  // will compute the same layout
+  auto Result = std::make_shared<const Layout>(Layout::make(Prototype));
+
+  std::lock_guard Lock(Mutex);
+  if (ModelVersion == this->ModelVersion)
+    Layouts.try_emplace(&Prototype, Result);
+
+  return Result;
+}
+
+std::shared_ptr<const Layout>
+LayoutCache::get(const model::TypeDefinition &Prototype,
+                 const TupleTree<model::Binary> &Model) {
+  if (uint64_t Version = Model.readOnlyVersion(); Version != 0)
+    return get(Prototype, Version);
+
+  return std::make_shared<const Layout>(Layout::make(Prototype));
+}
+
+void LayoutCache::clear() {
+  std::lock_guard Lock(Mutex);
+  Layouts.clear();
+  ModelVersion = 0;
+}
+
+LayoutCache &LayoutCache::shared() {
+  static LayoutCache Instance;
+  return Instance;
+}
+
 uint64_t finalStackOffset(const model::CABIFunctionDefinition &Function) {
   const abi::Definition &ABI = abi::Definition::get(Function.ABI());
   ToRawConverter Helper(ABI);
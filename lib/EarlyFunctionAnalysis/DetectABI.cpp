@@ -60,6 +60,7 @@ enum ABIEnforcementOption {
 };
 
 using ABIOpt = ABIEnforcementOption;
+using abi::FunctionType::LayoutCache;
 static opt<ABIOpt> ABIEnforcement("abi-enforcement-level",
                                   desc("ABI refinement preferences."),
                                   values(clEnumValN(NoABIEnforcement,
@@ -219,7 +220,8 @@ private:
   void propagatePrototypes();
 
   /// Propagate prototypes to callers
-  void propagatePrototypesInFunction(model::Function &Function);
+  void propagatePrototypesInFunction(model::Function &Function,
+                                     LayoutCache &Layouts);
 
 private:
   void recordRegisters(const efa::CSVSet &CSVs, auto Inserter);
@@ -745,13 +747,17 @@ void DetectABI::finalizeModel() {
 }
 
 void DetectABI::propagatePrototypes() {
+  // Prototype definitions are not modified while propagating, their layouts can
+  // be cached throughout the whole loop
+  LayoutCache Layouts;
   for (model::Function &Function : Binary->Functions()) {
-    propagatePrototypesInFunction(Function);
+    propagatePrototypesInFunction(Function, Layouts);
   }
 }
 
 // TODO: is this still necessary after the new EFA?
-void DetectABI::propagatePrototypesInFunction(model::Function &Function) {
+void DetectABI::propagatePrototypesInFunction(model::Function &Function,
+                                              LayoutCache &Layouts) {
   const MetaAddress &Entry = Function.Entry();
 
   revng_log(Log, "Trying to propagate prototypes for " << Entry.toString());
@@ -785,9 +791,8 @@ void DetectABI::propagatePrototypesInFunction(model::Function &Function) {
   if (SuccessorIsCall) {
     auto Prototype = getPrototype(*Binary, Entry, Block, *Call);
 
-    using abi::FunctionType::Layout;
     // Get layout of wrapped function
-    Layout CalleeLayout = Layout::make(*Prototype);
+    auto CalleeLayout = Layouts.get(*Prototype);
 
     // Verify that wrapper function:
     //  - don't write stack pointer
@@ -805,9 +810,9 @@ void DetectABI::propagatePrototypesInFunction(model::Function &Function) {
       auto *CSV = M.getGlobalVariable(model::Register::getName(Argument));
       return WrittenRegisters.count(CSV);
     };
-    const auto &Arguments = CalleeLayout.argumentRegisters();
+    const auto &Arguments = CalleeLayout->argumentRegisters();
     bool WritesCalleeArgs = any_of(Arguments, IsWrittenByCaller);
-    const auto &ReturnValues = CalleeLayout.returnValueRegisters();
+    const auto &ReturnValues = CalleeLayout->returnValueRegisters();
     bool WritesCalleeReturnValues = any_of(ReturnValues, IsWrittenByCaller);
 
     bool WritesToMemory = count_if(*BB, isWritingToMemory) > 0;
@@ -64,6 +64,7 @@ private:
   using FunctionMap = std::map<MetaAddress, FunctionInfo>;
 
 private:
+  const TupleTree<model::Binary> &Model;
   const model::Binary &Binary;
   Function *RootFunction = nullptr;
   Module *M = nullptr;
@@ -72,10 +73,11 @@ private:
   FunctionMap Map;
 
 public:
-  InvokeIsolatedFunctions(const model::Binary &Binary,
+  InvokeIsolatedFunctions(const TupleTree<model::Binary> &Model,
                           Function *RootFunction,
                           GeneratedCodeBasicInfo &GCBI) :
-    Binary(Binary),
+    Model(Model),
+    Binary(*Model),
     RootFunction(RootFunction),
     M(RootFunction->getParent()),
     Context(M->getContext()),
@@ -185,8 +187,9 @@ public:
       SmallVector<Value *, 4> Arguments;
       if (F->getFunctionType()->getNumParams() > 0) {
         auto ThePrototype = Binary.prototypeOrDefault(ModelF->prototype());
-        auto Layout = abi::FunctionType::Layout::make(*ThePrototype);
-        for (const auto &ArgumentLayout : Layout.Arguments) {
+        auto &Cache = abi::FunctionType::LayoutCache::shared();
+        auto Layout = Cache.get(*ThePrototype, Model);
+        for (const auto &ArgumentLayout : Layout->Arguments) {
           for (model::Register::Values Register : ArgumentLayout.Registers) {
             auto Name = model::Register::getCSVName(Register);
             GlobalVariable *CSV = M->getGlobalVariable(Name, true);
@@ -225,8 +228,8 @@ bool InvokeIsolatedFunctionsPass::runOnModule(Module &M) {
 
   auto &GCBI = getAnalysis<GeneratedCodeBasicInfoWrapperPass>().getGCBI();
   const auto &ModelWrapper = getAnalysis<LoadModelWrapperPass>().get();
-  const model::Binary &Binary = *ModelWrapper.getReadOnlyModel();
-  InvokeIsolatedFunctions TheFunction(Binary, M.getFunction("root"), GCBI);
+  const auto &Model = ModelWrapper.getReadOnlyModel();
+  InvokeIsolatedFunctions TheFunction(Model, M.getFunction("root"), GCBI);
   TheFunction.run();
 
   // Commit
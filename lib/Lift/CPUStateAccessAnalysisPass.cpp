@@ -13,14 +13,17 @@
 
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "revng/Support/CommandLine.h"
 #include "revng/Support/Debug.h"
 #include "revng/Support/IRHelpers.h"
 
@@ -47,6 +50,13 @@ static auto CSVAccessLog = Logger<>("cpustate-access-analysis");
 /// Logger for fixing the accesses to CPUState
 static auto FixAccessLog = Logger<>("cpustate-fix-access");
 
+static cl::opt<bool> VerifyHelpersCache("csaa-verify-helpers-cache",
+                                        cl::desc("analyze again the calls to "
+                                                 "helpers whose CSV accesses "
+                                                 "have been memoized and check "
+                                                 "that the results match"),
+                                        cl::cat(MainCategory));
+
 static uint64_t NumUnknown = 0;
 static std::map<std::string, uint64_t> FunToNumUnknown;
 static std::map<std::string, std::set<std::string>> FunToUnknowns;
@@ -937,7 +947,7 @@ template<class T>
 class CRTPOffsetFolder {
 
 protected:
-  using offset_iterator = std::set<int64_t>::const_iterator;
+  using offset_iterator = CSVOffsets::const_iterator;
   using offset_iterator_range = llvm::iterator_range<offset_iterator>;
   using OffsetPair = std::pair<const CSVOffsets *, const CSVOffsets *>;
 
@@ -1126,9 +1136,12 @@ public:
           CartesianSize *= OffsetSize;
         }
 
+        // Collect all the folded offsets and merge them at once, instead of
+        // merging them in the map one by one
+        SmallVector<int64_t, 16> FoldedOffsets;
+        FoldedOffsets.reserve(CartesianSize);
         do {
-          CSVOffsets ResOffset = foldOffsets(ResKind, NumSrcs, I, OffsetsIt);
-          insertOrCombine(V, C, std::move(ResOffset), OffsetMap);
+          FoldedOffsets.push_back(foldOffsets(NumSrcs, I, OffsetsIt));
           // Advance the iterators
           {
             WorkItem::size_type SI = 0;
@@ -1148,16 +1161,20 @@ public:
             revng_log(CSVAccessLog, "incremented");
           }
         } while (--CartesianSize);
+
+        insertOrCombine(V,
+                        C,
+                        CSVOffsets::fromUnsorted(ResKind, FoldedOffsets),
+                        OffsetMap);
       }
     }
   }
 
 private:
-  CSVOffsets foldOffsets(CSVOffsets::Kind ResKind,
-                         WorkItem::size_type NumSrcs,
-                         Instruction *I,
-                         const SmallVector<offset_iterator, 4> &OffsetsIt) {
-    return static_cast<T *>(this)->foldOffsets(ResKind, NumSrcs, I, OffsetsIt);
+  int64_t foldOffsets(WorkItem::size_type NumSrcs,
+                      Instruction *I,
+                      const SmallVector<offset_iterator, 4> &OffsetsIt) {
+    return static_cast<T *>(this)->foldOffsets(NumSrcs, I, OffsetsIt);
   }
 };
 
@@ -1209,10 +1226,9 @@ private:
     revng_abort();
   }
 
-  CSVOffsets foldOffsets(CSVOffsets::Kind ResultKind,
-                         WorkItem::size_type NumSrcs,
-                         Instruction *I,
-                         const SmallVector<offset_iterator, 4> &OffsetsIt) {
+  int64_t foldOffsets(WorkItem::size_type NumSrcs,
+                      Instruction *I,
+                      const SmallVector<offset_iterator, 4> &OffsetsIt) {
     auto OpCode = I->getOpcode();
     revng_assert(OpCode == Instruction::Add or OpCode == Instruction::Sub);
     SmallVector<Constant *, 4> Operands(NumSrcs, nullptr);
@@ -1226,7 +1242,7 @@ private:
     Constant *Res = ConstantFoldInstOperands(I, TmpOp, DL);
     ConstantInt *R = cast<ConstantInt>(Res);
     const int64_t ResO = R->getSExtValue();
-    return CSVOffsets(ResultKind, ResO);
+    return ResO;
   }
 };
 
@@ -1274,7 +1290,7 @@ private:
           auto IdxIt = GEP->idx_begin();
           auto IdxEnd = GEP->idx_end();
           int IdxOpNum = 1;
-          std::set<int64_t> LastTypeOffsets = { 0 };
+          CSVOffsets LastTypeOffsets(CSVOffsets::Kind::Numeric, 0);
 
           for (; IdxIt != IdxEnd; ++IdxIt, ++IdxOpNum) {
             const CSVOffsets *IdxCSVOffset = OffsetTuple[IdxOpNum];
@@ -1285,8 +1301,7 @@ private:
             if (ElementTy->isAggregateType()) {
               if (ElementTy->isArrayTy()) {
                 if (IdxCSVOffset->isUnknown()) {
-                  CSVOffsets U(CSVOffsets::Kind::Numeric, LastTypeOffsets);
-                  UpdatedOffsetTuple[IdxOpNum] = std::move(U);
+                  UpdatedOffsetTuple[IdxOpNum] = LastTypeOffsets;
                 } else {
                   // If it's not Unknown we can leave it like it is.
                 }
@@ -1294,9 +1309,8 @@ private:
                 auto *ArrayTy = cast<ArrayType>(ElementTy);
                 uint64_t ArrayNumElem = ArrayTy->getNumElements();
                 revng_assert(ArrayNumElem);
-                LastTypeOffsets.clear();
-                for (uint64_t O = 0; O < ArrayNumElem; ++O)
-                  LastTypeOffsets.insert(O);
+                CSVOffsets::Kind K = CSVOffsets::Kind::Numeric;
+                LastTypeOffsets = CSVOffsets::makeRange(K, 0, ArrayNumElem);
 
                 ConstIdxList.push_back(0);
               } else if (ElementTy->isStructTy()) {
@@ -1307,8 +1321,7 @@ private:
                     return { false, CSVOffsets::makeUnknown(GEPOp0Kind) };
                   } else {
                     revng_assert(not LastTypeOffsets.empty());
-                    CSVOffsets U(CSVOffsets::Kind::Numeric, LastTypeOffsets);
-                    UpdatedOffsetTuple[IdxOpNum] = std::move(U);
+                    UpdatedOffsetTuple[IdxOpNum] = LastTypeOffsets;
                     break;
                   }
                 } else {
@@ -1317,9 +1330,7 @@ private:
                   ConstIdxList.push_back(*IdxCSVOffset->begin());
 
                   revng_assert(IdxCSVOffset->size() != 0);
-                  LastTypeOffsets.clear();
-                  LastTypeOffsets.insert(IdxCSVOffset->begin(),
-                                         IdxCSVOffset->end());
+                  LastTypeOffsets = *IdxCSVOffset;
                 }
               } else {
                 revng_abort();
@@ -1328,8 +1339,7 @@ private:
               // I'm done.
               revng_assert(IdxIt + 1 == IdxEnd);
               if (IdxCSVOffset->isUnknown()) {
-                CSVOffsets U(CSVOffsets::Kind::Numeric, LastTypeOffsets);
-                UpdatedOffsetTuple[IdxOpNum] = std::move(U);
+                UpdatedOffsetTuple[IdxOpNum] = LastTypeOffsets;
               } else {
                 // If it's not Unknown we can leave it like it is.
               }
@@ -1359,10 +1369,9 @@ private:
     return { true, GEPOp0Kind };
   }
 
-  CSVOffsets foldOffsets(CSVOffsets::Kind ResultKind,
-                         WorkItem::size_type NumSrcs,
-                         Instruction *I,
-                         const SmallVector<offset_iterator, 4> &OffsetsIt) {
+  int64_t foldOffsets(WorkItem::size_type NumSrcs,
+                      Instruction *I,
+                      const SmallVector<offset_iterator, 4> &OffsetsIt) {
     const auto *GEP = cast<const GetElementPtrInst>(I);
     const auto PtrOpTy = GEP->getPointerOperand()->getType();
     SmallVector<Constant *, 4> Operands(NumSrcs, nullptr);
@@ -1378,7 +1387,7 @@ private:
     Constant *Res = ConstantFoldInstOperands(I, TmpOp, DL);
     ConstantInt *R = getConstValue(Res, DL);
     const int64_t ResO = getSExtValue(R, DL);
-    return CSVOffsets(ResultKind, ResO);
+    return ResO;
   }
 };
 
@@ -1414,10 +1423,9 @@ private:
     }
   }
 
-  CSVOffsets foldOffsets(CSVOffsets::Kind ResultKind,
-                         WorkItem::size_type NumSrcs,
-                         Instruction *I,
-                         const SmallVector<offset_iterator, 4> &OffsetsIt) {
+  int64_t foldOffsets(WorkItem::size_type NumSrcs,
+                      Instruction *I,
+                      const SmallVector<offset_iterator, 4> &OffsetsIt) {
 
     auto OpCode = I->getOpcode();
     revng_assert(OpCode == Instruction::Shl or OpCode == Instruction::AShr
@@ -1436,7 +1444,7 @@ private:
     Constant *Res = ConstantFoldInstOperands(I, TmpOp, DL);
     ConstantInt *R = cast<ConstantInt>(Res);
     const int64_t ResO = R->getSExtValue();
-    return CSVOffsets(ResultKind, ResO);
+    return ResO;
   }
 };
 
@@ -2305,7 +2313,7 @@ void CPUSAOA::computeAggregatedOffsets() {
           New = O;
         } else {
           revng_assert(O.size());
-          std::set<int64_t> FineGrainedOffsets;
+          SmallVector<int64_t, 8> FineGrainedOffsets;
           // Now compute the fine-grained offsets
           for (const int64_t Coarse : O) {
             int64_t Refined = Coarse;
@@ -2320,7 +2328,7 @@ void CPUSAOA::computeAggregatedOffsets() {
                 Type *AccessedTy = AccessedVar->getValueType();
                 SizeAtOffset = DL.getTypeAllocSize(AccessedTy) - InternalOffset;
                 revng_assert(SizeAtOffset > 0);
-                FineGrainedOffsets.insert(Refined - InternalOffset);
+                FineGrainedOffsets.push_back(Refined - InternalOffset);
                 CSVAccessLog << "Value: " << I << DoLog;
                 CSVAccessLog << "Insert Refined: " << Refined << DoLog;
               } else {
@@ -2331,7 +2339,7 @@ void CPUSAOA::computeAggregatedOffsets() {
               Refined += SizeAtOffset;
             }
           }
-          New = CSVOffsets(O.getKind(), FineGrainedOffsets);
+          New = CSVOffsets::fromUnsorted(O.getKind(), FineGrainedOffsets);
         }
         // Finally insert them or combine them
         CallSiteOffsetMap::iterator CallOffsetIt;
@@ -3073,6 +3081,9 @@ private:
   const unsigned LoadMDKind;
   const unsigned StoreMDKind;
 
+  // Results of the previous lazy runs, might be nullptr
+  HelperCSVAccessCache *HelpersCache = nullptr;
+
   // Helpers
   const DataLayout &DL;
   Type *Int64Ty = nullptr;
@@ -3081,7 +3092,8 @@ private:
 public:
   CPUStateAccessAnalysis(const Module &Mod,
                          VariableManager *V,
-                         const bool IsLazy) :
+                         const bool IsLazy,
+                         HelperCSVAccessCache *Cache) :
     Lazy(IsLazy),
     M(Mod),
     Variables(V),
@@ -3089,6 +3101,7 @@ public:
     CSVStoreOffsetMap(),
     LoadMDKind(Mod.getContext().getMDKindID("revng.csvaccess.offsets.load")),
     StoreMDKind(Mod.getContext().getMDKindID("revng.csvaccess.offsets.store")),
+    HelpersCache(Cache),
     DL(Mod.getDataLayout()),
     Int64Ty(llvm::IntegerType::getInt64Ty(Mod.getContext())),
     CPUStatePtr(Mod.getGlobalVariable("env")) {}
@@ -3097,9 +3110,32 @@ public:
   bool run();
 
 private:
+  bool analyze();
   void forceEmptyMetadata(Function *RootFunction) const;
+
+  using CacheKey = HelperCSVAccessCache::Key;
+  using PendingCall = std::pair<CallInst *, CacheKey>;
+  bool isDecorated(const CallInst *Call) const;
+  bool isEnv(const Value *V) const;
+  optional<CacheKey> getCacheKey(const CallInst *Call) const;
+  bool decorateFromCache(Function *RootFunction,
+                         std::vector<PendingCall> &Pending,
+                         bool &FoundAccesses) const;
 };
 
+/// \return true if \p AccessMetadata, as produced by addAccessMetadata,
+///         describes at least one (possibly unknown) access to the CSVs
+static bool hasAccesses(const MDNode *AccessMetadata) {
+  if (AccessMetadata == nullptr)
+    return false;
+
+  QuickMetadata QMD(AccessMetadata->getContext());
+  auto *Tuple = cast<MDTuple>(AccessMetadata);
+  auto *Variables = cast<MDTuple>(Tuple->getOperand(1).get());
+  bool Unknown = QMD.extract<uint32_t>(Tuple, 0) != 0;
+  return Unknown or Variables->getNumOperands() > 0;
+}
+
 static void addAccessMetadata(const CallSiteOffsetMap &OffsetMap,
                               VariableManager *Variables,
                               QuickMetadata &QMD,
@@ -3163,11 +3199,129 @@ void CPUStateAccessAnalysis::forceEmptyMetadata(Function *RootFunction) const {
   }
 }
 
-bool CPUStateAccessAnalysis::run() {
+bool CPUStateAccessAnalysis::isDecorated(const CallInst *Call) const {
+  return Call->getMetadata(LoadMDKind) != nullptr
+         or Call->getMetadata(StoreMDKind) != nullptr;
+}
+
+bool CPUStateAccessAnalysis::isEnv(const Value *V) const {
+  auto *Load = dyn_cast<LoadInst>(V->stripPointerCasts());
+  return Load != nullptr
+         and Load->getPointerOperand()->stripPointerCasts() == CPUStatePtr;
+}
+
+optional<HelperCSVAccessCache::Key>
+CPUStateAccessAnalysis::getCacheKey(const CallInst *Call) const {
+  const Function *Callee = getCallee(Call);
+  if (Callee == nullptr or not isHelper(Callee) or Callee->isDeclaration())
+    return std::nullopt;
+
+  CacheKey Result;
+  Result.first = Callee;
+  for (const Value *Argument : Call->args()) {
+    if (isa<ConstantData>(Argument))
+      Result.second.push_back(Argument);
+    else if (isEnv(Argument))
+      Result.second.push_back(CPUStatePtr);
+    else
+      return std::nullopt;
+  }
+
+  return Result;
+}
+
+/// Decorate the calls in \p RootFunction whose accesses have been memoized and
+/// collect in \p Pending the ones that could be memoized after the analysis
+///
+/// \p FoundAccesses is set to true if any of the memoized calls accesses the
+/// CSVs.
+///
+/// \return true if the module needs to be analyzed, i.e., if there are calls
+///         that might access the CSVs which are not decorated yet.
+bool CPUStateAccessAnalysis::decorateFromCache(Function *RootFunction,
+                                               std::vector<PendingCall>
+                                                 &Pending,
+                                               bool &FoundAccesses) const {
+  bool NeedsAnalysis = false;
+  FoundAccesses = false;
+  for (Instruction &I : instructions(RootFunction)) {
+    auto *Call = dyn_cast<CallInst>(&I);
+    if (Call == nullptr or isDecorated(Call))
+      continue;
+
+    optional<CacheKey> Key = getCacheKey(Call);
+    if (not Key) {
+      // Calls to functions without a body can only be relevant if they
+      // receive `env`
+      const Function *Callee = getCallee(Call);
+      if (Callee == nullptr or not Callee->isDeclaration()
+          or llvm::any_of(Call->args(),
+                          [this](const Value *V) { return isEnv(V); }))
+        NeedsAnalysis = true;
+      continue;
+    }
+
+    const auto *Cached = HelpersCache->get(*Key);
+    if (Cached == nullptr or VerifyHelpersCache) {
+      NeedsAnalysis = true;
+      Pending.emplace_back(Call, std::move(*Key));
+      continue;
+    }
+
+    Call->setMetadata(LoadMDKind, Cached->first);
+    Call->setMetadata(StoreMDKind, Cached->second);
+    if (hasAccesses(Cached->first) or hasAccesses(Cached->second))
+      FoundAccesses = true;
+  }
 
+  return NeedsAnalysis;
+}
+
+bool CPUStateAccessAnalysis::run() {
   if (CPUStatePtr == nullptr)
     return false;
 
+  if (not Lazy or HelpersCache == nullptr)
+    return analyze();
+
+  Function *RootFunction = M.getFunction("root");
+  revng_assert(RootFunction);
+
+  std::vector<PendingCall> Pending;
+  bool FoundAccesses = false;
+  if (not decorateFromCache(RootFunction, Pending, FoundAccesses)) {
+    revng_log(CSVAccessLog, "All the calls to helpers have been memoized");
+
+    // Calls to helpers that do not receive env have not been decorated, do
+    // it as analyze() would
+    forceEmptyMetadata(RootFunction);
+    return FoundAccesses;
+  }
+
+  bool Result = analyze();
+
+  for (auto &[Call, Key] : Pending) {
+    HelperCSVAccessCache::AccessMetadata
+      Computed = { Call->getMetadata(LoadMDKind),
+                   Call->getMetadata(StoreMDKind) };
+    revng_assert(Computed.first != nullptr and Computed.second != nullptr);
+
+    if (VerifyHelpersCache) {
+      const auto *Cached = HelpersCache->get(Key);
+      if (Cached != nullptr) {
+        revng_check(*Cached == Computed,
+                    "Memoized CSV accesses of an helper do not match");
+      }
+    }
+
+    HelpersCache->record(std::move(Key), Computed);
+  }
+
+  return Result;
+}
+
+bool CPUStateAccessAnalysis::analyze() {
+
   // Get the root Function
   Function *RootFunction = M.getFunction("root");
   revng_assert(RootFunction);
@@ -3258,7 +3412,7 @@ bool CPUStateAccessAnalysis::run() {
 }
 
 bool CPUStateAccessAnalysisPass::runOnModule(Module &Mod) {
-  CPUStateAccessAnalysis AccessAnalysis(Mod, Variables, Lazy);
+  CPUStateAccessAnalysis AccessAnalysis(Mod, Variables, Lazy, HelpersCache);
   return AccessAnalysis.run();
 }
 
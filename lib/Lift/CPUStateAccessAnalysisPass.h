@@ -6,6 +6,8 @@
 
 #include <map>
 #include <ostream>
+#include <utility>
+#include <vector>
 
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
@@ -15,11 +17,46 @@
 #include "CSVOffsets.h"
 
 namespace llvm {
+class Function;
 class Instruction;
-}
+class MDNode;
+class Value;
+} // namespace llvm
 
 class VariableManager;
 
+/// Memoizes the results of the lazy runs of CPUStateAccessAnalysisPass
+///
+/// The CSVs accessed by a call to an helper whose arguments are all constants
+/// or `env` only depend on the helper and on the value of the constants. Since
+/// the body of the helpers does not change until the final, non-lazy, run, such
+/// results can be reused for new calls with the same arguments in later lazy
+/// runs, skipping the analysis of the helper entirely.
+class HelperCSVAccessCache {
+public:
+  /// The helper and its arguments, either a constant or `env`
+  using Key = std::pair<const llvm::Function *,
+                        std::vector<const llvm::Value *>>;
+
+  /// The load and store metadata attached to the calls
+  using AccessMetadata = std::pair<llvm::MDNode *, llvm::MDNode *>;
+
+private:
+  std::map<Key, AccessMetadata> Cache;
+
+public:
+  const AccessMetadata *get(const Key &K) const {
+    auto It = Cache.find(K);
+    return It == Cache.end() ? nullptr : &It->second;
+  }
+
+  void record(Key &&K, AccessMetadata Metadata) {
+    Cache.try_emplace(std::move(K), Metadata);
+  }
+
+  size_t size() const { return Cache.size(); }
+};
+
 /// LLVM pass to analyze the access patterns to the CPU State Variable
 class CPUStateAccessAnalysisPass : public llvm::ModulePass {
 public:
@@ -28,6 +65,7 @@ public:
 private:
   const bool Lazy;
   VariableManager *Variables = nullptr;
+  HelperCSVAccessCache *HelpersCache = nullptr;
 
 public:
   static char ID;
@@ -36,8 +74,10 @@ public:
   CPUStateAccessAnalysisPass() :
     llvm::ModulePass(ID), Lazy(false), Variables(nullptr){};
 
-  CPUStateAccessAnalysisPass(VariableManager *VM, bool IsLazy = false) :
-    llvm::ModulePass(ID), Lazy(IsLazy), Variables(VM){};
+  CPUStateAccessAnalysisPass(VariableManager *VM,
+                             bool IsLazy = false,
+                             HelperCSVAccessCache *Cache = nullptr) :
+    llvm::ModulePass(ID), Lazy(IsLazy), Variables(VM), HelpersCache(Cache){};
 
 public:
   virtual bool runOnModule(llvm::Module &TheModule) override;
@@ -4,7 +4,11 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
-#include <set>
+#include <algorithm>
+#include <iterator>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 
 #include "revng/Support/Assert.h"
 
@@ -13,10 +17,14 @@ class Logger;
 
 /// Different types of accesses to the CPU State Variables (CSVs), with a set of
 /// possible offsets.
+///
+/// The offsets are kept in a sorted vector without duplicates: the sets are
+/// small, built in bulk and then mostly iterated and merged, which a flat
+/// representation handles much better than a node-based one.
 class CSVOffsets {
 
 private:
-  using OffsetSet = std::set<int64_t>;
+  using OffsetSet = llvm::SmallVector<int64_t, 4>;
 
 public:
   using iterator = OffsetSet::iterator;
@@ -66,9 +74,26 @@ public:
     // Useful for debug revng_assert(not isUnknown(K) and not
     // isUnknownInPtr(K));
   }
-  CSVOffsets(Kind K, std::set<int64_t> O) : OffsetKind(K), Offsets(O) {
-    // Useful for debug revng_assert(not isUnknown(K) and not
-    // isUnknownInPtr(K));
+  /// Build a CSVOffsets from offsets in any order, possibly with duplicates
+  template<typename RangeT>
+  static CSVOffsets fromUnsorted(Kind K, const RangeT &O) {
+    CSVOffsets Result(K);
+    Result.Offsets.assign(std::begin(O), std::end(O));
+    llvm::sort(Result.Offsets);
+    Result.Offsets.erase(std::unique(Result.Offsets.begin(),
+                                     Result.Offsets.end()),
+                         Result.Offsets.end());
+    return Result;
+  }
+
+  /// Build a CSVOffsets containing all the offsets in [\p Begin, \p End)
+  static CSVOffsets makeRange(Kind K, int64_t Begin, int64_t End) {
+    revng_assert(Begin <= End);
+    CSVOffsets Result(K);
+    Result.Offsets.reserve(End - Begin);
+    for (int64_t O = Begin; O < End; ++O)
+      Result.Offsets.push_back(O);
+    return Result;
   }
 
 public:
@@ -81,8 +106,8 @@ public:
   iterator begin() { return Offsets.begin(); }
   iterator end() { return Offsets.end(); }
 
-  const_iterator begin() const { return Offsets.cbegin(); }
-  const_iterator end() const { return Offsets.cend(); }
+  const_iterator begin() const { return Offsets.begin(); }
+  const_iterator end() const { return Offsets.end(); }
 
   size_type size() const { return Offsets.size(); }
   size_type empty() const { return Offsets.empty(); }
@@ -139,20 +164,48 @@ public:
     return K;
   }
 
-  void insert(int64_t O) { Offsets.insert(O); }
+  void insert(int64_t O) {
+    auto It = llvm::lower_bound(Offsets, O);
+    if (It == Offsets.end() or *It != O)
+      Offsets.insert(It, O);
+  }
+
+private:
+  /// Merge the offsets of \p Other into this, keeping them sorted and unique
+  void mergeOffsets(const CSVOffsets &Other) {
+    if (Other.Offsets.empty())
+      return;
+
+    // Fast path: the offsets of Other all come after ours
+    if (Offsets.empty() or Offsets.back() < Other.Offsets.front()) {
+      Offsets.append(Other.Offsets.begin(), Other.Offsets.end());
+      return;
+    }
+
+    OffsetSet Merged;
+    Merged.reserve(Offsets.size() + Other.Offsets.size());
+    std::set_union(Offsets.begin(),
+                   Offsets.end(),
+                   Other.Offsets.begin(),
+                   Other.Offsets.end(),
+                   std::back_inserter(Merged));
+    Offsets = std::move(Merged);
+  }
+
+public:
   void combine(const CSVOffsets &Other) {
     Kind K0 = OffsetKind;
     Kind K1 = Other.OffsetKind;
     // For equal kinds just merge the offsets
     if (K0 == K1) {
-      Offsets.insert(Other.Offsets.begin(), Other.Offsets.end());
+      mergeOffsets(Other);
       return;
     }
 
     // If one is OutAndUnknownInPtr always return OutAndUnknownInPtr
     if (K0 == Kind::OutAndUnknownInPtr or K1 == Kind::OutAndUnknownInPtr) {
       OffsetKind = Kind::OutAndUnknownInPtr;
-      Offsets = {};
+      Offsets.clear();
       return;
     }
 
@@ -165,7 +218,7 @@ public:
       else
         OffsetKind = Kind::OutAndUnknownInPtr;
 
-      Offsets = {};
+      Offsets.clear();
       return;
     }
 
@@ -174,10 +227,10 @@ public:
       // Offsets
       if (isUnknown(K0) or isUnknown(K1)) {
         OffsetKind = Kind::OutAndUnknownInPtr;
-        Offsets = {};
+        Offsets.clear();
       } else {
         OffsetKind = Kind::OutAndKnownInPtr;
-        Offsets.insert(Other.Offsets.begin(), Other.Offsets.end());
+        mergeOffsets(Other);
       }
       return;
     }
@@ -196,6 +249,6 @@ public:
     revng_assert((isNumeric(K0) and isUnknown(K1))
                  or (isNumeric(K1) and isUnknown(K0)));
     OffsetKind = Kind::Unknown;
-    Offsets = {};
+    Offsets.clear();
   }
 };
@@ -48,6 +48,7 @@
 #include "revng/Support/Debug.h"
 #include "revng/Support/FunctionTags.h"
 #include "revng/Support/ProgramCounterHandler.h"
+#include "revng/Support/Statistics.h"
 
 #include "CodeGenerator.h"
 #include "ExternalJumpsHandler.h"
@@ -69,6 +70,8 @@ static cl::opt<bool> RecordPTC("record-ptc",
 static Logger<> PTCLog("ptc");
 static Logger<> Log("lift");
 
+static CounterMap<std::string> PTCStatistics("ptc-translations");
+
 template<typename T, typename... ArgTypes>
 inline std::array<T, sizeof...(ArgTypes)> make_array(ArgTypes &&...Args) {
   return { { std::forward<ArgTypes>(Args)... } };
@@ -727,8 +730,11 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
                             TargetIsLittleEndian,
                             CPUStruct,
                             ptc.env_offset);
-  auto CreateCPUStateAccessAnalysisPass = [&Variables]() {
-    return new CPUStateAccessAnalysisPass(&Variables, true);
+  HelperCSVAccessCache HelpersCSVAccesses;
+  auto CreateCPUStateAccessAnalysisPass = [&Variables, &HelpersCSVAccesses]() {
+    return new CPUStateAccessAnalysisPass(&Variables,
+                                          true,
+                                          &HelpersCSVAccesses);
   };
 
   {
@@ -872,6 +878,10 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
 
   std::tie(VirtualAddress, Entry) = JumpTargets.peek();
 
+  // Addresses decoded so far, to measure how often we decode again the same
+  // code, e.g., after a translation has been purged
+  std::set<std::pair<MetaAddress, PTCCodeType>> Decoded;
+
   while (Entry != nullptr) {
     LiftTask.advance(VirtualAddress.toString(), true);
 
@@ -907,6 +917,11 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
                                  Type,
                                  InstructionList.get());
 
+    PTCStatistics.push("translations");
+    PTCStatistics.push("decoded-bytes", ConsumedSize);
+    if (not Decoded.emplace(VirtualAddress, Type).second)
+      PTCStatistics.push("retranslations");
+
     if (ConsumedSize == 0) {
       Translator.emitNewPCCall(Builder, VirtualAddress, 1, nullptr);
       Builder.CreateCall(AbortFunction);
@@ -951,11 +966,10 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
     using IT = InstructionTranslator;
     IT::TranslationResult Result;
 
+    // Note: we don't track progress at the granularity of PTC instructions,
+    //       notifying the listeners would cost as much as translating them.
     TranslateTask.advance("Translate to LLVM IR", true);
 
-    Task TranslateToLLVMTask(InstructionCount + 1, "Translate to LLVM IR");
-    TranslateToLLVMTask.advance("", true);
-
     // Handle the first PTC_INSTRUCTION_op_debug_insn_start
     {
       PTCInstruction *NextInstruction = nullptr;
@@ -989,7 +1003,6 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
 
     // TODO: shall we move this whole loop in InstructionTranslator?
     for (; J < InstructionCount && !StopTranslation; J++) {
-      TranslateToLLVMTask.advance("", true);
       if (ToIgnore.contains(J))
         continue;
 
@@ -1066,7 +1079,9 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
         dumpInstruction(PTCStringStream, InstructionList.get(), J);
         std::string PTCString = PTCStringStream.str() + "\n";
         MDString *MDPTCString = MDString::get(Context, PTCString);
-        MDPTCInstr = MDNode::getDistinct(Context, MDPTCString);
+        // Uniqued rather than distinct: distinct nodes are duplicated each
+        // time a module is cloned
+        MDPTCInstr = MDNode::get(Context, MDPTCString);
       }
 
       // Set metadata for all the new instructions
@@ -1082,8 +1097,6 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
 
     } // End loop over instructions
 
-    TranslateToLLVMTask.complete();
-
     TranslateTask.advance("Finalization", true);
 
     // We might have a leftover block, probably due to the block created after
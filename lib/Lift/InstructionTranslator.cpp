@@ -648,17 +648,18 @@ IT::newInstruction(PTCInstruction *Instr,
   if (RecordASM) {
     std::stringstream OriginalStringStream;
     revng_assert(NextPC - PC);
-    disassemble(OriginalStringStream, PC, *(NextPC - PC));
+    uint64_t Size = *(NextPC - PC);
+    disassemble(OriginalStringStream, PC, Size);
     std::string OriginalString = OriginalStringStream.str();
 
-    // We don't deduplicate this string since performing a lookup each time is
-    // increasingly expensive and we should have relatively few collisions
-    std::string AddressName = JumpTargets.nameForAddress(PC);
+    // The disassembled text is referenced only by the newpc call, `oi` only
+    // records the address and the size of the original instruction. See
+    // OriginalAssemblyIndex.
     String = getUniqueString(&TheModule, OriginalString);
 
-    auto *MDOriginalString = ConstantAsMetadata::get(String);
     auto *MDPC = ConstantAsMetadata::get(PC.toValue(&TheModule));
-    MDOriginalInstr = MDNode::get(Context, { MDOriginalString, MDPC });
+    auto *MDSize = ConstantAsMetadata::get(Builder.getInt64(Size));
+    MDOriginalInstr = MDNode::get(Context, { MDPC, MDSize });
   } else {
     String = ConstantPointerNull::get(Int8PtrTy);
   }
@@ -495,7 +495,7 @@ void JumpTargetManager::harvestGlobalData() {
 
   revng_log(JTCountLog,
             "JumpTargets found in global data: " << std::dec
-                                                 << Unexplored.size());
+                                                 << UnexploredBlocks.size());
 }
 
 template<typename value_type, unsigned endian>
@@ -548,25 +548,22 @@ BasicBlock *JumpTargetManager::newPC(MetaAddress PC, bool &ShouldContinue) {
   auto JTIt = JumpTargets.find(PC);
   if (JTIt != JumpTargets.end()) {
     // If it was planned to explore it in the future, just to do it now
-    for (auto UnexploredIt = Unexplored.begin();
-         UnexploredIt != Unexplored.end();
-         UnexploredIt++) {
-
-      if (UnexploredIt->first == PC) {
-        BasicBlock *Result = UnexploredIt->second;
-
-        // Check if we already have a translation for that
-        ShouldContinue = Result->empty();
-        if (ShouldContinue) {
-          // We don't, OK let's explore it next
-          Unexplored.erase(UnexploredIt);
-        } else {
-          // We do, it will be purged at the next `peek`
-          revng_assert(ToPurge.contains(Result));
-        }
-
-        return Result;
+    auto UnexploredIt = UnexploredBlocks.find(PC);
+    if (UnexploredIt != UnexploredBlocks.end()) {
+      BasicBlock *Result = UnexploredIt->second;
+
+      // Check if we already have a translation for that
+      ShouldContinue = Result->empty();
+      if (ShouldContinue) {
+        // We don't, OK let's explore it next. Its entry in Unexplored will be
+        // skipped by `peek`.
+        UnexploredBlocks.erase(UnexploredIt);
+      } else {
+        // We do, it will be purged at the next `peek`
+        revng_assert(ToPurge.contains(Result));
       }
+
+      return Result;
     }
 
     // It wasn't planned to visit it, so we've already been there, just jump
@@ -778,20 +775,30 @@ JumpTargetManager::BlockWithAddress JumpTargetManager::peek() {
   // If we just harvested new branches, keep exploring
   do {
     harvest();
-  } while (Unexplored.empty() and NewBranches != 0);
+  } while (UnexploredBlocks.empty() and NewBranches != 0);
 
   // Purge all the partial translations we know might be wrong
   for (BasicBlock *BB : ToPurge)
     purgeTranslation(BB);
   ToPurge.clear();
 
-  if (Unexplored.empty()) {
+  if (UnexploredBlocks.empty()) {
     revng_log(JTCountLog, "We're done looking for jump targets");
+    Unexplored.clear();
     return NoMoreTargets;
-  } else {
+  }
+
+  // Skip the entries that have been explored in the meantime
+  while (true) {
+    revng_assert(not Unexplored.empty());
     BlockWithAddress Result = Unexplored.back();
     Unexplored.pop_back();
-    return Result;
+
+    auto It = UnexploredBlocks.find(Result.first);
+    if (It != UnexploredBlocks.end() and It->second == Result.second) {
+      UnexploredBlocks.erase(It);
+      return Result;
+    }
   }
 }
 
@@ -912,6 +919,7 @@ BasicBlock *JumpTargetManager::registerJT(MetaAddress PC,
   }
 
   Unexplored.push_back(BlockWithAddress(PC, NewBlock));
+  UnexploredBlocks[PC] = NewBlock;
 
   std::stringstream Name;
   Name << "bb." << nameForAddress(PC);
@@ -1264,7 +1272,8 @@ void JumpTargetManager::harvest() {
     setCFGForm(CFGForm::SemanticPreserving);
 
     if (JTCountLog.isEnabled()) {
-      JTCountLog << std::dec << Unexplored.size() << " new jump targets and "
+      JTCountLog << std::dec << UnexploredBlocks.size()
+                 << " new jump targets and "
                  << NewBranches << " new branches were found" << DoLog;
     }
   }
@@ -271,7 +271,7 @@ public:
   BlockWithAddress peek();
 
   /// Return true if no unexplored jump targets are available
-  bool empty() { return Unexplored.empty(); }
+  bool empty() { return UnexploredBlocks.empty(); }
 
   /// Return true if the whole [\p Start,\p End) range is in an executable
   /// segment
@@ -588,7 +588,12 @@ private:
   /// Holds the association between a PC and a BasicBlock.
   BlockMap JumpTargets;
   /// Queue of program counters we still have to translate.
+  ///
+  /// \note Entries not in UnexploredBlocks have already been translated and
+  ///       are skipped.
   std::vector<BlockWithAddress> Unexplored;
+  /// The program counters we still have to translate, by address.
+  std::map<MetaAddress, llvm::BasicBlock *> UnexploredBlocks;
 
   llvm::Function *ExitTB;
   MetaAddressRangeSet ExecutableRanges;
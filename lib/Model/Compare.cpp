@@ -0,0 +1,634 @@
+/// \file Compare.cpp
+/// Structural comparison of YAML documents.
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLParser.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Model/Compare.h"
+
+using namespace llvm;
+
+namespace {
+
+using Index = uint32_t;
+static constexpr Index None = std::numeric_limits<Index>::max();
+
+/// A scalar, along with the type it would be loaded as by a YAML 1.1 loader
+struct Scalar {
+  enum TypeKind : uint8_t {
+    String,
+    Integer,
+    Float,
+    Boolean,
+    Null
+  };
+
+  TypeKind Type = Null;
+  std::string Value;
+
+  bool operator==(const Scalar &Other) const = default;
+
+  bool isString() const { return Type == String; }
+
+  std::string toKey() const { return std::string(1, 'a' + Type) + Value; }
+};
+
+struct Node {
+  enum KindType : uint8_t {
+    ScalarNode,
+    MappingNode,
+    SequenceNode
+  };
+
+  KindType Kind = ScalarNode;
+  Scalar Value;
+  std::vector<std::pair<std::string, Index>> Entries;
+  std::vector<Index> Elements;
+
+  /// Scalar entries relevant for the comparison, sorted by key
+  std::vector<std::pair<std::string, Scalar>> Filtered;
+
+  struct Edge {
+    std::string Label;
+    Index Target;
+  };
+  std::vector<Edge> Edges;
+
+  bool isContainer() const { return Kind != ScalarNode; }
+
+  size_t size() const {
+    return Kind == MappingNode ? Entries.size() : Elements.size();
+  }
+
+  const Scalar *findFiltered(StringRef Key) const {
+    auto It = llvm::partition_point(Filtered, [Key](const auto &Entry) {
+      return StringRef(Entry.first) < Key;
+    });
+    if (It == Filtered.end() or It->first != Key)
+      return nullptr;
+    return &It->second;
+  }
+
+  std::optional<Index> findEntry(StringRef Key) const {
+    for (const auto &[EntryKey, Child] : Entries)
+      if (EntryKey == Key)
+        return Child;
+    return std::nullopt;
+  }
+};
+
+static bool isReference(const Scalar &Value) {
+  return Value.isString()
+         and StringRef(Value.Value).startswith("/TypeDefinitions/");
+}
+
+static Scalar normalizePlainScalar(StringRef Value) {
+  static const StringSet<> Nulls = { "", "~", "null", "Null", "NULL" };
+  static const StringSet<> Trues = { "yes", "Yes", "YES", "true", "True",
+                                     "TRUE", "on",  "On",  "ON" };
+  static const StringSet<> Falses = { "no",    "No",    "NO",
+                                      "false", "False", "FALSE",
+                                      "off",   "Off",   "OFF" };
+
+  if (Nulls.contains(Value))
+    return { Scalar::Null, "" };
+  if (Trues.contains(Value))
+    return { Scalar::Boolean, "true" };
+  if (Falses.contains(Value))
+    return { Scalar::Boolean, "false" };
+
+  // Integers, in any of the bases supported by YAML 1.1
+  std::string Digits = Value.str();
+  llvm::erase_value(Digits, '_');
+  StringRef Number = Digits;
+  bool Negative = Number.consume_front("-");
+  if (not Negative)
+    Number.consume_front("+");
+
+  unsigned Radix = 10;
+  if (Number.consume_front("0x"))
+    Radix = 16;
+  else if (Number.consume_front("0b"))
+    Radix = 2;
+  else if (Number.size() > 1 and Number.startswith("0"))
+    Radix = 8;
+
+  APInt Integer;
+  if (not Number.empty() and not Number.getAsInteger(Radix, Integer)) {
+    SmallString<32> Result;
+    if (Negative)
+      Result.push_back('-');
+    Integer.toStringUnsigned(Result, 10);
+    return { Scalar::Integer, Result.str().str() };
+  }
+
+  // Floats require a dot
+  double Float = 0;
+  if (Value.contains('.') and not StringRef(Digits).getAsDouble(Float)) {
+    std::string Result;
+    raw_string_ostream Stream(Result);
+    Stream << format("%.17g", Float);
+    return { Scalar::Float, Stream.str() };
+  }
+
+  return { Scalar::String, Value.str() };
+}
+
+class Document {
+public:
+  std::vector<Node> Nodes;
+  Index Root = None;
+  /// Number of nodes taking part in the comparison
+  size_t GraphNodes = 0;
+
+private:
+  /// TypeDefinitions by ID and Kind
+  StringMap<Index> Definitions;
+
+public:
+  static Expected<Document> parse(StringRef Text) {
+    Document Result;
+
+    std::string Errors;
+    SourceMgr SM;
+    SM.setDiagHandler(
+      [](const SMDiagnostic &Diagnostic, void *Context) {
+        raw_string_ostream Stream(*static_cast<std::string *>(Context));
+        Diagnostic.print(nullptr, Stream, false);
+      },
+      &Errors);
+
+    yaml::Stream Stream(Text, SM);
+    auto It = Stream.begin();
+    yaml::Node *Root = It != Stream.end() ? It->getRoot() : nullptr;
+    Result.Root = Result.import(Root);
+
+    if (Stream.failed() or not Errors.empty())
+      return createStringError(inconvertibleErrorCode(), Errors);
+
+    Result.indexDefinitions();
+    Result.computeEdges();
+
+    // The root and all the containers and elements of sequences are nodes
+    Result.GraphNodes = 1;
+    for (const Node &N : Result.Nodes) {
+      if (N.Kind == Node::SequenceNode)
+        Result.GraphNodes += N.Elements.size();
+      else if (N.Kind == Node::MappingNode)
+        for (const auto &[Key, Child] : N.Entries)
+          if (Result.Nodes[Child].isContainer())
+            ++Result.GraphNodes;
+    }
+
+    return Result;
+  }
+
+  std::optional<Index> dereference(StringRef Reference) const {
+    // /TypeDefinitions/$ID-$Kind
+    Reference.consume_front("/TypeDefinitions/");
+    auto [ID, Kind] = Reference.split('-');
+    Kind = Kind.take_while([](char C) { return isAlnum(C) or C == '_'; });
+
+    uint64_t Value = 0;
+    if (ID.getAsInteger(10, Value) or Kind.empty())
+      return std::nullopt;
+
+    auto It = Definitions.find((Twine(Value) + "-" + Kind).str());
+    if (It == Definitions.end())
+      return std::nullopt;
+    return It->second;
+  }
+
+private:
+  Index import(yaml::Node *YAMLNode) {
+    Index Result = Nodes.size();
+    Nodes.emplace_back();
+
+    // Empty documents are null
+    if (YAMLNode == nullptr)
+      return Result;
+
+    if (auto *ScalarYAML = dyn_cast<yaml::ScalarNode>(YAMLNode)) {
+      SmallString<32> Storage;
+      StringRef Value = ScalarYAML->getValue(Storage);
+      StringRef Raw = ScalarYAML->getRawValue();
+      if (Raw.startswith("'") or Raw.startswith("\""))
+        Nodes[Result].Value = { Scalar::String, Value.str() };
+      else
+        Nodes[Result].Value = normalizePlainScalar(Value);
+    } else if (auto *Block = dyn_cast<yaml::BlockScalarNode>(YAMLNode)) {
+      Nodes[Result].Value = { Scalar::String, Block->getValue().str() };
+    } else if (auto *Mapping = dyn_cast<yaml::MappingNode>(YAMLNode)) {
+      Nodes[Result].Kind = Node::MappingNode;
+      for (yaml::KeyValueNode &Entry : *Mapping) {
+        std::string Key;
+        auto *KeyNode = dyn_cast_or_null<yaml::ScalarNode>(Entry.getKey());
+        if (KeyNode != nullptr) {
+          SmallString<32> Storage;
+          Key = KeyNode->getValue(Storage).str();
+        }
+
+        Index Child = import(Entry.getValue());
+        Nodes[Result].Entries.emplace_back(std::move(Key), Child);
+      }
+    } else if (auto *Sequence = dyn_cast<yaml::SequenceNode>(YAMLNode)) {
+      Nodes[Result].Kind = Node::SequenceNode;
+      for (yaml::Node &Element : *Sequence) {
+        Index Child = import(&Element);
+        Nodes[Result].Elements.push_back(Child);
+      }
+    }
+
+    return Result;
+  }
+
+  void indexDefinitions() {
+    if (Nodes[Root].Kind != Node::MappingNode)
+      return;
+
+    auto TypeDefinitions = Nodes[Root].findEntry("TypeDefinitions");
+    if (not TypeDefinitions)
+      return;
+
+    for (Index Element : Nodes[*TypeDefinitions].Elements) {
+      const Node &Definition = Nodes[Element];
+      auto ID = Definition.findEntry("ID");
+      auto Kind = Definition.findEntry("Kind");
+      if (not ID or not Kind)
+        continue;
+
+      const Scalar &IDValue = Nodes[*ID].Value;
+      const Scalar &KindValue = Nodes[*Kind].Value;
+      if (IDValue.Type != Scalar::Integer or not KindValue.isString())
+        continue;
+
+      Definitions.try_emplace(IDValue.Value + "-" + KindValue.Value, Element);
+    }
+  }
+
+  void computeEdges() {
+    for (Node &N : Nodes) {
+      if (N.Kind != Node::MappingNode)
+        continue;
+
+      for (const auto &[Key, Child] : N.Entries) {
+        StringRef Label = StringRef(Key).ltrim('$');
+        const Node &ChildNode = Nodes[Child];
+
+        if (ChildNode.isContainer()) {
+          N.Edges.push_back({ Label.str(), Child });
+          continue;
+        }
+
+        if (isReference(ChildNode.Value)) {
+          if (auto Target = dereference(ChildNode.Value.Value))
+            N.Edges.push_back({ Label.str(), *Target });
+          N.Filtered.emplace_back(Key, Scalar{ Scalar::String, "reference" });
+        } else if (Key != "ID") {
+          N.Filtered.emplace_back(Key, ChildNode.Value);
+        }
+      }
+
+      llvm::sort(N.Filtered, [](const auto &LHS, const auto &RHS) {
+        return LHS.first < RHS.first;
+      });
+    }
+  }
+};
+
+/// Backtracking search of a mapping from the nodes of the reference to the
+/// nodes of the input.
+///
+/// The pending work is a stack of tasks. Each time a choice is made (which
+/// element of an input sequence corresponds to an element of a reference
+/// sequence) a choice point is recorded. All the changes to the state are
+/// recorded on a trail, so that upon failure the state can be restored to the
+/// latest choice point and the next alternative can be explored.
+class Matcher {
+private:
+  struct Task {
+    enum KindType : uint8_t {
+      Pair,
+      Choose
+    };
+
+    KindType Kind;
+    Index Reference;
+    /// The input node for Pair, the input sequence for Choose
+    Index Input;
+    /// The candidates for Choose
+    const std::vector<Index> *Candidates = nullptr;
+    size_t Next = 0;
+  };
+
+  struct TrailEntry {
+    enum KindType : uint8_t {
+      Popped,
+      Pushed,
+      Assigned
+    };
+
+    KindType Kind;
+    Task PoppedTask;
+  };
+
+  struct ChoicePoint {
+    size_t TrailSize;
+    Task Alternative;
+  };
+
+  using Buckets = StringMap<std::vector<Index>>;
+
+private:
+  const Document &Reference;
+  const Document &Input;
+  bool Exact;
+
+  std::vector<Index> Map;
+  std::vector<bool> Used;
+  size_t Mapped = 0;
+  size_t MaxMapped = 0;
+
+  std::vector<Task> Tasks;
+  std::vector<TrailEntry> Trail;
+  std::vector<ChoicePoint> ChoicePoints;
+
+  std::vector<Index> RootCandidates;
+  /// Elements of each input sequence, indexed by their scalar values
+  DenseMap<Index, Buckets> SequenceBuckets;
+
+public:
+  Matcher(const Document &Reference, const Document &Input, bool Exact) :
+    Reference(Reference),
+    Input(Input),
+    Exact(Exact),
+    Map(Reference.Nodes.size(), None),
+    Used(Input.Nodes.size(), false) {}
+
+public:
+  model::YAMLComparison run() {
+    // The reference can match any part of the input, try the root first
+    RootCandidates.push_back(Input.Root);
+    for (Index I = 0; I < Input.Nodes.size(); ++I)
+      if (I != Input.Root
+          and Input.Nodes[I].Kind == Reference.Nodes[Reference.Root].Kind)
+        RootCandidates.push_back(I);
+
+    push({ Task::Choose, Reference.Root, None, &RootCandidates, 0 });
+
+    model::YAMLComparison Result;
+    Result.ReferenceNodes = Reference.GraphNodes;
+    while (true) {
+      if (Tasks.empty()) {
+        Result.Matches = true;
+        break;
+      }
+
+      Task Current = Tasks.back();
+      Tasks.pop_back();
+      Trail.push_back({ TrailEntry::Popped, Current });
+
+      if (not step(Current) and not backtrack())
+        break;
+    }
+
+    Result.MatchedNodes = Result.Matches ? Result.ReferenceNodes : MaxMapped;
+    return Result;
+  }
+
+private:
+  void push(const Task &NewTask) {
+    Tasks.push_back(NewTask);
+    Trail.push_back({ TrailEntry::Pushed, {} });
+  }
+
+  void assign(Index ReferenceNode, Index InputNode) {
+    Map[ReferenceNode] = InputNode;
+    Used[InputNode] = true;
+    Trail.push_back({ TrailEntry::Assigned, { Task::Pair, ReferenceNode } });
+    MaxMapped = std::max(MaxMapped, ++Mapped);
+  }
+
+  bool backtrack() {
+    if (ChoicePoints.empty())
+      return false;
+
+    ChoicePoint Point = ChoicePoints.back();
+    ChoicePoints.pop_back();
+
+    while (Trail.size() > Point.TrailSize) {
+      TrailEntry Entry = Trail.back();
+      Trail.pop_back();
+
+      switch (Entry.Kind) {
+      case TrailEntry::Popped:
+        Tasks.push_back(Entry.PoppedTask);
+        break;
+      case TrailEntry::Pushed:
+        Tasks.pop_back();
+        break;
+      case TrailEntry::Assigned: {
+        Index &Target = Map[Entry.PoppedTask.Reference];
+        Used[Target] = false;
+        Target = None;
+        --Mapped;
+      } break;
+      }
+    }
+
+    push(Point.Alternative);
+    return true;
+  }
+
+  bool step(const Task &Current) {
+    Index R = Current.Reference;
+
+    if (Current.Kind == Task::Choose) {
+      const std::vector<Index> &Candidates = *Current.Candidates;
+
+      // Already mapped through another edge
+      if (Map[R] != None)
+        return llvm::is_contained(Candidates, Map[R]);
+
+      for (size_t I = Current.Next; I < Candidates.size(); ++I) {
+        Index Candidate = Candidates[I];
+        if (Used[Candidate] or not isFeasible(R, Candidate))
+          continue;
+
+        Task Alternative = Current;
+        Alternative.Next = I + 1;
+        ChoicePoints.push_back({ Trail.size(), Alternative });
+        push({ Task::Pair, R, Candidate });
+        return true;
+      }
+
+      return false;
+    }
+
+    Index I = Current.Input;
+    if (Map[R] != None)
+      return Map[R] == I;
+
+    if (Used[I] or not isFeasible(R, I))
+      return false;
+
+    assign(R, I);
+    return pushSuccessors(R, I);
+  }
+
+  bool pushSuccessors(Index R, Index I) {
+    const Node &ReferenceNode = Reference.Nodes[R];
+    const Node &InputNode = Input.Nodes[I];
+
+    if (ReferenceNode.Kind == Node::MappingNode) {
+      // Push in reverse order, so that entries are processed in order
+      for (const Node::Edge &Edge : llvm::reverse(ReferenceNode.Edges)) {
+        auto It = llvm::find_if(InputNode.Edges, [&Edge](const Node::Edge &E) {
+          return E.Label == Edge.Label;
+        });
+        if (It == InputNode.Edges.end())
+          return false;
+        push({ Task::Pair, Edge.Target, It->Target });
+      }
+    } else if (ReferenceNode.Kind == Node::SequenceNode) {
+      const auto &Elements = ReferenceNode.Elements;
+      for (size_t Position = Elements.size(); Position > 0; --Position) {
+        Index Element = Elements[Position - 1];
+        if (Exact) {
+          if (Position > InputNode.Elements.size())
+            return false;
+          push({ Task::Pair, Element, InputNode.Elements[Position - 1] });
+        } else {
+          const auto *Candidates = &candidates(Element, I);
+          push({ Task::Choose, Element, I, Candidates, 0 });
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /// Elements of the input sequence \p Sequence that might match \p Element
+  const std::vector<Index> &candidates(Index Element, Index Sequence) {
+    auto [It, New] = SequenceBuckets.try_emplace(Sequence);
+    Buckets &SequenceIndex = It->second;
+    if (New) {
+      std::vector<Index> &All = SequenceIndex["*"];
+      for (Index Child : Input.Nodes[Sequence].Elements) {
+        All.push_back(Child);
+        const Node &ChildNode = Input.Nodes[Child];
+        if (ChildNode.Kind == Node::ScalarNode)
+          SequenceIndex["=" + ChildNode.Value.toKey()].push_back(Child);
+        for (const auto &[Key, Value] : ChildNode.Filtered)
+          SequenceIndex[Key + "=" + Value.toKey()].push_back(Child);
+      }
+    }
+
+    // Use the smallest bucket among those the element would belong to
+    static const std::vector<Index> Empty;
+    const Node &ElementNode = Reference.Nodes[Element];
+    const std::vector<Index> *Result = &SequenceIndex["*"];
+    auto Consider = [&](const std::string &Key) {
+      auto BucketIt = SequenceIndex.find(Key);
+      const auto *Bucket = BucketIt == SequenceIndex.end() ? &Empty :
+                                                             &BucketIt->second;
+      if (Bucket->size() < Result->size())
+        Result = Bucket;
+    };
+
+    if (ElementNode.Kind == Node::ScalarNode)
+      Consider("=" + ElementNode.Value.toKey());
+    for (const auto &[Key, Value] : ElementNode.Filtered)
+      if (not StringRef(Key).startswith("-"))
+        Consider(Key + "=" + Value.toKey());
+
+    return *Result;
+  }
+
+  bool isFeasible(Index R, Index I) const {
+    const Node &ReferenceNode = Reference.Nodes[R];
+    const Node &InputNode = Input.Nodes[I];
+
+    if (ReferenceNode.Kind != InputNode.Kind)
+      return false;
+
+    switch (ReferenceNode.Kind) {
+    case Node::ScalarNode:
+      return ReferenceNode.Value == InputNode.Value;
+
+    case Node::SequenceNode:
+      return true;
+
+    case Node::MappingNode:
+      break;
+    }
+
+    // $Key: the size of the container must match
+    for (const auto &[Key, Child] : ReferenceNode.Entries) {
+      const Node &ChildNode = Reference.Nodes[Child];
+      if (not StringRef(Key).startswith("$") or not ChildNode.isContainer())
+        continue;
+
+      auto InputChild = InputNode.findEntry(StringRef(Key).drop_front());
+      if (not InputChild)
+        return false;
+
+      const Node &InputChildNode = Input.Nodes[*InputChild];
+      if (InputChildNode.Kind != ChildNode.Kind
+          or InputChildNode.size() != ChildNode.size())
+        return false;
+    }
+
+    if (Exact)
+      return ReferenceNode.Filtered == InputNode.Filtered;
+
+    for (const auto &[Key, Value] : ReferenceNode.Filtered) {
+      StringRef KeyRef = Key;
+      if (KeyRef.consume_front("-")) {
+        if (InputNode.findFiltered(KeyRef) != nullptr)
+          return false;
+      } else {
+        const Scalar *InputValue = InputNode.findFiltered(KeyRef);
+        if (InputValue == nullptr or not(*InputValue == Value))
+          return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+} // namespace
+
+Expected<model::YAMLComparison>
+model::compareYAML(StringRef Reference, StringRef Input, bool Exact) {
+  auto ReferenceDocument = Document::parse(Reference);
+  if (not ReferenceDocument)
+    return ReferenceDocument.takeError();
+
+  auto InputDocument = Document::parse(Input);
+  if (not InputDocument)
+    return InputDocument.takeError();
+
+  Matcher TheMatcher(*ReferenceDocument, *InputDocument, Exact);
+  return TheMatcher.run();
+}
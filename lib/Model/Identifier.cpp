@@ -4,13 +4,16 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSet.h"
+
 #include "revng/Model/Identifier.h"
 
 using namespace model;
 
 const Identifier Identifier::Empty = Identifier("");
 
-const std::set<llvm::StringRef> ReservedKeywords = {
+static const llvm::StringSet<> ReservedKeywords = {
   // reserved keywords for primitive types
   "void",
   "pointer_or_number8_t",
@@ -250,23 +253,18 @@ const std::set<llvm::StringRef> ReservedKeywords = {
   "asm",
 };
 
-static bool isNotUnderscore(const char C) {
-  return C != '_';
-};
-
-static bool allAlphaNumOrUnderscore(const Identifier &Range) {
-  const auto &FilterRange = llvm::make_filter_range(Range, isNotUnderscore);
-  for (const auto &Entry : FilterRange)
-    if (not std::isalnum(Entry))
-      return false;
-  return true;
-};
+static bool isValidCharacter(const char C) {
+  return llvm::isAlnum(C) or C == '_';
+}
 
 bool Identifier::verify(VerifyHelper &VH) const {
-  return VH.maybeFail(not(not empty() and std::isdigit(str()[0]))
-                        and not startswith("_")
-                        and allAlphaNumOrUnderscore(str())
-                        and not ReservedKeywords.contains(str()),
+  bool IsValid = true;
+  if (not empty())
+    IsValid = not llvm::isDigit(front()) and front() != '_'
+              and llvm::all_of(*this, isValidCharacter)
+              and not ReservedKeywords.contains(str());
+
+  return VH.maybeFail(IsValid,
                       llvm::Twine(*this) + " is not a valid identifier");
 }
 
@@ -286,33 +284,33 @@ Identifier Identifier::fromString(llvm::StringRef Name) {
 
   // For reserved C keywords prepend a non-reserved prefix and we're done.
   if (ReservedKeywords.contains(Name)) {
+    Result.reserve(PrefixForReservedNames.size() + Name.size());
     Result += PrefixForReservedNames;
     Result += Name;
     return Result;
   }
 
-  const auto BecomesUnderscore = [](const char C) {
-    return not std::isalnum(C) or C == '_';
-  };
-
   // For invalid C identifiers prepend the our reserved prefix.
-  if (std::isdigit(Name[0]) or BecomesUnderscore(Name[0])) {
+  bool NeedsPrefix = not llvm::isAlpha(Name[0]);
+  Result.reserve((NeedsPrefix ? PrefixForReservedNames.size() : 0)
+                 + Name.size());
+  if (NeedsPrefix)
     Result += PrefixForReservedNames;
-  }
 
-  // Append the rest of the name
-  Result += Name;
+  // Append the rest of the name, sanitizing it on the fly
+  for (char C : Name)
+    Result.push_back(llvm::isAlnum(C) ? C : '_');
 
-  return sanitize(Result);
+  return Result;
 }
 
 Identifier Identifier::sanitize(llvm::StringRef Name) {
-  Identifier Result(Name);
+  Identifier Result;
+  Result.reserve(Name.size());
 
   // Convert all non-alphanumeric chars to underscores
-  for (char &C : Result)
-    if (not std::isalnum(C))
-      C = '_';
+  for (char C : Name)
+    Result.push_back(llvm::isAlnum(C) ? C : '_');
 
   return Result;
 }
@@ -4,9 +4,11 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
-#include <set>
 #include <string>
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+
 #include "revng/Model/Pass/PromoteOriginalName.h"
 #include "revng/Model/Pass/RegisterModelPass.h"
 
@@ -18,17 +20,59 @@ static RegisterModelPass R("promote-original-name",
                            "the validity of the model is preserved",
                            model::promoteOriginalName);
 
-class SymbolPromoter {
+/// A set of names able to allocate new unique names by appending underscores
+///
+/// For each requested name, the number of underscores appended so far is
+/// recorded, so that requesting the same name many times (e.g., the same C++
+/// mangled name in many namespaces) does not restart the search each time.
+class NameSet {
 private:
-  std::set<Identifier> GlobalSymbols;
-  std::set<Identifier> TakenLocalSymbols;
+  llvm::StringSet<> Names;
+  llvm::StringMap<size_t> Underscores;
 
 public:
   void dump() const debug_function {
-    for (const Identifier &ID : GlobalSymbols)
-      dbg << ID.str().str() << "\n";
+    for (const auto &Entry : Names)
+      dbg << Entry.getKey().str() << "\n";
   }
 
+public:
+  bool contains(llvm::StringRef Name) const { return Names.contains(Name); }
+
+  void insert(llvm::StringRef Name) { Names.insert(Name); }
+
+  /// Return the first among \p Name, \p Name followed by one underscore, two
+  /// underscores and so on that is neither in this set nor in \p Taken and
+  /// insert it in this set
+  ///
+  /// \note \p Taken must not shrink between invocations
+  Identifier allocate(Identifier Name, const NameSet &Taken) {
+    // All the candidates with less underscores than the ones allocated so far
+    // are known to be taken
+    size_t &Count = Underscores[Name];
+    Name.append(Count, '_');
+
+    while (Taken.contains(Name) or contains(Name)) {
+      Name += "_";
+      ++Count;
+    }
+
+    auto [_, Inserted] = Names.insert(Name);
+    revng_assert(Inserted);
+    ++Count;
+
+    return Name;
+  }
+};
+
+class SymbolPromoter {
+private:
+  NameSet GlobalSymbols;
+  NameSet TakenLocalSymbols;
+
+public:
+  void dump() const debug_function { GlobalSymbols.dump(); }
+
 public:
   void recordGlobalSymbols(auto &Collection, auto Unwrap) {
     for (auto &Entry2 : Collection) {
@@ -53,31 +97,23 @@ public:
   }
 
   void promoteLocalSymbols(auto &Collection, auto Unwrap) {
-    std::set<Identifier> LocalBucket;
+    NameSet LocalBucket;
     promoteSymbolsImpl(Collection, Unwrap, LocalBucket, GlobalSymbols);
   }
 
 private:
   void promoteSymbolsImpl(auto &Collection,
                           auto Unwrap,
-                          std::set<Identifier> &Namespace,
-                          const std::set<Identifier> &Taken) {
+                          NameSet &Namespace,
+                          const NameSet &Taken) {
     // TODO: collapse uint8_t typedefs into the primitive type
     for (auto &Wrapped : Collection) {
       auto *Entry = Unwrap(Wrapped);
       if (Entry->CustomName().empty() and not Entry->OriginalName().empty()) {
-        // We have an OriginalName but not CustomName
+        // We have an OriginalName but not CustomName: assign a name that's
+        // unique in the current namespace and record it as taken
         auto Name = Identifier::fromString(Entry->OriginalName());
-
-        while (Taken.contains(Name) or Namespace.contains(Name))
-          Name += "_";
-
-        // Assign name
-        Entry->CustomName() = Name;
-
-        // Record new name as taken in the current namespace
-        auto [_, Inserted] = Namespace.insert(Name);
-        revng_assert(Inserted);
+        Entry->CustomName() = Namespace.allocate(std::move(Name), Taken);
       }
     }
   }
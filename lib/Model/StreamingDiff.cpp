@@ -0,0 +1,599 @@
+/// \file StreamingDiff.cpp
+/// Diff and apply of serialized models one top-level element at a time.
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/Twine.h"
+
+#include "revng/Model/StreamingDiff.h"
+
+using namespace llvm;
+
+using BinaryDiff = TupleTreeDiff<model::Binary>;
+using BinaryChange = BinaryDiff::Change;
+
+static Error createError(const Twine &Message) {
+  return createStringError(inconvertibleErrorCode(), Message);
+}
+
+namespace {
+
+/// A top-level entry of a serialized model
+struct Section {
+  StringRef Name;
+  /// The whole text of the entry, including the line of the key
+  StringRef Text;
+  /// The text following the line of the key
+  StringRef Body;
+  /// True if the value is a block sequence, one element per `  - ` line
+  bool Streamable = false;
+};
+
+/// Top-level layout of a serialized model
+class Layout {
+private:
+  std::vector<Section> Sections;
+
+public:
+  static Expected<Layout> scan(StringRef Buffer) {
+    Layout Result;
+    const char *SectionStart = nullptr;
+    StringRef Rest = Buffer;
+
+    auto Close = [&](const char *End) {
+      if (SectionStart == nullptr)
+        return;
+      Result.Sections.back().Text = StringRef(SectionStart, End - SectionStart);
+      SectionStart = nullptr;
+    };
+
+    while (not Rest.empty()) {
+      const char *LineStart = Rest.data();
+      auto [Line, Next] = Rest.split('\n');
+      Rest = Next;
+
+      // Indented lines, comments and empty lines belong to the current entry
+      if (Line.empty() or Line.startswith(" ") or Line.startswith("\t")
+          or Line.startswith("#"))
+        continue;
+
+      // Document markers
+      if (Line.startswith("---")) {
+        Close(LineStart);
+        continue;
+      }
+
+      if (Line.rtrim() == "...") {
+        Close(LineStart);
+        break;
+      }
+
+      size_t Colon = Line.find(':');
+      if (Line.startswith("-") or Colon == StringRef::npos)
+        return createError("The model is not a YAML mapping: " + Line);
+
+      Close(LineStart);
+      SectionStart = LineStart;
+      Result.Sections.push_back({ Line.take_front(Colon) });
+    }
+    Close(Buffer.end());
+
+    for (Section &S : Result.Sections)
+      S.Streamable = isBlockSequence(S);
+
+    return Result;
+  }
+
+public:
+  const Section *find(StringRef Name) const {
+    for (const Section &S : Sections)
+      if (S.Name == Name)
+        return &S;
+    return nullptr;
+  }
+
+  auto begin() const { return Sections.begin(); }
+  auto end() const { return Sections.end(); }
+
+private:
+  static bool isBlockSequence(Section &S) {
+    auto [KeyLine, Body] = S.Text.split('\n');
+    S.Body = Body;
+    if (KeyLine.rtrim() != (S.Name + ":").str())
+      return false;
+
+    bool First = true;
+    for (StringRef Rest = Body; not Rest.empty();) {
+      auto [Line, Next] = Rest.split('\n');
+      Rest = Next;
+
+      if (Line.trim().empty() or Line.ltrim().startswith("#"))
+        continue;
+
+      bool IsElement = Line == "  -" or Line.startswith("  - ");
+      if (not IsElement and (First or not Line.startswith("    ")))
+        return false;
+
+      First = false;
+    }
+
+    return true;
+  }
+};
+
+/// Splits the body of a block sequence in the text of its elements
+class ElementCursor {
+private:
+  StringRef Rest;
+  StringRef Current;
+
+public:
+  explicit ElementCursor(StringRef Body) : Rest(Body) { Current = nextSlice(); }
+
+public:
+  bool done() const { return Current.empty(); }
+  StringRef current() const { return Current; }
+
+  /// The text of the current and of all the following elements
+  StringRef remaining() const {
+    return StringRef(Current.data(), Current.size() + Rest.size());
+  }
+
+  void advance() { Current = nextSlice(); }
+
+private:
+  StringRef nextSlice() {
+    // Drop empty lines and comments preceding the element
+    while (not Rest.empty()) {
+      StringRef Line = Rest.take_until([](char C) { return C == '\n'; });
+      if (not Line.trim().empty() and not Line.ltrim().startswith("#"))
+        break;
+      Rest = Rest.drop_front(std::min(Line.size() + 1, Rest.size()));
+    }
+
+    if (Rest.empty())
+      return {};
+
+    // Look for the start of the next element, skipping the first line
+    size_t End = Rest.find('\n');
+    while (End != StringRef::npos) {
+      StringRef Line = Rest.drop_front(End + 1);
+      if (Line.startswith("  -")
+          and (Line.size() == 3 or Line[3] == ' ' or Line[3] == '\n'))
+        break;
+      End = Rest.find('\n', End + 1);
+    }
+
+    StringRef Result = End == StringRef::npos ? Rest :
+                                                Rest.take_front(End + 1);
+    Rest = Rest.drop_front(Result.size());
+    return Result;
+  }
+};
+
+template<size_t I>
+using CollectionType = std::tuple_element_t<I, model::Binary>;
+
+template<size_t I>
+using ElementType = typename CollectionType<I>::value_type;
+
+template<size_t I>
+using KeyType = revng::detail::Key<ElementType<I>>;
+
+template<size_t I>
+using KeyLess = DefaultKeyObjectComparator<ElementType<I>>;
+
+/// The elements of a top-level collection of a serialized model, each of which
+/// is deserialized on demand as a model containing only it
+template<size_t I>
+class ElementStream {
+private:
+  StringRef Name;
+  ElementCursor Cursor;
+  std::optional<TupleTree<model::Binary>> Tree;
+  std::optional<KeyType<I>> Key;
+  std::optional<KeyType<I>> LastKey;
+
+public:
+  ElementStream(StringRef Name, StringRef Body) : Name(Name), Cursor(Body) {}
+
+public:
+  bool done() const { return Cursor.done(); }
+  StringRef text() const { return Cursor.current(); }
+  StringRef remaining() const { return Cursor.remaining(); }
+
+  const KeyType<I> &key() const { return *Key; }
+  const model::Binary &tree() const { return **Tree; }
+  TupleTree<model::Binary> &mutableTree() { return *Tree; }
+
+  Error parse() {
+    if (Tree.has_value())
+      return Error::success();
+
+    std::string Text = (Name + ":\n" + text()).str();
+    auto MaybeTree = TupleTree<model::Binary>::fromString(Text);
+    if (not MaybeTree)
+      return MaybeTree.takeError();
+    Tree = std::move(*MaybeTree);
+
+    const auto &Elements = get<I>(tree());
+    if (Elements.size() != 1)
+      return createError("Cannot deserialize an element of " + Name + ":\n"
+                         + text());
+
+    using KOT = KeyedObjectTraits<ElementType<I>>;
+    Key = KOT::key(*Elements.begin());
+
+    if (LastKey.has_value() and not KeyLess<I>()(*LastKey, *Key))
+      return createError("The elements of " + Name + " are not sorted");
+
+    return Error::success();
+  }
+
+  void advance() {
+    if (Key.has_value())
+      LastKey = std::move(Key);
+    Key.reset();
+    Tree.reset();
+    Cursor.advance();
+  }
+};
+
+/// Invoke \p Callable on the index of each top-level collection of the model
+template<size_t I = 0, typename CallableT>
+Error forEachCollection(CallableT &&Callable) {
+  if constexpr (I < std::tuple_size_v<model::Binary>) {
+    if constexpr (revng::SetOrKOC<CollectionType<I>>)
+      if (Error Result = Callable(std::integral_constant<size_t, I>()))
+        return Result;
+
+    return forEachCollection<I + 1>(std::forward<CallableT>(Callable));
+  } else {
+    return Error::success();
+  }
+}
+
+template<size_t I>
+StringRef fieldName() {
+  return TupleLikeTraits<model::Binary>::FieldNames[I];
+}
+
+/// Serialize the elements of the \p I-th collection of \p Tree, the only
+/// non-empty field
+template<size_t I>
+std::string serializeElements(const TupleTree<model::Binary> &Tree) {
+  std::string Buffer;
+  Tree.serialize(Buffer);
+
+  StringRef Text = Buffer;
+  std::string KeyLine = ("\n" + fieldName<I>() + ":\n").str();
+  size_t Start = Text.find(KeyLine);
+  if (Start == StringRef::npos)
+    return "";
+
+  Text = Text.drop_front(Start + KeyLine.size());
+  Text.consume_back("...\n");
+  return Text.str();
+}
+
+/// Concatenate the text of the sections not in \p Streamed
+std::string headerText(const Layout &Model, const StringSet<> &Streamed) {
+  std::string Result;
+  for (const Section &S : Model)
+    if (not Streamed.contains(S.Name))
+      Result += S.Text.str();
+  return Result;
+}
+
+/// Writes a serialized TupleTreeDiff incrementally
+class DiffWriter {
+private:
+  raw_ostream &OS;
+  size_t Count = 0;
+
+public:
+  explicit DiffWriter(raw_ostream &OS) : OS(OS) {}
+
+public:
+  void write(const BinaryDiff &Diff) {
+    if (Diff.Changes.empty())
+      return;
+
+    std::string Buffer;
+    {
+      raw_string_ostream Stream(Buffer);
+      Diff.dump(Stream);
+    }
+
+    StringRef Text = Buffer;
+    StringRef KeyLine = "Changes:\n";
+    Text = Text.drop_front(Text.find(KeyLine) + KeyLine.size());
+    Text.consume_back("...\n");
+
+    if (Count == 0)
+      OS << "---\n" << KeyLine;
+    OS << Text;
+    Count += Diff.Changes.size();
+  }
+
+  size_t finish() {
+    if (Count == 0)
+      BinaryDiff().dump(OS);
+    else
+      OS << "...\n";
+    return Count;
+  }
+};
+
+} // namespace
+
+Expected<size_t> model::streamingDiff(StringRef Old,
+                                      StringRef New,
+                                      raw_ostream &Output) {
+  auto OldLayout = Layout::scan(Old);
+  if (not OldLayout)
+    return OldLayout.takeError();
+
+  auto NewLayout = Layout::scan(New);
+  if (not NewLayout)
+    return NewLayout.takeError();
+
+  // Stream the collections that are either missing or in block style
+  StringSet<> Streamed;
+  cantFail(forEachCollection([&](auto Index) -> Error {
+    StringRef Name = fieldName<decltype(Index)::value>();
+    const Section *OldSection = OldLayout->find(Name);
+    const Section *NewSection = NewLayout->find(Name);
+    if ((OldSection == nullptr or OldSection->Streamable)
+        and (NewSection == nullptr or NewSection->Streamable))
+      Streamed.insert(Name);
+    return Error::success();
+  }));
+
+  DiffWriter Writer(Output);
+
+  // Everything else is compared as a whole
+  {
+    using Model = TupleTree<model::Binary>;
+    auto OldHeader = Model::fromString(headerText(*OldLayout, Streamed));
+    if (not OldHeader)
+      return OldHeader.takeError();
+
+    auto NewHeader = Model::fromString(headerText(*NewLayout, Streamed));
+    if (not NewHeader)
+      return NewHeader.takeError();
+
+    Writer.write(diff(**OldHeader, **NewHeader));
+  }
+
+  Error Result = forEachCollection([&](auto Index) -> Error {
+    constexpr size_t I = decltype(Index)::value;
+    StringRef Name = fieldName<I>();
+    if (not Streamed.contains(Name))
+      return Error::success();
+
+    auto BodyOf = [Name](const Layout &L) {
+      const Section *S = L.find(Name);
+      return S == nullptr ? StringRef() : S->Body;
+    };
+
+    ElementStream<I> OldElements(Name, BodyOf(*OldLayout));
+    ElementStream<I> NewElements(Name, BodyOf(*NewLayout));
+    const model::Binary Empty;
+
+    while (not OldElements.done() or not NewElements.done()) {
+      if (not OldElements.done() and not NewElements.done()
+          and OldElements.text() == NewElements.text()) {
+        OldElements.advance();
+        NewElements.advance();
+        continue;
+      }
+
+      if (not OldElements.done())
+        if (Error E = OldElements.parse())
+          return E;
+
+      if (not NewElements.done())
+        if (Error E = NewElements.parse())
+          return E;
+
+      KeyLess<I> Less;
+      if (NewElements.done()
+          or (not OldElements.done()
+              and Less(OldElements.key(), NewElements.key()))) {
+        // Removed
+        Writer.write(diff(OldElements.tree(), Empty));
+        OldElements.advance();
+      } else if (OldElements.done()
+                 or Less(NewElements.key(), OldElements.key())) {
+        // Added
+        Writer.write(diff(Empty, NewElements.tree()));
+        NewElements.advance();
+      } else {
+        // Changed
+        Writer.write(diff(OldElements.tree(), NewElements.tree()));
+        OldElements.advance();
+        NewElements.advance();
+      }
+    }
+
+    return Error::success();
+  });
+
+  if (Result)
+    return std::move(Result);
+
+  return Writer.finish();
+}
+
+static Error applyChanges(TupleTree<model::Binary> &Tree,
+                          const std::vector<const BinaryChange *> &Changes) {
+  BinaryDiff Diff;
+  for (const BinaryChange *Change : Changes)
+    Diff.Changes.push_back(*Change);
+  return Diff.apply(Tree);
+}
+
+Error model::streamingApply(StringRef Model,
+                            const BinaryDiff &Diff,
+                            raw_ostream &Output) {
+  auto ModelLayout = Layout::scan(Model);
+  if (not ModelLayout)
+    return ModelLayout.takeError();
+
+  // Stream the collections in block style, changes to the others are applied
+  // to the header
+  StringSet<> Streamed;
+  StringMap<std::vector<const BinaryChange *>> ChangesByCollection;
+  cantFail(forEachCollection([&](auto Index) -> Error {
+    StringRef Name = fieldName<decltype(Index)::value>();
+    const Section *S = ModelLayout->find(Name);
+    if (S != nullptr and S->Streamable)
+      Streamed.insert(Name);
+    return Error::success();
+  }));
+
+  std::vector<const BinaryChange *> HeaderChanges;
+  for (const BinaryChange &Change : Diff.Changes) {
+    const size_t *Field = nullptr;
+    if (not Change.Path.empty())
+      Field = Change.Path[0].tryGet<size_t>();
+
+    StringRef Name;
+    if (Field != nullptr and *Field < std::tuple_size_v<model::Binary>)
+      Name = TupleLikeTraits<model::Binary>::FieldNames[*Field];
+
+    if (Streamed.contains(Name))
+      ChangesByCollection[Name].push_back(&Change);
+    else
+      HeaderChanges.push_back(&Change);
+  }
+
+  // Header
+  {
+    auto Header = TupleTree<model::Binary>::fromString(headerText(*ModelLayout,
+                                                                  Streamed));
+    if (not Header)
+      return Header.takeError();
+
+    if (Error E = applyChanges(*Header, HeaderChanges))
+      return E;
+
+    std::string Buffer;
+    Header->serialize(Buffer);
+
+    StringRef Text = Buffer;
+    Text.consume_front("---");
+    Text.consume_back("...\n");
+    Output << "---\n";
+    if (not Text.ltrim().startswith("{}"))
+      Output << Text.drop_front(Text.startswith("\n") ? 1 : 0);
+  }
+
+  Error Result = forEachCollection([&](auto Index) -> Error {
+    constexpr size_t I = decltype(Index)::value;
+    StringRef Name = fieldName<I>();
+    if (not Streamed.contains(Name))
+      return Error::success();
+
+    ElementStream<I> Elements(Name, ModelLayout->find(Name)->Body);
+
+    // The key line is emitted only if there's at least an element
+    bool Started = false;
+    auto Emit = [&](StringRef Text) {
+      if (Text.empty())
+        return;
+      if (not Started)
+        Output << Name << ":\n";
+      Started = true;
+      Output << Text;
+    };
+
+    // Group the changes by the key of the element they affect
+    using ElementChanges = std::vector<const BinaryChange *>;
+    std::map<KeyType<I>, ElementChanges, KeyLess<I>> Pending;
+    for (const BinaryChange *Change : ChangesByCollection.lookup(Name)) {
+      using KOT = KeyedObjectTraits<ElementType<I>>;
+      const auto &Path = Change->Path;
+      if (Path.size() > 1) {
+        if (const auto *Key = Path[1].tryGet<KeyType<I>>()) {
+          Pending[*Key].push_back(Change);
+          continue;
+        }
+      } else if (Change->New.has_value()) {
+        const auto &Element = std::get<ElementType<I>>(*Change->New);
+        Pending[KOT::key(Element)].push_back(Change);
+        continue;
+      } else if (Change->Old.has_value()) {
+        const auto &Element = std::get<ElementType<I>>(*Change->Old);
+        Pending[KOT::key(Element)].push_back(Change);
+        continue;
+      }
+
+      auto PathString = pathAsString<model::Binary>(Path);
+      return createError("Path not present: "
+                         + PathString.value_or("(unavailable)"));
+    }
+
+    // Changes to elements that are not in the model, typically additions
+    auto FlushBefore = [&](const KeyType<I> *Limit) -> Error {
+      while (not Pending.empty()
+             and (Limit == nullptr
+                  or KeyLess<I>()(Pending.begin()->first, *Limit))) {
+        TupleTree<model::Binary> Tree;
+        if (Error E = applyChanges(Tree, Pending.begin()->second))
+          return E;
+        Emit(serializeElements<I>(Tree));
+        Pending.erase(Pending.begin());
+      }
+      return Error::success();
+    };
+
+    while (not Elements.done()) {
+      // Nothing left to change
+      if (Pending.empty()) {
+        Emit(Elements.remaining());
+        break;
+      }
+
+      if (Error E = Elements.parse())
+        return E;
+
+      if (Error E = FlushBefore(&Elements.key()))
+        return E;
+
+      auto It = Pending.find(Elements.key());
+      if (It == Pending.end()) {
+        Emit(Elements.text());
+      } else {
+        TupleTree<model::Binary> &Tree = Elements.mutableTree();
+        if (Error E = applyChanges(Tree, It->second))
+          return E;
+        Emit(serializeElements<I>(Tree));
+        Pending.erase(It);
+      }
+
+      Elements.advance();
+    }
+
+    return FlushBefore(nullptr);
+  });
+
+  if (Result)
+    return Result;
+
+  Output << "...\n";
+  return Error::success();
+}
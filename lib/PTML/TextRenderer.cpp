@@ -0,0 +1,294 @@
+/// \file TextRenderer.cpp
+/// Streaming conversion of PTML to plain or colorized text.
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <optional>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/ConvertUTF.h"
+
+#include "revng/PTML/Constants.h"
+#include "revng/PTML/TextRenderer.h"
+
+using namespace llvm;
+
+namespace ptml {
+
+static constexpr size_t MaxEntitySize = 32;
+
+/// Index in the 256-color ANSI palette of the color associated to \p Token,
+/// the same used by `revng ptml --color`
+static uint8_t tokenColor(StringRef Token) {
+  enum : uint8_t {
+    White = 7,
+    BrightRed = 9,
+    BrightGreen = 10,
+    BrightWhite = 15,
+    DodgerBlue1 = 33,
+    SeaGreen1 = 84,
+    DarkSlateGray2 = 87,
+    MediumPurple1 = 141,
+    Orange1 = 214,
+  };
+
+  return StringSwitch<uint8_t>(Token)
+    .Case("asm.label", BrightRed)
+    .Case("asm.label-indicator", BrightWhite)
+    .Case("asm.comment-indicator", White)
+    .Case("asm.mnemonic", DodgerBlue1)
+    .Case("asm.mnemonic-prefix", BrightGreen)
+    .Case("asm.mnemonic-suffix", BrightGreen)
+    .Case("asm.immediate-value", DarkSlateGray2)
+    .Case("asm.memory-operand", DodgerBlue1)
+    .Case("asm.register", Orange1)
+    .Case("asm.helper", DodgerBlue1)
+    .Case("asm.directive", SeaGreen1)
+    .Case("asm.instruction-address", MediumPurple1)
+    .Case("asm.raw-bytes", White)
+    .Case("c.function", BrightRed)
+    .Case("c.type", SeaGreen1)
+    .Case("c.operator", DodgerBlue1)
+    .Case("c.comparison", DodgerBlue1)
+    .Case("c.function_parameter", Orange1)
+    .Case("c.variable", Orange1)
+    .Case("c.field", Orange1)
+    .Case("c.constant", DarkSlateGray2)
+    .Case("c.string_literal", MediumPurple1)
+    .Case("c.keyword", DodgerBlue1)
+    .Case("c.directive", DodgerBlue1)
+    .Default(0);
+}
+
+static bool isSpace(char C) {
+  return C == ' ' or C == '\t' or C == '\n' or C == '\r';
+}
+
+/// Find the value of the attribute \p Name in the content of an opening tag
+static std::optional<StringRef> findAttribute(StringRef Tag, StringRef Name) {
+  // Skip the name of the element
+  size_t Position = Tag.find_if(isSpace);
+  if (Position == StringRef::npos)
+    return std::nullopt;
+  Tag = Tag.drop_front(Position);
+
+  while (true) {
+    Tag = Tag.ltrim(" \t\n\r");
+    if (Tag.empty())
+      return std::nullopt;
+
+    size_t NameEnd = Tag.find_if([](char C) { return C == '=' or isSpace(C); });
+    StringRef AttributeName = Tag.take_front(NameEnd);
+    Tag = Tag.drop_front(AttributeName.size()).ltrim(" \t\n\r");
+
+    // Attribute without a value
+    if (not Tag.consume_front("="))
+      continue;
+
+    Tag = Tag.ltrim(" \t\n\r");
+    if (Tag.empty())
+      return std::nullopt;
+
+    StringRef Value;
+    char Delimiter = Tag.front();
+    if (Delimiter == '"' or Delimiter == '\'') {
+      size_t End = Tag.find(Delimiter, 1);
+      Value = Tag.slice(1, End);
+      Tag = End == StringRef::npos ? StringRef() : Tag.drop_front(End + 1);
+    } else {
+      Value = Tag.take_until(isSpace);
+      Tag = Tag.drop_front(Value.size());
+    }
+
+    if (AttributeName == Name)
+      return Value;
+  }
+}
+
+void TextRenderer::feed(StringRef Chunk) {
+  while (not Chunk.empty()) {
+    switch (Current) {
+    case State::Text: {
+      size_t Special = Chunk.find_first_of("<&");
+      emitText(Chunk.take_front(Special));
+      if (Special == StringRef::npos)
+        return;
+
+      Current = Chunk[Special] == '<' ? State::Tag : State::Entity;
+      Pending.clear();
+      Quote = 0;
+      Chunk = Chunk.drop_front(Special + 1);
+    } break;
+
+    case State::Tag: {
+      char C = Chunk.front();
+      Chunk = Chunk.drop_front();
+
+      // Comments, processing instructions and declarations might contain
+      // unbalanced quotes
+      bool Markup = not Pending.empty()
+                    and (Pending.front() == '!' or Pending.front() == '?');
+
+      if (Quote != 0) {
+        if (C == Quote)
+          Quote = 0;
+      } else if ((C == '"' or C == '\'') and not Markup) {
+        Quote = C;
+      } else if (C == '>') {
+        StringRef Content = Pending;
+        bool InComment = Content.startswith("!--")
+                         and (Content.size() < 5
+                              or not Content.endswith("--"));
+        if (not InComment) {
+          handleTag(Content);
+          Current = State::Text;
+          continue;
+        }
+      }
+
+      Pending.push_back(C);
+    } break;
+
+    case State::Entity: {
+      size_t End = Chunk.find(';');
+      Pending.append(Chunk.take_front(End).str());
+      if (End == StringRef::npos) {
+        // Not an entity, give up on decoding it
+        if (Pending.size() > MaxEntitySize) {
+          fail("Unterminated entity: &" + Pending);
+          emitText("&" + Pending);
+          Current = State::Text;
+        }
+        return;
+      }
+
+      handleEntity(Pending);
+      Current = State::Text;
+      Chunk = Chunk.drop_front(End + 1);
+    } break;
+    }
+  }
+}
+
+Error TextRenderer::finish() {
+  if (Current == State::Tag)
+    fail("Unterminated tag: <" + Pending);
+  else if (Current == State::Entity)
+    fail("Unterminated entity: &" + Pending);
+  else if (not Colors.empty())
+    fail(Twine(Colors.size()) + " elements have not been closed");
+
+  Current = State::Text;
+  Colors.clear();
+  setColor(NoColor);
+  OS.flush();
+
+  if (ErrorMessage.empty())
+    return Error::success();
+
+  return createStringError(inconvertibleErrorCode(), ErrorMessage);
+}
+
+void TextRenderer::handleTag(StringRef Tag) {
+  // Comments, processing instructions and declarations
+  if (Tag.startswith("!") or Tag.startswith("?"))
+    return;
+
+  // Closing tag
+  if (Tag.startswith("/")) {
+    if (Colors.empty())
+      fail("Unbalanced closing tag: <" + Tag + ">");
+    else
+      Colors.pop_back();
+    return;
+  }
+
+  // Self-closing elements have no content to color
+  if (Tag.rtrim(" \t\n\r").endswith("/"))
+    return;
+
+  // Elements without a token inherit the one of their parent, elements with an
+  // unknown token are not colored
+  uint8_t ElementColor = Colors.empty() ? NoColor : Colors.back();
+  if (auto Token = findAttribute(Tag, ptml::attributes::Token))
+    ElementColor = tokenColor(*Token);
+
+  Colors.push_back(ElementColor);
+}
+
+void TextRenderer::handleEntity(StringRef Entity) {
+  StringRef Decoded = StringSwitch<StringRef>(Entity)
+                        .Case("lt", "<")
+                        .Case("gt", ">")
+                        .Case("amp", "&")
+                        .Case("quot", "\"")
+                        .Case("apos", "'")
+                        .Default("");
+  if (not Decoded.empty()) {
+    emitText(Decoded);
+    return;
+  }
+
+  // Numeric character reference
+  StringRef Number = Entity;
+  unsigned Radix = 10;
+  if (Number.consume_front("#")) {
+    if (Number.consume_front("x") or Number.consume_front("X"))
+      Radix = 16;
+
+    unsigned CodePoint = 0;
+    char Buffer[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+    char *End = Buffer;
+    if (not Number.getAsInteger(Radix, CodePoint)
+        and ConvertCodePointToUTF8(CodePoint, End)) {
+      emitText(StringRef(Buffer, End - Buffer));
+      return;
+    }
+  }
+
+  fail("Invalid entity: &" + Entity + ";");
+  emitText(("&" + Entity + ";").str());
+}
+
+void TextRenderer::emitText(StringRef Text) {
+  if (Text.empty())
+    return;
+
+  setColor(Colors.empty() ? NoColor : Colors.back());
+
+  if (Indent.empty()) {
+    OS << Text;
+    return;
+  }
+
+  while (not Text.empty()) {
+    auto [Line, Rest] = Text.split('\n');
+    OS << Line;
+    if (Line.size() != Text.size())
+      OS << '\n' << Indent;
+    Text = Rest;
+  }
+}
+
+void TextRenderer::setColor(uint8_t NewColor) {
+  if (not Color or NewColor == Emitted)
+    return;
+
+  if (NewColor == NoColor)
+    OS << "\x1b[0m";
+  else
+    OS << "\x1b[38;5;" << static_cast<unsigned>(NewColor) << "m";
+
+  Emitted = NewColor;
+}
+
+void TextRenderer::fail(const Twine &Message) {
+  // Report only the first error, the following ones are likely a consequence
+  if (ErrorMessage.empty())
+    ErrorMessage = Message.str();
+}
+
+} // namespace ptml
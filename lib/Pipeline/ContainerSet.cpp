@@ -89,6 +89,15 @@ llvm::Error ContainerSet::store(const revng::DirectoryPath &Directory) const {
   return Error::success();
 }
 
+llvm::StringMap<std::unique_ptr<ContainerSnapshot>>
+ContainerSet::snapshot() const {
+  llvm::StringMap<std::unique_ptr<ContainerSnapshot>> Result;
+  for (const auto &Pair : Content)
+    if (Pair.second != nullptr)
+      Result[Pair.first()] = Pair.second->snapshot();
+  return Result;
+}
+
 llvm::Error ContainerSet::load(const revng::DirectoryPath &Directory) {
   for (auto &Pair : Content) {
     revng::FilePath Filename = Directory.getFile(Pair.first());
@@ -155,6 +164,38 @@ llvm::Error ContainerBase::store(const revng::FilePath &Path) const {
   return MaybeWritableFile.get()->commit();
 }
 
+namespace {
+
+/// Snapshot holding a clone of the original container
+class ClonedContainerSnapshot : public ContainerSnapshot {
+private:
+  std::unique_ptr<ContainerBase> Clone;
+
+public:
+  explicit ClonedContainerSnapshot(std::unique_ptr<ContainerBase> Clone) :
+    Clone(std::move(Clone)) {}
+
+  llvm::Error store(const revng::FilePath &Path) const override {
+    return Clone->store(Path);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<ContainerSnapshot> ContainerBase::snapshot() const {
+  return std::make_unique<ClonedContainerSnapshot>(cloneFiltered(enumerate()));
+}
+
+llvm::Error
+SerializedContainerSnapshot::store(const revng::FilePath &Path) const {
+  auto MaybeWritableFile = Path.getWritableFile();
+  if (not MaybeWritableFile)
+    return MaybeWritableFile.takeError();
+
+  MaybeWritableFile.get()->os() << Serialized;
+  return MaybeWritableFile.get()->commit();
+}
+
 llvm::Error ContainerBase::load(const revng::FilePath &Path) {
   auto MaybeExists = Path.exists();
   if (not MaybeExists)
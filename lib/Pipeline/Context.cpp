@@ -21,7 +21,9 @@ Logger<> pipeline::CommandLogger("commands");
 Context::Context() : TheKindRegistry(Registry::registerAllKinds()) {
 }
 
-llvm::Error Context::store(const revng::DirectoryPath &Path) const {
+static llvm::Error storeContext(const revng::DirectoryPath &Path,
+                                const GlobalsMap &Globals,
+                                uint64_t CommitIndex) {
   if (auto Error = Globals.store(Path))
     return Error;
 
@@ -34,6 +36,14 @@ llvm::Error Context::store(const revng::DirectoryPath &Path) const {
   return MaybeWritableFile->get()->commit();
 }
 
+llvm::Error Context::store(const revng::DirectoryPath &Path) const {
+  return storeContext(Path, Globals, CommitIndex);
+}
+
+llvm::Error Context::Snapshot::store(const revng::DirectoryPath &Path) const {
+  return storeContext(Path, Globals, CommitIndex);
+}
+
 llvm::Error Context::load(const revng::DirectoryPath &Path) {
   if (auto Error = Globals.load(Path))
     return Error;
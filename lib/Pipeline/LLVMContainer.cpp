@@ -8,6 +8,7 @@
 //
 
 #include <memory>
+#include <optional>
 
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Constant.h"
@@ -20,6 +21,8 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/ValueMapper.h"
 
@@ -75,6 +78,7 @@ LLVMContainer::cloneFiltered(const TargetsList &Targets) const {
 
   llvm::ValueToValueMapTy Map;
 
+  materialize();
   revng::verify(Module.get());
   auto Cloned = llvm::CloneModule(*Module, Map, Filter);
 
@@ -124,6 +128,7 @@ static void fixGlobals(llvm::Module &Module,
 }
 
 void LLVMContainer::mergeBackImpl(ThisType &&OtherContainer) {
+  materialize();
   llvm::Module *ToMerge = &OtherContainer.getModule();
   revng::verify(ToMerge);
 
@@ -298,13 +303,181 @@ llvm::Error LLVMContainer::extractOne(llvm::raw_ostream &OS,
   return Module->serialize(OS);
 }
 
+TargetsList LLVMContainer::enumerate() const {
+  {
+    std::lock_guard<std::mutex> Lock(PendingMutex);
+    if (Pending != nullptr)
+      return PendingTargets;
+  }
+
+  return EnumerableContainer<ThisType>::enumerate();
+}
+
 llvm::Error LLVMContainer::serialize(llvm::raw_ostream &OS) const {
   getModule().print(OS, nullptr);
   OS.flush();
   return llvm::Error::success();
 }
 
-llvm::Error LLVMContainer::deserialize(const llvm::MemoryBuffer &Buffer) {
+// The targets of the module stored by LLVMContainer::store are listed in a
+// comment at the beginning of the file, one per line, between these two lines.
+// The last one also records the hash of the module that follows.
+static constexpr llvm::StringRef TargetsBegin = "; revng-targets-begin";
+static constexpr llvm::StringRef TargetsEnd = "; revng-targets-end ";
+
+void LLVMContainer::serializeWithTargets(llvm::raw_ostream &OS) const {
+  // If the module has never been parsed, the file we loaded is still valid
+  {
+    std::lock_guard<std::mutex> Lock(PendingMutex);
+    if (Pending != nullptr) {
+      OS << Pending->buffer().getBuffer();
+      OS.flush();
+      return;
+    }
+  }
+
+  std::string Serialized;
+  llvm::raw_string_ostream Stream(Serialized);
+  cantFail(serialize(Stream));
+  Stream.flush();
+
+  OS << TargetsBegin << "\n";
+  for (const Target &Target : enumerate())
+    OS << "; " << Target.toString() << "\n";
+  OS << TargetsEnd << llvm::format_hex(llvm::xxHash64(Serialized), 18) << "\n";
+  OS << Serialized;
+  OS.flush();
+}
+
+namespace {
+
+struct StoredModule {
+  TargetsList Targets;
+  uint64_t Hash = 0;
+  /// The module itself, i.e., what follows the list of targets
+  llvm::StringRef Body;
+};
+
+} // namespace
+
+/// Parse the list of targets at the beginning of a file written by
+/// LLVMContainer::store, if present
+static std::optional<StoredModule> parseTargets(Context &Context,
+                                                llvm::StringRef Buffer) {
+  llvm::StringRef Line, Rest;
+  std::tie(Line, Rest) = Buffer.split('\n');
+  if (Line != TargetsBegin)
+    return std::nullopt;
+
+  TargetsList::List Result;
+  while (not Rest.empty()) {
+    std::tie(Line, Rest) = Rest.split('\n');
+    if (Line.consume_front(TargetsEnd)) {
+      StoredModule Stored;
+      if (Line.getAsInteger(0, Stored.Hash))
+        return std::nullopt;
+
+      // TargetsList expects its content to be sorted and without duplicates
+      llvm::sort(Result);
+      Result.erase(std::unique(Result.begin(), Result.end()), Result.end());
+      Stored.Targets = TargetsList(std::move(Result));
+      Stored.Body = Rest;
+      return Stored;
+    }
+
+    if (not Line.consume_front("; "))
+      return std::nullopt;
+
+    auto MaybeTarget = Target::deserialize(Context, Line);
+    if (not MaybeTarget) {
+      llvm::consumeError(MaybeTarget.takeError());
+      return std::nullopt;
+    }
+
+    Result.push_back(std::move(*MaybeTarget));
+  }
+
+  return std::nullopt;
+}
+
+llvm::Error LLVMContainer::store(const revng::FilePath &Path) const {
+  auto MaybeWritableFile = Path.getWritableFile();
+  if (not MaybeWritableFile)
+    return MaybeWritableFile.takeError();
+
+  serializeWithTargets(MaybeWritableFile.get()->os());
+  return MaybeWritableFile.get()->commit();
+}
+
+llvm::Error LLVMContainer::load(const revng::FilePath &Path) {
+  auto MaybeExists = Path.exists();
+  if (not MaybeExists)
+    return MaybeExists.takeError();
+
+  if (not MaybeExists.get()) {
+    clear();
+    return llvm::Error::success();
+  }
+
+  auto MaybeFile = Path.getReadableFile();
+  if (not MaybeFile)
+    return MaybeFile.takeError();
+
+  // Only the list of targets is read here: the module is checked against its
+  // hash and parsed by ::materialize, when it is first needed
+  const llvm::MemoryBuffer &Buffer = MaybeFile.get()->buffer();
+  auto MaybeStored = parseTargets(*TheContext, Buffer.getBuffer());
+  if (not MaybeStored)
+    return deserialize(Buffer);
+
+  clear();
+  std::lock_guard<std::mutex> Lock(PendingMutex);
+  Pending = std::move(MaybeFile.get());
+  PendingTargets = std::move(MaybeStored->Targets);
+  PendingBody = MaybeStored->Body;
+  PendingHash = MaybeStored->Hash;
+  return llvm::Error::success();
+}
+
+std::unique_ptr<ContainerSnapshot> LLVMContainer::snapshot() const {
+  std::string Buffer;
+  llvm::raw_string_ostream Stream(Buffer);
+  serializeWithTargets(Stream);
+  Stream.flush();
+  return std::make_unique<SerializedContainerSnapshot>(std::move(Buffer));
+}
+
+void LLVMContainer::materialize() const {
+  std::lock_guard<std::mutex> Lock(PendingMutex);
+  if (Pending == nullptr)
+    return;
+
+  // There is no way to report an error from here: a truncated or corrupted
+  // file is detected through the hash recorded by ::store, a module that does
+  // not parse despite a matching hash is a bug
+  const llvm::MemoryBuffer &Buffer = Pending->buffer();
+  if (llvm::xxHash64(PendingBody) != PendingHash) {
+    std::string Message = "Cannot load LLVM IR module: the hash of "
+                          + Buffer.getBufferIdentifier().str()
+                          + " does not match the recorded one";
+    revng_abort(Message.c_str());
+  }
+
+  auto MaybeModule = parse(Buffer);
+  if (not MaybeModule) {
+    std::string Message = llvm::toString(MaybeModule.takeError());
+    revng_abort(Message.c_str());
+  }
+
+  Pending.reset();
+  PendingTargets = {};
+  PendingBody = {};
+  PendingHash = 0;
+  Module = std::move(*MaybeModule);
+}
+
+llvm::Expected<std::unique_ptr<llvm::Module>>
+LLVMContainer::parse(const llvm::MemoryBuffer &Buffer) const {
   llvm::SMDiagnostic Error;
   auto M = llvm::parseIR(Buffer, Error, Module->getContext());
   std::string ErrorMessage;
@@ -325,7 +498,20 @@ llvm::Error LLVMContainer::deserialize(const llvm::MemoryBuffer &Buffer) {
                                    ErrorMessage);
   }
 
-  Module = std::move(M);
+  return M;
+}
+
+llvm::Error LLVMContainer::deserialize(const llvm::MemoryBuffer &Buffer) {
+  auto MaybeModule = parse(Buffer);
+  if (not MaybeModule)
+    return MaybeModule.takeError();
+
+  std::lock_guard<std::mutex> Lock(PendingMutex);
+  Pending.reset();
+  PendingTargets = {};
+  PendingBody = {};
+  PendingHash = 0;
+  Module = std::move(*MaybeModule);
 
   return llvm::Error::success();
 }
@@ -0,0 +1,276 @@
+/// \file PipeOutputCache.cpp
+/// Memoization of the results of pipe invocations.
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <set>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Pipeline/PipeOutputCache.h"
+#include "revng/Support/CommandLine.h"
+#include "revng/Support/Debug.h"
+
+using namespace llvm;
+using namespace pipeline;
+
+static Logger<> Log("pipe-output-cache");
+
+static cl::opt<unsigned> CacheSize("pipe-output-cache-size",
+                                   cl::desc("size in MiB of the in-memory "
+                                            "cache of the results of pipe "
+                                            "invocations, 0 disables it"),
+                                   cl::cat(MainCategory),
+                                   cl::init(0));
+
+namespace {
+
+/// A stream feeding whatever is written into a SHA1
+class SHA1Stream : public raw_ostream {
+private:
+  SHA1 &Hasher;
+  uint64_t Position = 0;
+
+public:
+  explicit SHA1Stream(SHA1 &Hasher) : Hasher(Hasher) {}
+  ~SHA1Stream() override { flush(); }
+
+private:
+  void write_impl(const char *Pointer, size_t Size) override {
+    Hasher.update(StringRef(Pointer, Size));
+    Position += Size;
+  }
+
+  uint64_t current_pos() const override { return Position; }
+};
+
+} // namespace
+
+static void hashString(SHA1 &Hasher, StringRef String) {
+  uint64_t Size = String.size();
+  Hasher.update(StringRef(reinterpret_cast<const char *>(&Size), sizeof(Size)));
+  Hasher.update(String);
+}
+
+static void hashTargets(SHA1 &Hasher, const ContainerToTargetsMap &Targets) {
+  SmallVector<StringRef, 4> Names;
+  for (const auto &Entry : Targets)
+    if (not Entry.second.empty())
+      Names.push_back(Entry.first());
+  llvm::sort(Names);
+
+  for (StringRef Name : Names) {
+    hashString(Hasher, Name);
+    for (const Target &Target : Targets.at(Name))
+      hashString(Hasher, Target.toString());
+  }
+}
+
+size_t PipeOutputCache::Entry::size() const {
+  size_t Result = ReadValuesHash.size();
+  for (const auto &[Name, Content] : Containers)
+    Result += Name.size() + Content.size();
+  return Result + ReadPaths.size() * sizeof(ReadPath);
+}
+
+PipeOutputCache &PipeOutputCache::get() {
+  static PipeOutputCache Instance;
+  return Instance;
+}
+
+bool PipeOutputCache::isEnabled() const {
+  return CacheSize != 0;
+}
+
+std::string
+PipeOutputCache::computeKey(const PipeWrapper &Pipe,
+                            const ContainerSet &Input,
+                            const ContainerToTargetsMap &Slice,
+                            const ContainerToTargetsMap &Requested) const {
+  SHA1 Hasher;
+  hashString(Hasher, Pipe.Pipe->getName());
+  hashTargets(Hasher, Requested);
+  hashTargets(Hasher, Slice);
+
+  // Content of the input targets of the containers the pipe runs on
+  SHA1Stream Stream(Hasher);
+  for (const std::string &Name : Pipe.Pipe->getRunningContainersNames()) {
+    hashString(Hasher, Name);
+    if (not Input.contains(Name) or Slice.find(Name) == Slice.end())
+      continue;
+
+    const TargetsList &Targets = Slice.at(Name);
+    if (Targets.empty())
+      continue;
+
+    cantFail(Input.at(Name).cloneFiltered(Targets)->serialize(Stream));
+    Stream.flush();
+  }
+
+  return toHex(Hasher.final());
+}
+
+std::optional<std::string>
+PipeOutputCache::hashReadValues(const Context &Context,
+                                const std::vector<ReadPath> &Reads) {
+  // The same path is usually read while producing several targets
+  std::set<std::pair<StringRef, TupleTreePath>> Sorted;
+  for (const ReadPath &Read : Reads)
+    Sorted.emplace(Read.GlobalName, Read.Path);
+
+  SHA1 Hasher;
+  SHA1Stream Stream(Hasher);
+  for (const auto &[GlobalName, Path] : Sorted) {
+    auto MaybeGlobal = Context.getGlobals().get(GlobalName);
+    if (not MaybeGlobal) {
+      consumeError(MaybeGlobal.takeError());
+      return std::nullopt;
+    }
+
+    hashString(Hasher, GlobalName);
+    if (not(*MaybeGlobal)->serializeAt(Stream, Path))
+      return std::nullopt;
+    Stream.flush();
+  }
+
+  return toHex(Hasher.final());
+}
+
+bool PipeOutputCache::restore(StringRef Key,
+                              const Context &Context,
+                              PipeWrapper &Pipe,
+                              ContainerSet &Input) {
+  Statistics &Statistics = PipeStatistics[Pipe.Pipe->getName()];
+
+  auto It = Index.find(Key);
+  if (It != Index.end()) {
+    const Entry &Cached = It->second->second;
+    if (hashReadValues(Context, Cached.ReadPaths) != Cached.ReadValuesHash) {
+      ++Statistics.Invalidations;
+      erase(It);
+      It = Index.end();
+    }
+  }
+
+  if (It == Index.end()) {
+    ++Statistics.Misses;
+    revng_log(Log,
+              "Miss for " << Pipe.Pipe->getName() << " (" << Statistics.Hits
+                          << " hits, " << Statistics.Misses << " misses, "
+                          << Statistics.Invalidations << " invalidations)");
+    return false;
+  }
+
+  ++Statistics.Hits;
+  revng_log(Log,
+            "Hit for " << Pipe.Pipe->getName() << " (" << Statistics.Hits
+                       << " hits, " << Statistics.Misses << " misses, "
+                       << Statistics.Invalidations << " invalidations)");
+
+  // Mark as most recently used
+  Entries.splice(Entries.begin(), Entries, It->second);
+  const Entry &Cached = It->second->second;
+
+  for (const auto &[Name, Content] : Cached.Containers) {
+    ContainerBase &Container = Input[Name];
+    std::unique_ptr<ContainerBase> Produced = Container.cloneFiltered(TargetsList());
+    auto Buffer = MemoryBuffer::getMemBuffer(Content, Name, false);
+    cantFail(Produced->deserialize(*Buffer));
+    Container.mergeBack(std::move(*Produced));
+  }
+
+  for (const ReadPath &Read : Cached.ReadPaths)
+    Pipe.InvalidationMetadata.getPathCache(Read.GlobalName)
+      .insert(Read.Target, Read.Path);
+
+  return true;
+}
+
+void PipeOutputCache::record(std::string Key,
+                             const Context &Context,
+                             const PipeWrapper &Pipe,
+                             const ContainerSet &Output,
+                             const ContainerToTargetsMap &Produced) {
+  if (Index.count(Key) != 0)
+    return;
+
+  Entry NewEntry;
+
+  const auto &Wrapper = *Pipe.Pipe;
+  auto Names = Wrapper.getRunningContainersNames();
+  for (size_t I = 0; I < Names.size(); ++I) {
+    if (Wrapper.isContainerArgumentConst(I) or not Output.contains(Names[I]))
+      continue;
+
+    auto It = Produced.find(Names[I]);
+    if (It == Produced.end() or It->second.empty())
+      continue;
+
+    std::string Content;
+    raw_string_ostream Stream(Content);
+    const ContainerBase &Container = Output.at(Names[I]);
+    cantFail(Container.cloneFiltered(It->second)->serialize(Stream));
+    Stream.flush();
+
+    NewEntry.Containers.emplace_back(Names[I], std::move(Content));
+  }
+
+  for (const auto &[GlobalName, Bimap] :
+       Pipe.InvalidationMetadata.getPathCache()) {
+    for (const auto &[ContainerName, Targets] : Produced) {
+      for (const Target &Target : Targets) {
+        TargetInContainer Located(Target, ContainerName.str());
+        for (const TupleTreePath &Path : Bimap.getPaths(Located))
+          NewEntry.ReadPaths.push_back({ GlobalName.str(), Located, Path });
+      }
+    }
+  }
+
+  auto MaybeHash = hashReadValues(Context, NewEntry.ReadPaths);
+  if (not MaybeHash) {
+    revng_log(Log,
+              "Not caching " << Wrapper.getName()
+                             << ": cannot serialize the fields it read");
+    return;
+  }
+  NewEntry.ReadValuesHash = std::move(*MaybeHash);
+
+  size_t EntrySize = NewEntry.size();
+  if (EntrySize > size_t(CacheSize) * 1024 * 1024) {
+    revng_log(Log,
+              "Not caching " << Wrapper.getName() << ": " << EntrySize
+                             << " bytes");
+    return;
+  }
+
+  Size += EntrySize;
+  Entries.emplace_front(Key, std::move(NewEntry));
+  Index[Key] = Entries.begin();
+  evict();
+}
+
+void PipeOutputCache::clear() {
+  Entries.clear();
+  Index.clear();
+  Size = 0;
+  PipeStatistics.clear();
+}
+
+void PipeOutputCache::erase(StringMap<EntryList::iterator>::iterator It) {
+  EntryList::iterator Erased = It->second;
+  Size -= Erased->second.size();
+  Index.erase(It);
+  Entries.erase(Erased);
+}
+
+void PipeOutputCache::evict() {
+  const size_t Capacity = size_t(CacheSize) * 1024 * 1024;
+  while (Size > Capacity and not Entries.empty())
+    erase(Index.find(Entries.back().first));
+}
@@ -5,11 +5,14 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <map>
+
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Progress.h"
+#include "llvm/Support/xxhash.h"
 
 #include "revng/Pipeline/Context.h"
 #include "revng/Pipeline/Errors.h"
@@ -18,12 +21,47 @@
 #include "revng/Pipeline/Runner.h"
 #include "revng/Pipeline/Target.h"
 #include "revng/Support/Assert.h"
+#include "revng/Support/CommandLine.h"
 #include "revng/TupleTree/TupleTreeReference.h"
 
 using namespace std;
 using namespace llvm;
 using namespace pipeline;
 
+static cl::opt<bool> VerifyWrittenGlobals("verify-written-globals",
+                                          cl::desc("check that analyses do "
+                                                   "not modify the globals "
+                                                   "they do not declare as "
+                                                   "written"),
+                                          cl::cat(MainCategory),
+                                          cl::init(false));
+
+using GlobalHashes = std::map<std::string, uint64_t>;
+
+/// Hash the serialized form of the globals in \p Globals that are not in
+/// \p Names. Nothing is hashed if \p Names is std::nullopt, i.e., if all the
+/// globals are snapshotted anyway.
+static GlobalHashes
+hashOtherGlobals(const GlobalsMap &Globals,
+                 const std::optional<std::vector<std::string>> &Names) {
+  GlobalHashes Result;
+  if (not VerifyWrittenGlobals or not Names.has_value())
+    return Result;
+
+  for (const Global *G : Globals) {
+    if (llvm::is_contained(*Names, G->getName()))
+      continue;
+
+    std::string Buffer;
+    llvm::raw_string_ostream Stream(Buffer);
+    cantFail(G->serialize(Stream));
+    Stream.flush();
+    Result[G->getName().str()] = llvm::xxHash64(Buffer);
+  }
+
+  return Result;
+}
+
 class PipelineExecutionEntry {
 public:
   Step *ToExecute = nullptr;
@@ -235,6 +273,33 @@ Error Runner::storeStepToDisk(llvm::StringRef StepName,
   return Error::success();
 }
 
+Runner::Snapshot Runner::snapshot() const {
+  Snapshot Result(TheContext->snapshot());
+  for (const auto &Step : Steps)
+    Result.Steps.try_emplace(Step.first(), Step.second.snapshot());
+  return Result;
+}
+
+Error Runner::Snapshot::store(const revng::DirectoryPath &DirPath) const {
+  if (auto Error = DirPath.create())
+    return Error;
+
+  for (const auto &Step : Steps) {
+    revng::DirectoryPath StepDir = DirPath.getDirectory(Step.first());
+    if (auto Error = StepDir.create())
+      return Error;
+
+    if (auto Error = Step.second.store(StepDir))
+      return Error;
+  }
+
+  revng::DirectoryPath ContextDir = DirPath.getDirectory("context");
+  if (auto Error = ContextDir.create())
+    return Error;
+
+  return TheContext.store(ContextDir);
+}
+
 Error Runner::load(const revng::DirectoryPath &DirPath) {
   revng::DirectoryPath ContextDir = DirPath.getDirectory("context");
   if (auto Error = TheContext->load(ContextDir); !!Error)
@@ -273,9 +338,6 @@ Runner::runAnalysis(llvm::StringRef AnalysisName,
                     const ContainerToTargetsMap &Targets,
                     TargetInStepSet &InvalidationsMap,
                     const llvm::StringMap<std::string> &Options) {
-
-  GlobalsMap Before = getContext().getGlobals();
-
   auto MaybeStep = Steps.find(StepName);
 
   if (MaybeStep == Steps.end()) {
@@ -284,6 +346,19 @@ Runner::runAnalysis(llvm::StringRef AnalysisName,
                              StepName.str().c_str());
   }
 
+  if (not MaybeStep->second.hasAnalysis(AnalysisName)) {
+    return createStringError(inconvertibleErrorCode(),
+                             "Could not find an analysis named %s\n",
+                             AnalysisName.str().c_str());
+  }
+
+  // Snapshot only the globals the analysis might change
+  const AnalysisWrapper &Analysis = MaybeStep->second.getAnalysis(AnalysisName);
+  OptionalNames WrittenGlobals = Analysis->getWrittenGlobals();
+  GlobalsMap Before = snapshotGlobals(WrittenGlobals);
+  GlobalHashes OtherBefore = hashOtherGlobals(getContext().getGlobals(),
+                                              WrittenGlobals);
+
   Task T(3, "Analysis execution");
   T.advance("Produce step " + StepName, true);
   if (llvm::Error Error = run(StepName, Targets))
@@ -299,6 +374,12 @@ Runner::runAnalysis(llvm::StringRef AnalysisName,
 
   T.advance("Apply diff produced by the analysis", true);
   const GlobalsMap &After = getContext().getGlobals();
+  if (VerifyWrittenGlobals) {
+    revng_check(OtherBefore == hashOtherGlobals(After, WrittenGlobals),
+                "The analysis modified a global it does not declare as "
+                "written");
+  }
+
   DiffMap Map = Before.diff(After);
   for (const auto &GlobalNameDiffPair : Map)
     if (llvm::Error Error = apply(GlobalNameDiffPair.second, InvalidationsMap))
@@ -307,12 +388,36 @@ Runner::runAnalysis(llvm::StringRef AnalysisName,
   return std::move(Map);
 }
 
+GlobalsMap Runner::snapshotGlobals(const OptionalNames &Names) const {
+  if (Names.has_value())
+    return getContext().getGlobals().cloneFiltered(*Names);
+  else
+    return getContext().getGlobals();
+}
+
 /// Run all analysis in reverse post order (that is: parents first),
 llvm::Expected<DiffMap>
 Runner::runAnalyses(const AnalysesList &List,
                     TargetInStepSet &InvalidationsMap,
                     const llvm::StringMap<std::string> &Options) {
-  GlobalsMap Before = getContext().getGlobals();
+  // Snapshot only the globals that at least one analysis might change
+  OptionalNames WrittenGlobals;
+  WrittenGlobals.emplace();
+  for (const AnalysisReference &Ref : List) {
+    const Step &Step = getStep(Ref.getStepName());
+    const AnalysisWrapper &Analysis = Step.getAnalysis(Ref.getAnalysisName());
+    auto AnalysisWrittenGlobals = Analysis->getWrittenGlobals();
+    if (not AnalysisWrittenGlobals.has_value()) {
+      WrittenGlobals.reset();
+      break;
+    }
+
+    for (std::string &Name : *AnalysisWrittenGlobals)
+      if (not llvm::is_contained(*WrittenGlobals, Name))
+        WrittenGlobals->push_back(std::move(Name));
+  }
+
+  GlobalsMap Before = snapshotGlobals(WrittenGlobals);
 
   Task T(List.size() + 1, "Analysis list " + List.getName());
   for (const AnalysisReference &Ref : List) {
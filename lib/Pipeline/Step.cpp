@@ -15,6 +15,7 @@
 #include "revng/Pipeline/ContainerSet.h"
 #include "revng/Pipeline/Context.h"
 #include "revng/Pipeline/Errors.h"
+#include "revng/Pipeline/PipeOutputCache.h"
 #include "revng/Pipeline/Step.h"
 #include "revng/Pipeline/Target.h"
 #include "revng/Support/Assert.h"
@@ -282,18 +283,40 @@ ContainerSet Step::run(ContainerSet &&Input,
   ContainerToTargetsMap InputEnumeration = Input.enumerate();
   explainStartStep(InputEnumeration);
 
+  PipeOutputCache &Cache = PipeOutputCache::get();
   Task T(Pipes.size() + 1, "Step " + getName());
   for (const auto &[Pipe, Info] : llvm::zip(Pipes, ExecutionInfos)) {
     T.advance(Pipe.Pipe->getName(), false);
     explainExecutedPipe(*Pipe.Pipe);
 
-    ExecutionContext EC(*TheContext, &Pipe, Info.Output);
+    // The cache must be queried before the execution context starts tracking
+    // the fields read from the globals
+    std::string Key;
+    if (Cache.isEnabled()) {
+      ContainerToTargetsMap Requested = Info.Output;
+      Pipe.Pipe->deduceResults(*TheContext, Requested);
+      Key = Cache.computeKey(Pipe, Input, Info.Input, Requested);
+      if (Cache.restore(Key, *TheContext, Pipe, Input)) {
+        llvm::cantFail(Input.verify());
+        continue;
+      }
+    }
+
+    ContainerToTargetsMap Produced;
+    {
+      ExecutionContext EC(*TheContext, &Pipe, Info.Output);
 
-    Pipe.Pipe->deduceResults(*TheContext, EC.getCurrentRequestedTargets());
+      Pipe.Pipe->deduceResults(*TheContext, EC.getCurrentRequestedTargets());
 
-    cantFail(Pipe.Pipe->run(EC, Input));
-    llvm::cantFail(Input.verify());
-    EC.verify();
+      cantFail(Pipe.Pipe->run(EC, Input));
+      llvm::cantFail(Input.verify());
+      EC.verify();
+
+      Produced = EC.getCurrentRequestedTargets();
+    }
+
+    if (Cache.isEnabled())
+      Cache.record(std::move(Key), *TheContext, Pipe, Input, Produced);
   }
 
   T.advance("Merging back", true);
@@ -372,11 +395,44 @@ Error Step::invalidate(const ContainerToTargetsMap &ToRemove) {
   return containers().remove(ToRemove);
 }
 
+static Error
+storeInvalidationMetadata(const revng::DirectoryPath &Path,
+                          const llvm::StringMap<std::string> &Metadata) {
+  for (const auto &Entry : Metadata) {
+    auto File = Path.getFile(Entry.first().str() + ".cache").getWritableFile();
+    if (not File)
+      return File.takeError();
+
+    File->get()->os() << Entry.second;
+    if (auto Error = File->get()->commit())
+      return Error;
+  }
+
+  return llvm::Error::success();
+}
+
 Error Step::store(const revng::DirectoryPath &DirPath) const {
   if (auto Error = Containers.store(DirPath))
     return Error;
 
-  return storeInvalidationMetadata(DirPath);
+  return storeInvalidationMetadata(DirPath, serializeInvalidationMetadata());
+}
+
+Step::Snapshot Step::snapshot() const {
+  Snapshot Result;
+  Result.Containers = Containers.snapshot();
+  Result.InvalidationMetadata = serializeInvalidationMetadata();
+  return Result;
+}
+
+Error Step::Snapshot::store(const revng::DirectoryPath &DirPath) const {
+  for (const auto &Entry : Containers) {
+    revng::FilePath Filename = DirPath.getFile(Entry.first());
+    if (auto Error = Entry.second->store(Filename))
+      return Error;
+  }
+
+  return storeInvalidationMetadata(DirPath, InvalidationMetadata);
 }
 
 Error Step::checkPrecondition() const {
@@ -454,8 +510,8 @@ llvm::Error Step::loadInvalidationMetadata(const revng::DirectoryPath &Path) {
   return llvm::Error::success();
 }
 
-llvm::Error
-Step::storeInvalidationMetadata(const revng::DirectoryPath &Path) const {
+llvm::StringMap<std::string> Step::serializeInvalidationMetadata() const {
+  llvm::StringMap<std::string> Result;
   for (auto &Container : Containers) {
     if (Container.second == nullptr)
       continue;
@@ -484,16 +540,12 @@ Step::storeInvalidationMetadata(const revng::DirectoryPath &Path) const {
       ToStore.emplace_back(std::move(Entry));
     }
 
-    auto File = Path.getFile(Container.first().str() + ".cache")
-                  .getWritableFile();
-    if (not File)
-      return File.takeError();
-    ::serialize(File->get()->os(), ToStore);
-    if (auto Error = File->get()->commit())
-      return Error;
+    llvm::raw_string_ostream Stream(Result[Container.first()]);
+    ::serialize(Stream, ToStore);
+    Stream.flush();
   }
 
-  return llvm::Error::success();
+  return Result;
 }
 
 std::vector<revng::FilePath>
@@ -20,6 +20,7 @@
 #include "llvm/Support/PluginLoader.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "revng/PTML/TextRenderer.h"
 #include "revng/Pipeline/AllRegistries.h"
 #include "revng/Pipeline/Container.h"
 #include "revng/Pipeline/Runner.h"
@@ -240,6 +241,24 @@ static bool _rp_manager_save(rp_manager *manager) {
   return false;
 }
 
+static rp_snapshot *_rp_manager_snapshot(rp_manager *manager) {
+  revng_check(manager != nullptr);
+  return new rp_snapshot(manager->snapshot());
+}
+
+static bool _rp_manager_save_snapshot(rp_manager *manager,
+                                      rp_snapshot *snapshot) {
+  revng_check(manager != nullptr);
+  revng_check(snapshot != nullptr);
+
+  auto Error = manager->storeSnapshot(std::move(*snapshot));
+  if (not Error)
+    return true;
+
+  llvm::consumeError(std::move(Error));
+  return false;
+}
+
 static void _rp_manager_destroy(rp_manager *manager) {
   revng_check(manager != nullptr);
   delete manager;
@@ -679,11 +698,36 @@ static const char *_rp_buffer_data(const rp_buffer *buffer) {
   return buffer->data();
 }
 
+static void _rp_snapshot_destroy(rp_snapshot *snapshot) {
+  revng_check(snapshot != nullptr);
+  delete snapshot;
+}
+
 static void _rp_buffer_destroy(rp_buffer *buffer) {
   revng_check(buffer != nullptr);
   delete buffer;
 }
 
+static rp_buffer *_rp_ptml_render(uint64_t content_size,
+                                  const char *content,
+                                  uint8_t color,
+                                  const char *indent,
+                                  rp_error *error) {
+  revng_check(content != nullptr);
+  revng_check(indent != nullptr);
+
+  auto Out = std::make_unique<rp_buffer>();
+  llvm::raw_svector_ostream OS(*Out);
+  llvm::StringRef Content(content, content_size);
+  bool Color = color != 0;
+  if (auto Error = ptml::TextRenderer::render(OS, Content, Color, indent)) {
+    llvmErrorToRpError(std::move(Error), error);
+    return nullptr;
+  }
+
+  return Out.release();
+}
+
 static rp_container_targets_map *_rp_container_targets_map_create() {
   return new ContainerToTargetsMap();
 }
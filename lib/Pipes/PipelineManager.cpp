@@ -330,23 +330,67 @@ llvm::Error PipelineManager::store() {
   if (StorageClient == nullptr)
     return llvm::Error::success();
 
+  std::lock_guard Lock(*StorageMutex);
+
   // Run store on the runner, this will serialize all step/containers
   // inside the resume directory
   if (auto Error = Runner->store(ExecutionDirectory))
     return Error;
 
   // Commit all the changes to storage
-  return StorageClient->commit();
+  if (auto Error = StorageClient->commit())
+    return Error;
+
+  LastStoredCommitIndex = PipelineContext->getCommitIndex();
+  return llvm::Error::success();
 }
 
 llvm::Error PipelineManager::storeStepToDisk(llvm::StringRef StepName) {
   if (StorageClient == nullptr)
     return llvm::Error::success();
 
+  std::lock_guard Lock(*StorageMutex);
+
   auto &Step = Runner->getStep(StepName);
   if (auto Error = Runner->storeStepToDisk(StepName, ExecutionDirectory))
     return Error;
-  return StorageClient->commit();
+
+  if (auto Error = StorageClient->commit())
+    return Error;
+
+  StepStoredCommitIndex[StepName] = PipelineContext->getCommitIndex();
+  return llvm::Error::success();
+}
+
+pipeline::Runner::Snapshot PipelineManager::snapshot() const {
+  return Runner->snapshot();
+}
+
+llvm::Error
+PipelineManager::storeSnapshot(pipeline::Runner::Snapshot &&Snapshot) {
+  if (StorageClient == nullptr)
+    return llvm::Error::success();
+
+  std::lock_guard Lock(*StorageMutex);
+
+  uint64_t CommitIndex = Snapshot.getCommitIndex();
+  if (CommitIndex < LastStoredCommitIndex)
+    return llvm::Error::success();
+
+  // Steps stored on their own after the snapshot has been taken are more
+  // recent than their counterpart in the snapshot
+  for (const auto &Entry : StepStoredCommitIndex)
+    if (Entry.second > CommitIndex)
+      Snapshot.dropStep(Entry.first());
+
+  if (auto Error = Snapshot.store(ExecutionDirectory))
+    return Error;
+
+  if (auto Error = StorageClient->commit())
+    return Error;
+
+  LastStoredCommitIndex = CommitIndex;
+  return llvm::Error::success();
 }
 
 llvm::Expected<TargetInStepSet>
@@ -367,10 +411,13 @@ PipelineManager::deserializeContainer(pipeline::Step &Step,
   if (not MaybeInvalidations)
     return MaybeInvalidations.takeError();
 
+  // Bump the commit index first, so that the stored step is recognized as
+  // more recent than any snapshot taken before this point
+  PipelineContext->bumpCommitIndex();
+
   if (auto Error = storeStepToDisk(Step.getName()); !!Error)
     return Error;
 
-  PipelineContext->bumpCommitIndex();
   return MaybeInvalidations.get();
 }
 
@@ -605,5 +652,6 @@ PipelineManager::setStorageCredentials(llvm::StringRef Credentials) {
                                    "Client missing");
   }
 
+  std::lock_guard Lock(*StorageMutex);
   return StorageClient->setCredentials(Credentials);
 }
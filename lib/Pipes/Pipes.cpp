@@ -34,11 +34,23 @@
 #include "revng/Pipes/FileContainer.h"
 #include "revng/Pipes/ModelGlobal.h"
 #include "revng/Pipes/RootKind.h"
+#include "revng/Pipes/StringMap.h"
 #include "revng/Recompile/CompileModulePipe.h"
 #include "revng/Support/Statistics.h"
 
 using namespace std;
 using namespace pipeline;
+
+llvm::cl::opt<bool> CacheCompressedStringMaps("cache-compressed-string-maps",
+                                              llvm::cl::desc("Keep the "
+                                                             "compressed "
+                                                             "entries of "
+                                                             "string maps in "
+                                                             "memory to avoid "
+                                                             "compressing "
+                                                             "them again"),
+                                              llvm::cl::init(false));
+
 using namespace ::revng::pipes;
 using namespace ::revng::kinds;
 
@@ -0,0 +1,238 @@
+/// \file IndirectJumpInlineCaches.cpp
+/// Emit per-site inline caches for the indirect jumps of the code that is going
+/// to be recompiled.
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+
+#include "revng/BasicAnalyses/GeneratedCodeBasicInfo.h"
+#include "revng/Recompile/IndirectJumpInlineCaches.h"
+#include "revng/Support/CommandLine.h"
+#include "revng/Support/Debug.h"
+#include "revng/Support/IRHelpers.h"
+
+using namespace llvm;
+
+static Logger<> Log("inline-cache");
+
+static constexpr unsigned MaxInlineCacheSize = 4;
+
+/// Parser rejecting cache sizes we do not support as soon as they are parsed
+struct InlineCacheSizeParser : public cl::parser<unsigned> {
+  using cl::parser<unsigned>::parser;
+
+  bool
+  parse(cl::Option &O, StringRef ArgName, StringRef Arg, unsigned &Result) {
+    if (cl::parser<unsigned>::parse(O, ArgName, Arg, Result))
+      return true;
+
+    if (Result > MaxInlineCacheSize)
+      return O.error("the maximum inline cache size is "
+                     + Twine(MaxInlineCacheSize));
+
+    return false;
+  }
+};
+
+using InlineCacheSizeOption = cl::opt<unsigned, false, InlineCacheSizeParser>;
+static InlineCacheSizeOption InlineCacheSize("indirect-jump-inline-cache-size",
+                                             cl::desc("number of targets to "
+                                                      "cache at each indirect "
+                                                      "jump of recompiled "
+                                                      "code, 0 disables inline "
+                                                      "caches."),
+                                             cl::cat(MainCategory),
+                                             cl::init(0));
+
+char IndirectJumpInlineCachesPass::ID = 0;
+
+using Register = RegisterPass<IndirectJumpInlineCachesPass>;
+static Register X("indirect-jump-inline-caches",
+                  "Indirect Jump Inline Caches Pass",
+                  false,
+                  false);
+
+void IndirectJumpInlineCachesPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<GeneratedCodeBasicInfoWrapperPass>();
+}
+
+bool IndirectJumpInlineCachesPass::runOnModule(Module &M) {
+  if (InlineCacheSize == 0)
+    return false;
+
+  revng_assert(InlineCacheSize <= MaxInlineCacheSize);
+
+  auto &GCBI = getAnalysis<GeneratedCodeBasicInfoWrapperPass>().getGCBI();
+  Function *Root = GCBI.root();
+  BasicBlock *AnyPC = GCBI.anyPC();
+  if (Root == nullptr or AnyPC == nullptr)
+    return false;
+
+  // Collect the indirect jumps of the translated code
+  SmallVector<BranchInst *, 16> Sites;
+  SmallPtrSet<BasicBlock *, 16> Visited;
+  for (BasicBlock *Predecessor : predecessors(AnyPC)) {
+    if (not Visited.insert(Predecessor).second)
+      continue;
+
+    if (not GeneratedCodeBasicInfo::isTranslated(Predecessor))
+      continue;
+
+    auto *Branch = dyn_cast<BranchInst>(Predecessor->getTerminator());
+    if (Branch != nullptr and Branch->isUnconditional())
+      Sites.push_back(Branch);
+  }
+
+  if (Sites.empty())
+    return false;
+
+  LLVMContext &Context = M.getContext();
+  const ProgramCounterHandler *PCH = GCBI.programCounterHandler();
+  const auto &JumpTargets = GCBI.jumpTargets();
+  constexpr auto IBDHB = BlockType::IndirectBranchDispatcherHelperBlock;
+  auto *PCType = IntegerType::get(Context, 128);
+  auto *PointerType = Type::getInt8PtrTy(Context);
+  auto *AnyPCAddress = BlockAddress::get(Root, AnyPC);
+
+  auto CreateVariable = [&M](Type *T,
+                             Constant *Initializer,
+                             const Twine &Name) {
+    return new GlobalVariable(M,
+                              T,
+                              false,
+                              GlobalValue::InternalLinkage,
+                              Initializer,
+                              Name);
+  };
+
+  auto CreateBlock = [&Context, Root](const Twine &Name) {
+    return BasicBlock::Create(Context, Name, Root);
+  };
+
+  // The target found by a lookup and the site to return to afterwards. They are
+  // local to root, hence each invocation (and thread) has its own.
+  IRBuilder<> Builder(&*Root->getEntryBlock().getFirstInsertionPt());
+  auto *Target = Builder.CreateAlloca(PointerType, nullptr, "ic.target");
+  auto *Return = Builder.CreateAlloca(PointerType, nullptr, "ic.return");
+
+  //
+  // Create the lookup dispatcher: each case records the address of the jump
+  // target and goes back to the site that missed
+  //
+  BasicBlock *Resolved = CreateBlock("ic.resolved");
+  Builder.SetInsertPoint(Resolved);
+  auto *ResolvedInstruction = Builder.CreateIndirectBr(createLoad(Builder,
+                                                                  Return),
+                                                       Sites.size());
+  setBlockType(ResolvedInstruction, IBDHB);
+
+  auto CreateResolveBlock = [&](BasicBlock *Destination) {
+    BasicBlock *Result = CreateBlock("ic.resolve");
+    IRBuilder<> ResolveBuilder(Result);
+    ResolveBuilder.CreateStore(BlockAddress::get(Root, Destination), Target);
+    setBlockType(ResolveBuilder.CreateBr(Resolved), IBDHB);
+    return Result;
+  };
+
+  ProgramCounterHandler::DispatcherTargets Targets;
+  for (auto &[PC, Head] : JumpTargets)
+    Targets.emplace_back(PC, CreateResolveBlock(Head));
+
+  // Unknown targets are cached too: they go to AnyPC
+  BasicBlock *Lookup = CreateBlock("ic.lookup");
+  PCH->buildDispatcher(Targets, Lookup, CreateResolveBlock(AnyPC), IBDHB);
+
+  //
+  // Emit the cache of each site
+  //
+  unsigned SiteIndex = 0;
+  for (BranchInst *Branch : Sites) {
+    std::string Prefix = "revng.ic." + std::to_string(SiteIndex);
+
+    // Entries are zero-initialized: an invalid PC is never composed to zero
+    SmallVector<GlobalVariable *, MaxInlineCacheSize> CachedPCs;
+    SmallVector<GlobalVariable *, MaxInlineCacheSize> CachedTargets;
+    for (unsigned I = 0; I < InlineCacheSize; ++I) {
+      std::string Suffix = "." + std::to_string(I);
+      CachedPCs.push_back(CreateVariable(PCType,
+                                         ConstantInt::get(PCType, 0),
+                                         Prefix + ".pc" + Suffix));
+      CachedTargets.push_back(CreateVariable(PointerType,
+                                             AnyPCAddress,
+                                             Prefix + ".target" + Suffix));
+    }
+
+    // Each site has its own indirectbr, reachable from its hits and from its
+    // fill block, so that the branch predictor can track each site separately
+    BasicBlock *Jump = CreateBlock("ic.jump");
+    IRBuilder<> JumpBuilder(Jump);
+    PHINode *JumpTarget = JumpBuilder.CreatePHI(PointerType,
+                                                InlineCacheSize + 1);
+    auto *JumpInstruction = JumpBuilder.CreateIndirectBr(JumpTarget,
+                                                         JumpTargets.size()
+                                                           + 1);
+    JumpInstruction->addDestination(AnyPC);
+    for (auto &[PC, Head] : JumpTargets)
+      JumpInstruction->addDestination(Head);
+    setBlockType(JumpInstruction, IBDHB);
+
+    // Probe the entries in order
+    BasicBlock *Miss = CreateBlock("ic.miss");
+    Builder.SetInsertPoint(Branch);
+    Value *CurrentPC = PCH->composeIntegerPC(Builder);
+    for (unsigned I = 0; I < InlineCacheSize; ++I) {
+      BasicBlock *Hit = CreateBlock("ic.hit");
+      BasicBlock *Next = I + 1 == InlineCacheSize ? Miss : CreateBlock("");
+      auto *IsHit = Builder.CreateICmpEQ(CurrentPC,
+                                         createLoad(Builder, CachedPCs[I]));
+      auto *Probe = Builder.CreateCondBr(IsHit, Hit, Next);
+      if (I != 0)
+        setBlockType(Probe, IBDHB);
+
+      IRBuilder<> HitBuilder(Hit);
+      JumpTarget->addIncoming(createLoad(HitBuilder, CachedTargets[I]), Hit);
+      setBlockType(HitBuilder.CreateBr(Jump), IBDHB);
+
+      Builder.SetInsertPoint(Next);
+    }
+    eraseFromParent(Branch);
+
+    // On a miss, perform the lookup and come back to fill the cache
+    BasicBlock *Fill = CreateBlock("ic.fill");
+    Builder.CreateStore(BlockAddress::get(Root, Fill), Return);
+    setBlockType(Builder.CreateBr(Lookup), IBDHB);
+    ResolvedInstruction->addDestination(Fill);
+
+    // Evict the oldest entry and record the new one as the first
+    Builder.SetInsertPoint(Fill);
+    for (unsigned I = InlineCacheSize - 1; I > 0; --I) {
+      Builder.CreateStore(createLoad(Builder, CachedPCs[I - 1]), CachedPCs[I]);
+      Builder.CreateStore(createLoad(Builder, CachedTargets[I - 1]),
+                          CachedTargets[I]);
+    }
+    Value *Resolution = createLoad(Builder, Target);
+    Builder.CreateStore(PCH->composeIntegerPC(Builder), CachedPCs[0]);
+    Builder.CreateStore(Resolution, CachedTargets[0]);
+    JumpTarget->addIncoming(Resolution, Fill);
+    setBlockType(Builder.CreateBr(Jump), IBDHB);
+
+    ++SiteIndex;
+  }
+
+  revng_log(Log,
+            "Emitted " << SiteIndex << " inline caches of size "
+                       << InlineCacheSize);
+
+  return true;
+}
@@ -0,0 +1,200 @@
+/// \file InlineSmallHelpers.cpp
+/// Inline small QEMU helpers into the code that is going to be recompiled.
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include "revng/Recompile/InlineSmallHelpers.h"
+#include "revng/Support/CommandLine.h"
+#include "revng/Support/Debug.h"
+#include "revng/Support/FunctionTags.h"
+#include "revng/Support/IRHelpers.h"
+
+using namespace llvm;
+
+static Logger<> Log("inline-helpers");
+
+static cl::opt<unsigned> SizeThreshold("inline-helpers-size-threshold",
+                                       cl::desc("maximum number of "
+                                                "instructions of a helper to "
+                                                "inline in recompiled code"),
+                                       cl::cat(MainCategory),
+                                       cl::init(40));
+
+static cl::opt<unsigned> Budget("inline-helpers-budget",
+                                cl::desc("maximum number of instructions "
+                                         "inlining helpers is allowed to add "
+                                         "to recompiled code, 0 disables "
+                                         "helper inlining"),
+                                cl::cat(MainCategory),
+                                cl::init(1000000));
+
+char InlineSmallHelpersPass::ID = 0;
+
+using Register = RegisterPass<InlineSmallHelpersPass>;
+static Register X("inline-small-helpers",
+                  "Inline Small Helpers Pass",
+                  false,
+                  false);
+
+static unsigned instructionsCount(const Function &F) {
+  unsigned Result = 0;
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB)
+      if (not I.isDebugOrPseudoInst())
+        ++Result;
+  return Result;
+}
+
+namespace {
+
+struct Candidate {
+  Function *Helper = nullptr;
+  unsigned Size = 0;
+  SmallVector<CallInst *, 8> CallSites;
+
+  /// Number of instructions inlining all the call sites adds to the module
+  uint64_t cost() const { return uint64_t(Size) * CallSites.size(); }
+};
+
+} // namespace
+
+static bool isCandidate(const Function *F,
+                        const SmallPtrSetImpl<const Function *> &Recursive) {
+  if (F == nullptr or F->isDeclaration() or F->isVarArg())
+    return false;
+
+  if (not FunctionTags::Helper.isTagOf(F)
+      or FunctionTags::Exceptional.isTagOf(F)
+      or F->hasFnAttribute(Attribute::NoReturn)
+      or F->hasFnAttribute(Attribute::NoInline)
+      or F->hasFnAttribute(Attribute::AlwaysInline))
+    return false;
+
+  // Recursive helpers cannot be fully inlined
+  return not Recursive.contains(F);
+}
+
+bool InlineSmallHelpersPass::runOnModule(Module &M) {
+  if (Budget == 0)
+    return false;
+
+  SmallPtrSet<const Function *, 8> Recursive;
+  {
+    CallGraph CG(M);
+    for (auto It = scc_begin(&CG), End = scc_end(&CG); It != End; ++It)
+      if (It.hasCycle())
+        for (CallGraphNode *Node : *It)
+          if (const Function *F = Node->getFunction())
+            Recursive.insert(F);
+  }
+
+  // Collect the call sites in the code we're going to recompile
+  DenseMap<Function *, unsigned> CandidateIndex;
+  std::vector<Candidate> Candidates;
+  for (Function &F : M) {
+    if (not isRootOrLifted(&F) and not FunctionTags::IsolatedRoot.isTagOf(&F))
+      continue;
+
+    for (BasicBlock &BB : F) {
+      for (Instruction &I : BB) {
+        auto *Call = dyn_cast<CallInst>(&I);
+        if (Call == nullptr)
+          continue;
+
+        Function *Callee = getCalledFunction(Call);
+        if (not isCandidate(Callee, Recursive))
+          continue;
+
+        auto [It, New] = CandidateIndex.try_emplace(Callee, Candidates.size());
+        if (New)
+          Candidates.push_back({ Callee, instructionsCount(*Callee), {} });
+
+        Candidates[It->second].CallSites.push_back(Call);
+      }
+    }
+  }
+
+  // Prefer small helpers, then the most called ones
+  llvm::stable_sort(Candidates,
+                    [](const Candidate &LHS, const Candidate &RHS) {
+                      if (LHS.Size != RHS.Size)
+                        return LHS.Size < RHS.Size;
+                      return LHS.CallSites.size() > RHS.CallSites.size();
+                    });
+
+  bool Changed = false;
+  uint64_t Remaining = Budget;
+  unsigned InlinedHelpers = 0;
+  unsigned InlinedCallSites = 0;
+  for (Candidate &C : Candidates) {
+    std::string Name = C.Helper->getName().str();
+
+    if (C.Size > SizeThreshold) {
+      revng_log(Log,
+                "Leaving " << Name << " (" << C.Size << " instructions, "
+                           << C.CallSites.size()
+                           << " call sites) to the optimizer: too large");
+      continue;
+    }
+
+    if (C.cost() > Remaining) {
+      revng_log(Log,
+                "Not inlining " << Name << " (" << C.Size << " instructions, "
+                                << C.CallSites.size()
+                                << " call sites): out of budget");
+      C.Helper->addFnAttr(Attribute::NoInline);
+      Changed = true;
+      continue;
+    }
+
+    unsigned Inlined = 0;
+    for (CallInst *Call : C.CallSites) {
+      InlineFunctionInfo IFI;
+      InlineResult Result = InlineFunction(*Call, IFI);
+      if (Result.isSuccess()) {
+        ++Inlined;
+      } else {
+        revng_log(Log,
+                  "Cannot inline " << Name << ": "
+                                   << Result.getFailureReason());
+      }
+    }
+
+    revng_log(Log,
+              "Inlined " << Name << " (" << C.Size << " instructions) in "
+                         << Inlined << " call sites out of "
+                         << C.CallSites.size());
+
+    Remaining -= uint64_t(C.Size) * Inlined;
+    InlinedCallSites += Inlined;
+    if (Inlined != 0) {
+      ++InlinedHelpers;
+      Changed = true;
+    }
+
+    // Helpers are internal, drop the ones that are no longer used
+    if (C.Helper->use_empty() and C.Helper->hasLocalLinkage())
+      eraseFromParent(C.Helper);
+  }
+
+  revng_log(Log,
+            "Inlined " << InlinedHelpers << " helpers out of "
+                       << Candidates.size() << " in " << InlinedCallSites
+                       << " call sites, " << (Budget - Remaining)
+                       << " instructions added");
+
+  return Changed;
+}
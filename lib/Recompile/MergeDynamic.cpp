@@ -0,0 +1,906 @@
+/// \file MergeDynamic.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/Object/ELF.h"
+#include "llvm/Support/MathExtras.h"
+
+#include "revng/Recompile/MergeDynamic.h"
+#include "revng/Support/Assert.h"
+#include "revng/Support/Debug.h"
+
+using namespace llvm;
+using namespace llvm::object;
+
+static Logger<> Log("merge-dynamic");
+
+static constexpr uint64_t PageSize = 0x1000;
+
+/// The hash function of `DT_HASH` tables, as implemented by the loader
+static uint32_t elfHash(StringRef Name) {
+  uint32_t Hash = 0;
+  for (uint8_t Character : Name.bytes()) {
+    Hash = (Hash << 4) + Character;
+    uint32_t High = Hash & 0xf0000000;
+    Hash ^= High >> 24;
+    Hash &= ~High;
+  }
+  return Hash;
+}
+
+/// Pick the number of buckets of a `DT_HASH` table, the same way GNU ld does
+static uint32_t bucketsCount(size_t SymbolsCount) {
+  static constexpr uint32_t Sizes[] = { 1,     3,     17,    37,     67,
+                                        97,    131,   197,   263,    521,
+                                        1031,  2053,  4099,  8209,   16411,
+                                        32771, 65537, 131101, 262147 };
+  uint32_t Result = Sizes[0];
+  for (uint32_t Size : Sizes) {
+    if (Size > SymbolsCount)
+      break;
+    Result = Size;
+  }
+  return Result;
+}
+
+/// A growing buffer where the new tables are laid out
+class Table {
+private:
+  std::vector<uint8_t> Data;
+
+public:
+  uint64_t size() const { return Data.size(); }
+  ArrayRef<uint8_t> data() const { return Data; }
+
+public:
+  /// Pad to \p Alignment
+  ///
+  /// \return the new size
+  uint64_t align(uint64_t Alignment) {
+    Data.resize(alignTo(Data.size(), Alignment), 0);
+    return Data.size();
+  }
+
+  void appendBytes(ArrayRef<uint8_t> Bytes) {
+    Data.insert(Data.end(), Bytes.begin(), Bytes.end());
+  }
+
+  template<typename T>
+  void append(const T &Value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto *Begin = reinterpret_cast<const uint8_t *>(&Value);
+    Data.insert(Data.end(), Begin, Begin + sizeof(T));
+  }
+};
+
+template<typename T>
+static Expected<std::vector<T>> parseArray(ArrayRef<uint8_t> Bytes) {
+  if (Bytes.size() % sizeof(T) != 0)
+    return createError("Table size is not a multiple of the entry size");
+
+  std::vector<T> Result(Bytes.size() / sizeof(T));
+  if (not Bytes.empty())
+    std::memcpy(Result.data(), Bytes.data(), Bytes.size());
+  return Result;
+}
+
+/// A relocation, independently of its being `Elf_Rel` or `Elf_Rela`
+struct Relocation {
+  uint64_t Offset = 0;
+  uint32_t Symbol = 0;
+  uint32_t Type = 0;
+  int64_t Addend = 0;
+};
+
+/// The portions of an ELF relevant for the dynamic loader
+template<typename ELFT>
+class DynamicELF {
+public:
+  LLVM_ELF_IMPORT_TYPES_ELFT(ELFT)
+
+  struct VersionNeed {
+    Elf_Verneed Need;
+    SmallVector<Elf_Vernaux, 4> Auxiliaries;
+  };
+
+public:
+  StringRef Buffer;
+  ELFFile<ELFT> File;
+  ArrayRef<Elf_Phdr> Segments;
+  ArrayRef<Elf_Shdr> Sections;
+
+  /// The entries of `.dynamic`, up to and including `DT_NULL`. Empty if the
+  /// ELF is not dynamic.
+  SmallVector<Elf_Dyn, 32> DynamicEntries;
+
+  /// Value of each tag in `.dynamic`, for those appearing more than once (e.g.,
+  /// `DT_NEEDED`), the first one
+  DenseMap<int64_t, uint64_t> Tags;
+
+  bool IsRela = false;
+  ArrayRef<uint8_t> Dynstr;
+  ArrayRef<uint8_t> Dynsym;
+  ArrayRef<uint8_t> RelDyn;
+  ArrayRef<uint8_t> Versym;
+
+  /// `DT_JMPREL` relocations followed by `DT_REL`/`DT_RELA` relocations
+  std::vector<Relocation> Relocations;
+  std::vector<Elf_Sym> Symbols;
+  std::vector<Elf_Versym> Versions;
+  std::vector<VersionNeed> Needs;
+
+private:
+  DynamicELF(StringRef Buffer, ELFFile<ELFT> &&File) :
+    Buffer(Buffer), File(std::move(File)) {}
+
+public:
+  static Expected<DynamicELF> create(StringRef Buffer) {
+    auto MaybeFile = ELFFile<ELFT>::create(Buffer);
+    if (not MaybeFile)
+      return MaybeFile.takeError();
+
+    DynamicELF Result(Buffer, std::move(*MaybeFile));
+    if (Error TheError = Result.parse())
+      return std::move(TheError);
+
+    return Result;
+  }
+
+public:
+  const Elf_Ehdr &header() const { return File.getHeader(); }
+
+  bool isDynamic() const { return not DynamicEntries.empty(); }
+
+  std::optional<uint64_t> tag(int64_t Tag) const {
+    auto It = Tags.find(Tag);
+    if (It == Tags.end())
+      return std::nullopt;
+    return It->second;
+  }
+
+  const Elf_Phdr *loadSegmentOverlapping(uint64_t Address,
+                                         uint64_t Size) const {
+    for (const Elf_Phdr &Segment : Segments) {
+      if (Segment.p_type != ELF::PT_LOAD)
+        continue;
+
+      uint64_t Start = Segment.p_vaddr;
+      uint64_t End = Start + Segment.p_memsz;
+      if (Address < End and Start < Address + Size)
+        return &Segment;
+    }
+
+    return nullptr;
+  }
+
+  StringRef symbolName(const Elf_Sym &Symbol) const {
+    if (Symbol.st_name >= Dynstr.size())
+      return {};
+    return StringRef(reinterpret_cast<const char *>(Dynstr.data())
+                     + Symbol.st_name);
+  }
+
+  /// Append \p Relocation to \p Output in the format of this ELF
+  void serialize(const Relocation &Relocation, Table &Output) const {
+    if (IsRela)
+      serialize<Elf_Rela>(Relocation, Output);
+    else
+      serialize<Elf_Rel>(Relocation, Output);
+  }
+
+private:
+  Expected<uint64_t> offsetOf(uint64_t Address) const {
+    for (const Elf_Phdr &Segment : Segments) {
+      if (Segment.p_type != ELF::PT_LOAD)
+        continue;
+
+      uint64_t Start = Segment.p_vaddr;
+      if (Address >= Start and Address < Start + Segment.p_filesz)
+        return Segment.p_offset + (Address - Start);
+    }
+
+    return createError("Address 0x" + Twine::utohexstr(Address)
+                       + " is not mapped in the file");
+  }
+
+  Expected<ArrayRef<uint8_t>> read(uint64_t Offset, uint64_t Size) const {
+    if (Offset > Buffer.size() or Size > Buffer.size() - Offset)
+      return createError("Read past the end of the file");
+    return arrayRefFromStringRef(Buffer.substr(Offset, Size));
+  }
+
+  template<typename T>
+  Expected<T> readAt(uint64_t Offset) const {
+    auto MaybeBytes = read(Offset, sizeof(T));
+    if (not MaybeBytes)
+      return MaybeBytes.takeError();
+
+    T Result;
+    std::memcpy(&Result, MaybeBytes->data(), sizeof(T));
+    return Result;
+  }
+
+  /// Read \p Size bytes at the address of \p AddressTag, nothing if the tag
+  /// is not available
+  Expected<ArrayRef<uint8_t>> readTable(int64_t AddressTag,
+                                        uint64_t Size) const {
+    auto Address = tag(AddressTag);
+    if (not Address or Size == 0)
+      return ArrayRef<uint8_t>();
+
+    auto MaybeOffset = offsetOf(*Address);
+    if (not MaybeOffset)
+      return MaybeOffset.takeError();
+
+    return read(*MaybeOffset, Size);
+  }
+
+  Error parse() {
+    auto MaybeSegments = File.program_headers();
+    if (not MaybeSegments)
+      return MaybeSegments.takeError();
+    Segments = *MaybeSegments;
+
+    auto MaybeSections = File.sections();
+    if (not MaybeSections)
+      return MaybeSections.takeError();
+    Sections = *MaybeSections;
+
+    if (llvm::none_of(Segments, [](const Elf_Phdr &Segment) {
+          return Segment.p_type == ELF::PT_DYNAMIC;
+        }))
+      return Error::success();
+
+    auto MaybeEntries = File.dynamicEntries();
+    if (not MaybeEntries)
+      return MaybeEntries.takeError();
+
+    for (const Elf_Dyn &Entry : *MaybeEntries) {
+      DynamicEntries.push_back(Entry);
+      if (Entry.getTag() == ELF::DT_NULL)
+        break;
+      Tags.try_emplace(Entry.getTag(), Entry.getVal());
+    }
+
+    if (DynamicEntries.empty()
+        or DynamicEntries.back().getTag() != ELF::DT_NULL)
+      return createError(".dynamic is not terminated by DT_NULL");
+
+    IsRela = tag(ELF::DT_PLTREL) == uint64_t(ELF::DT_RELA)
+             or tag(ELF::DT_RELA).has_value();
+
+    if (Error TheError = readTable(ELF::DT_STRTAB,
+                                   tag(ELF::DT_STRSZ).value_or(0))
+                           .moveInto(Dynstr))
+      return TheError;
+
+    if (IsRela) {
+      if (Error TheError = readTable(ELF::DT_RELA,
+                                     tag(ELF::DT_RELASZ).value_or(0))
+                             .moveInto(RelDyn))
+        return TheError;
+    } else {
+      if (Error TheError = readTable(ELF::DT_REL,
+                                     tag(ELF::DT_RELSZ).value_or(0))
+                             .moveInto(RelDyn))
+        return TheError;
+    }
+
+    ArrayRef<uint8_t> RelPlt;
+    if (Error TheError = readTable(ELF::DT_JMPREL,
+                                   tag(ELF::DT_PLTRELSZ).value_or(0))
+                           .moveInto(RelPlt))
+      return TheError;
+
+    if (Error TheError = parseRelocations(RelPlt))
+      return TheError;
+    if (Error TheError = parseRelocations(RelDyn))
+      return TheError;
+
+    // There's no reliable way to know how many dynamic symbols there are, we
+    // consider those up to the last one referenced by a relocation
+    uint64_t SymbolsCount = 0;
+    for (const Relocation &Relocation : Relocations)
+      SymbolsCount = std::max<uint64_t>(SymbolsCount, Relocation.Symbol + 1);
+
+    uint64_t SymbolsSize = tag(ELF::DT_SYMENT).value_or(0) * SymbolsCount;
+    if (Error TheError = readTable(ELF::DT_SYMTAB, SymbolsSize)
+                           .moveInto(Dynsym))
+      return TheError;
+    if (Error TheError = parseArray<Elf_Sym>(Dynsym).moveInto(Symbols))
+      return TheError;
+
+    uint64_t VersionsSize = sizeof(Elf_Versym) * SymbolsCount;
+    if (Error TheError = readTable(ELF::DT_VERSYM, VersionsSize)
+                           .moveInto(Versym))
+      return TheError;
+    if (Error TheError = parseArray<Elf_Versym>(Versym).moveInto(Versions))
+      return TheError;
+
+    return parseVersionNeeds();
+  }
+
+  Error parseRelocations(ArrayRef<uint8_t> Bytes) {
+    if (IsRela)
+      return parseRelocations<Elf_Rela>(Bytes);
+    else
+      return parseRelocations<Elf_Rel>(Bytes);
+  }
+
+  template<typename T>
+  Error parseRelocations(ArrayRef<uint8_t> Bytes) {
+    auto MaybeEntries = parseArray<T>(Bytes);
+    if (not MaybeEntries)
+      return MaybeEntries.takeError();
+
+    for (const T &Entry : *MaybeEntries) {
+      Relocation &New = Relocations.emplace_back();
+      New.Offset = Entry.r_offset;
+      New.Symbol = Entry.getSymbol(false);
+      New.Type = Entry.getType(false);
+      if constexpr (T::IsRela)
+        New.Addend = Entry.r_addend;
+    }
+
+    return Error::success();
+  }
+
+  template<typename T>
+  static void serialize(const Relocation &Relocation, Table &Output) {
+    T Entry;
+    std::memset(&Entry, 0, sizeof(T));
+    Entry.r_offset = Relocation.Offset;
+    Entry.setSymbolAndType(Relocation.Symbol, Relocation.Type, false);
+    if constexpr (T::IsRela)
+      Entry.r_addend = Relocation.Addend;
+    Output.append(Entry);
+  }
+
+  Error parseVersionNeeds() {
+    auto Address = tag(ELF::DT_VERNEED);
+    if (not Address)
+      return Error::success();
+
+    auto MaybeOffset = offsetOf(*Address);
+    if (not MaybeOffset)
+      return MaybeOffset.takeError();
+
+    uint64_t NeedOffset = *MaybeOffset;
+    uint64_t Count = tag(ELF::DT_VERNEEDNUM).value_or(0);
+    for (uint64_t I = 0; I < Count; ++I) {
+      VersionNeed &New = Needs.emplace_back();
+      if (Error TheError = readAt<Elf_Verneed>(NeedOffset).moveInto(New.Need))
+        return TheError;
+
+      uint64_t AuxiliaryOffset = NeedOffset + New.Need.vn_aux;
+      for (unsigned J = 0; J < New.Need.vn_cnt; ++J) {
+        Elf_Vernaux &Auxiliary = New.Auxiliaries.emplace_back();
+        if (Error TheError = readAt<Elf_Vernaux>(AuxiliaryOffset)
+                               .moveInto(Auxiliary))
+          return TheError;
+        AuxiliaryOffset += Auxiliary.vna_next;
+      }
+
+      NeedOffset += New.Need.vn_next;
+    }
+
+    return Error::success();
+  }
+};
+
+/// Build a `DT_HASH` table for \p SymbolsCount symbols indexing \p Symbols, a
+/// list of pairs of symbol index and hash of its name
+template<typename ELFT>
+static Table
+buildHashTable(uint32_t SymbolsCount,
+               ArrayRef<std::pair<uint32_t, uint32_t>> Symbols) {
+  using Elf_Word = typename ELFT::Word;
+
+  uint32_t BucketsCount = bucketsCount(Symbols.size());
+  std::vector<uint32_t> Buckets(BucketsCount, 0);
+  std::vector<uint32_t> Chains(SymbolsCount, 0);
+
+  // Insert in reverse order, so that each chain is sorted by symbol index
+  for (auto [Index, Hash] : llvm::reverse(Symbols)) {
+    uint32_t &Bucket = Buckets[Hash % BucketsCount];
+    Chains[Index] = Bucket;
+    Bucket = Index;
+  }
+
+  Table Result;
+  Result.append(Elf_Word(BucketsCount));
+  Result.append(Elf_Word(SymbolsCount));
+  for (uint32_t Bucket : Buckets)
+    Result.append(Elf_Word(Bucket));
+  for (uint32_t Chain : Chains)
+    Result.append(Elf_Word(Chain));
+  return Result;
+}
+
+/// Serialize \p Needs in `.gnu.version_r` format, each `Elf_Verneed` followed
+/// by its `Elf_Vernaux`
+template<typename ELFT>
+static Table
+serializeVersionNeeds(ArrayRef<typename DynamicELF<ELFT>::VersionNeed> Needs) {
+  using Elf_Verneed = typename ELFT::Verneed;
+  using Elf_Vernaux = typename ELFT::Vernaux;
+
+  Table Result;
+  for (size_t Index = 0; Index < Needs.size(); ++Index) {
+    const auto &Need = Needs[Index];
+    size_t AuxiliariesCount = Need.Auxiliaries.size();
+    Elf_Verneed Header = Need.Need;
+    Header.vn_cnt = AuxiliariesCount;
+    Header.vn_aux = AuxiliariesCount == 0 ? 0 : sizeof(Elf_Verneed);
+    bool IsLast = Index + 1 == Needs.size();
+    Header.vn_next = IsLast ? 0 :
+                              sizeof(Elf_Verneed)
+                                + AuxiliariesCount * sizeof(Elf_Vernaux);
+    Result.append(Header);
+
+    for (size_t I = 0; I < AuxiliariesCount; ++I) {
+      Elf_Vernaux Entry = Need.Auxiliaries[I];
+      bool IsLastAuxiliary = I + 1 == AuxiliariesCount;
+      Entry.vna_next = IsLastAuxiliary ? 0 : sizeof(Elf_Vernaux);
+      Result.append(Entry);
+    }
+  }
+
+  return Result;
+}
+
+static unsigned segmentSortKey(uint32_t Type) {
+  switch (Type) {
+  case ELF::PT_PHDR:
+    return 0;
+  case ELF::PT_INTERP:
+    return 1;
+  case ELF::PT_LOAD:
+    return 2;
+  default:
+    return 3;
+  }
+}
+
+template<typename ELFT>
+static Error merge(const DynamicELF<ELFT> &ToExtend,
+                   const DynamicELF<ELFT> &Source,
+                   raw_ostream &Output,
+                   uint64_t Base,
+                   bool MergeLoadSegments) {
+  LLVM_ELF_IMPORT_TYPES_ELFT(ELFT)
+
+  if (not ToExtend.isDynamic())
+    return createError("The ELF to extend is not dynamic");
+
+  if (ToExtend.header().e_machine != Source.header().e_machine)
+    return createError("The ELFs have different architectures");
+
+  if (ToExtend.Symbols.empty())
+    return createError("The ELF to extend has no dynamic symbols");
+
+  if (ToExtend.Dynstr.empty() or ToExtend.Dynstr.back() != 0)
+    return createError(".dynstr of the ELF to extend is not NUL-terminated");
+
+  uint64_t RelocationOffset = 0;
+  if (Source.header().e_type == ELF::ET_DYN)
+    RelocationOffset = Base;
+
+  const uint64_t WordSize = ELFT::Is64Bits ? 8 : 4;
+
+  //
+  // Lay out the new tables, they will be the first part of a new segment
+  //
+  Table Segment;
+
+  // .dynstr
+  uint32_t StringsOffset = ToExtend.Dynstr.size();
+  uint64_t DynstrOffset = Segment.size();
+  Segment.appendBytes(ToExtend.Dynstr);
+  Segment.appendBytes(Source.Dynstr);
+  uint64_t DynstrSize = Segment.size() - DynstrOffset;
+
+  // .dynsym: the symbols of Source, except the null one, follow those of
+  // ToExtend. The defined ones are recorded for the hash table.
+  ArrayRef<Elf_Sym> NewSymbols = Source.Symbols;
+  if (not NewSymbols.empty())
+    NewSymbols = NewSymbols.drop_front();
+
+  uint32_t SymbolsOffset = ToExtend.Symbols.size() - 1;
+  uint32_t SymbolsCount = ToExtend.Symbols.size() + NewSymbols.size();
+  std::vector<std::pair<uint32_t, uint32_t>> DefinedSymbols;
+  for (uint32_t Index = 0; Index < ToExtend.Symbols.size(); ++Index) {
+    const Elf_Sym &Symbol = ToExtend.Symbols[Index];
+    if (Symbol.st_shndx != ELF::SHN_UNDEF)
+      DefinedSymbols.emplace_back(Index,
+                                  elfHash(ToExtend.symbolName(Symbol)));
+  }
+
+  uint64_t DynsymOffset = Segment.align(WordSize);
+  Segment.appendBytes(ToExtend.Dynsym);
+  for (uint32_t Index = 0; Index < NewSymbols.size(); ++Index) {
+    const Elf_Sym &Symbol = NewSymbols[Index];
+    if (Symbol.st_shndx != ELF::SHN_UNDEF)
+      DefinedSymbols.emplace_back(SymbolsOffset + 1 + Index,
+                                  elfHash(Source.symbolName(Symbol)));
+
+    Elf_Sym NewSymbol = Symbol;
+    NewSymbol.st_name += StringsOffset;
+    if (NewSymbol.st_value != 0)
+      NewSymbol.st_value += RelocationOffset;
+    Segment.append(NewSymbol);
+  }
+  uint64_t DynsymSize = Segment.size() - DynsymOffset;
+
+  // .rela.dyn/.rel.dyn
+  uint32_t RelativeType = getELFRelativeRelocationType(Source.header()
+                                                         .e_machine);
+  uint64_t RelDynOffset = Segment.align(WordSize);
+  Segment.appendBytes(ToExtend.RelDyn);
+  for (Relocation Relocation : Source.Relocations) {
+    if (Relocation.Symbol != 0)
+      Relocation.Symbol += SymbolsOffset;
+    if (RelativeType != 0 and Relocation.Type == RelativeType)
+      Relocation.Addend += RelocationOffset;
+    Relocation.Offset += RelocationOffset;
+    Source.serialize(Relocation, Segment);
+  }
+  uint64_t RelDynSize = Segment.size() - RelDynOffset;
+
+  // .gnu.version: version indices 0 and 1 are reserved, the others of Source
+  // are shifted past those of ToExtend
+  uint16_t HighestVersion = 1;
+  for (const auto &Need : ToExtend.Needs)
+    for (const Elf_Vernaux &Auxiliary : Need.Auxiliaries)
+      HighestVersion = std::max<uint16_t>(HighestVersion,
+                                          Auxiliary.vna_other);
+  uint16_t VersionsOffset = HighestVersion - 1;
+
+  ArrayRef<Elf_Versym> NewVersions = Source.Versions;
+  if (not NewVersions.empty())
+    NewVersions = NewVersions.drop_front();
+
+  uint64_t VersymOffset = Segment.align(sizeof(Elf_Versym));
+  Segment.appendBytes(ToExtend.Versym);
+  for (Elf_Versym Version : NewVersions) {
+    if ((Version.vs_index & ELF::VERSYM_VERSION) > 1)
+      Version.vs_index += VersionsOffset;
+    Segment.append(Version);
+  }
+  uint64_t VersymSize = Segment.size() - VersymOffset;
+
+  // .gnu.version_r
+  std::vector<typename DynamicELF<ELFT>::VersionNeed> Needs = ToExtend.Needs;
+  for (auto Need : Source.Needs) {
+    Need.Need.vn_file += StringsOffset;
+    for (Elf_Vernaux &Auxiliary : Need.Auxiliaries) {
+      Auxiliary.vna_name += StringsOffset;
+      Auxiliary.vna_other += VersionsOffset;
+    }
+    Needs.push_back(std::move(Need));
+  }
+
+  uint64_t VerneedOffset = Segment.align(sizeof(Elf_Word));
+  Segment.appendBytes(serializeVersionNeeds<ELFT>(Needs).data());
+  uint64_t VerneedSize = Segment.size() - VerneedOffset;
+
+  // .hash: an actual hash table, the loader might have to look up any of the
+  // symbols, and there are easily tens of thousands of them
+  uint64_t HashOffset = Segment.align(sizeof(Elf_Word));
+  Segment.appendBytes(buildHashTable<ELFT>(SymbolsCount, DefinedSymbols)
+                        .data());
+
+  // .dynamic: all the hash tables are replaced by the one above
+  SmallVector<Elf_Dyn, 32> DynamicEntries;
+  for (const Elf_Dyn &Entry : ToExtend.DynamicEntries) {
+    auto Tag = Entry.getTag();
+    if (Tag != ELF::DT_HASH and Tag != ELF::DT_GNU_HASH)
+      DynamicEntries.push_back(Entry);
+  }
+  Elf_Dyn HashEntry = ToExtend.DynamicEntries.back();
+  HashEntry.d_tag = ELF::DT_HASH;
+  DynamicEntries.insert(std::prev(DynamicEntries.end()), HashEntry);
+
+  // The contents of what follows depend on where the segment will be loaded,
+  // which in turn depends on its size
+  uint64_t DynamicOffset = Segment.align(WordSize);
+  uint64_t DynamicSize = DynamicEntries.size() * sizeof(Elf_Dyn);
+
+  uint64_t SectionHeadersOffset = alignTo(DynamicOffset + DynamicSize,
+                                          WordSize);
+  uint64_t SectionHeadersSize = ToExtend.Sections.size() * sizeof(Elf_Shdr);
+
+  struct AdditionalSegment {
+    Elf_Phdr Header;
+    ArrayRef<uint8_t> Contents;
+  };
+  SmallVector<AdditionalSegment, 4> AdditionalSegments;
+  if (MergeLoadSegments) {
+    for (const Elf_Phdr &Header : Source.Segments) {
+      if (Header.p_type != ELF::PT_LOAD)
+        continue;
+
+      uint64_t Offset = Header.p_offset;
+      uint64_t Size = Header.p_filesz;
+      if (Offset > Source.Buffer.size() or Size > Source.Buffer.size() - Offset)
+        return createError("A segment of the source ELF is out of bounds");
+
+      StringRef Contents = Source.Buffer.substr(Offset, Size);
+      AdditionalSegments.push_back({ Header, arrayRefFromStringRef(Contents) });
+    }
+  }
+
+  uint64_t SegmentsCount = ToExtend.Segments.size() + AdditionalSegments.size()
+                           + 1;
+  uint64_t ProgramHeadersOffset = alignTo(SectionHeadersOffset
+                                            + SectionHeadersSize,
+                                          WordSize);
+  uint64_t ProgramHeadersSize = SegmentsCount * sizeof(Elf_Phdr);
+  uint64_t SegmentSize = ProgramHeadersOffset + ProgramHeadersSize;
+
+  //
+  // Find a spot for the new segment after the end of ToExtend, not
+  // overlapping any segment of the two ELFs
+  //
+  std::optional<uint64_t> BaseAddress;
+  for (const Elf_Phdr &Header : ToExtend.Segments)
+    if (Header.p_type == ELF::PT_LOAD)
+      BaseAddress = std::min<uint64_t>(BaseAddress.value_or(Header.p_vaddr),
+                                       Header.p_vaddr);
+  if (not BaseAddress)
+    return createError("The ELF to extend has no PT_LOAD segments");
+
+  uint64_t ToExtendSize = ToExtend.Buffer.size();
+  uint64_t StartAddress = alignTo(*BaseAddress + ToExtendSize, PageSize);
+  while (true) {
+    const Elf_Phdr *Overlapping = nullptr;
+    Overlapping = ToExtend.loadSegmentOverlapping(StartAddress, SegmentSize);
+    if (Overlapping == nullptr)
+      Overlapping = Source.loadSegmentOverlapping(StartAddress, SegmentSize);
+    if (Overlapping == nullptr)
+      break;
+
+    revng_log(Log,
+              "Discarding 0x" << Twine::utohexstr(StartAddress).str()
+                              << " since it overlaps the segment at 0x"
+                              << Twine::utohexstr(Overlapping->p_vaddr).str());
+    StartAddress = alignTo(Overlapping->p_vaddr + Overlapping->p_memsz,
+                           PageSize);
+  }
+
+  // File offsets and addresses are mapped 1:1 with respect to the base
+  uint64_t SegmentFileOffset = StartAddress - *BaseAddress;
+  auto ToAddress = [StartAddress](uint64_t Offset) {
+    return StartAddress + Offset;
+  };
+
+  //
+  // Emit the tables depending on the address of the new segment
+  //
+  for (Elf_Dyn &Entry : DynamicEntries) {
+    switch (Entry.getTag()) {
+    case ELF::DT_STRTAB:
+      Entry.d_un.d_ptr = ToAddress(DynstrOffset);
+      break;
+    case ELF::DT_STRSZ:
+      Entry.d_un.d_val = DynstrSize;
+      break;
+    case ELF::DT_REL:
+    case ELF::DT_RELA:
+      Entry.d_un.d_ptr = ToAddress(RelDynOffset);
+      break;
+    case ELF::DT_RELSZ:
+    case ELF::DT_RELASZ:
+      Entry.d_un.d_val = RelDynSize;
+      break;
+    case ELF::DT_SYMTAB:
+      Entry.d_un.d_ptr = ToAddress(DynsymOffset);
+      break;
+    case ELF::DT_VERNEED:
+      Entry.d_un.d_ptr = ToAddress(VerneedOffset);
+      break;
+    case ELF::DT_VERNEEDNUM:
+      Entry.d_un.d_val = Needs.size();
+      break;
+    case ELF::DT_VERSYM:
+      Entry.d_un.d_ptr = ToAddress(VersymOffset);
+      break;
+    case ELF::DT_HASH:
+      Entry.d_un.d_ptr = ToAddress(HashOffset);
+      break;
+    default:
+      break;
+    }
+  }
+
+  revng_assert(Segment.align(WordSize) == DynamicOffset);
+  for (const Elf_Dyn &Entry : DynamicEntries)
+    Segment.append(Entry);
+
+  // Section headers
+  revng_assert(Segment.align(WordSize) == SectionHeadersOffset);
+  for (Elf_Shdr Section : ToExtend.Sections) {
+    auto MaybeName = ToExtend.File.getSectionName(Section);
+    if (not MaybeName)
+      return MaybeName.takeError();
+    StringRef Name = *MaybeName;
+
+    auto Relocate = [&](uint64_t Offset, uint64_t Size) {
+      Section.sh_addr = ToAddress(Offset);
+      Section.sh_offset = SegmentFileOffset + Offset;
+      Section.sh_size = Size;
+    };
+
+    if (Name == ".dynstr") {
+      Relocate(DynstrOffset, DynstrSize);
+    } else if (Name == ".dynsym") {
+      Relocate(DynsymOffset, DynsymSize);
+    } else if (Name == ".rela.dyn" or Name == ".rel.dyn") {
+      Relocate(RelDynOffset, RelDynSize);
+    } else if (Name == ".dynamic") {
+      Relocate(DynamicOffset, DynamicSize);
+    } else if (Name == ".gnu.version") {
+      Relocate(VersymOffset, VersymSize);
+    } else if (Name == ".gnu.version_r") {
+      Relocate(VerneedOffset, VerneedSize);
+      Section.sh_info = Needs.size();
+    }
+
+    Segment.append(Section);
+  }
+
+  // Program headers
+  std::vector<Elf_Phdr> Segments(ToExtend.Segments.begin(),
+                                 ToExtend.Segments.end());
+
+  uint64_t AdditionalOffset = SegmentFileOffset + SegmentSize;
+  for (AdditionalSegment &Additional : AdditionalSegments) {
+    Elf_Phdr &Header = Additional.Header;
+    uint64_t Alignment = std::max<uint64_t>(PageSize, Header.p_align);
+    uint64_t Padding = Header.p_offset % Alignment;
+    Header.p_offset = alignTo(AdditionalOffset, Alignment) + Padding;
+    AdditionalOffset = Header.p_offset + Header.p_filesz;
+    Segments.push_back(Header);
+  }
+
+  for (Elf_Phdr &Header : Segments) {
+    if (Header.p_type == ELF::PT_DYNAMIC) {
+      Header.p_offset = SegmentFileOffset + DynamicOffset;
+      Header.p_vaddr = ToAddress(DynamicOffset);
+      Header.p_paddr = ToAddress(DynamicOffset);
+      Header.p_filesz = DynamicSize;
+      Header.p_memsz = DynamicSize;
+    } else if (Header.p_type == ELF::PT_PHDR) {
+      Header.p_offset = SegmentFileOffset + ProgramHeadersOffset;
+      Header.p_vaddr = ToAddress(ProgramHeadersOffset);
+      Header.p_paddr = ToAddress(ProgramHeadersOffset);
+      Header.p_filesz = ProgramHeadersSize;
+      Header.p_memsz = ProgramHeadersSize;
+    }
+  }
+
+  Elf_Phdr NewSegment;
+  std::memset(&NewSegment, 0, sizeof(NewSegment));
+  NewSegment.p_type = ELF::PT_LOAD;
+  NewSegment.p_flags = ELF::PF_R | ELF::PF_W;
+  NewSegment.p_offset = SegmentFileOffset;
+  NewSegment.p_vaddr = StartAddress;
+  NewSegment.p_paddr = StartAddress;
+  NewSegment.p_filesz = SegmentSize;
+  NewSegment.p_memsz = SegmentSize;
+  NewSegment.p_align = PageSize;
+  Segments.push_back(NewSegment);
+
+  llvm::stable_sort(Segments, [](const Elf_Phdr &LHS, const Elf_Phdr &RHS) {
+    auto Key = [](const Elf_Phdr &Header) {
+      return std::make_pair(segmentSortKey(Header.p_type),
+                            uint64_t(Header.p_vaddr));
+    };
+    return Key(LHS) < Key(RHS);
+  });
+
+  revng_assert(Segment.align(WordSize) == ProgramHeadersOffset);
+  for (const Elf_Phdr &Header : Segments)
+    Segment.append(Header);
+  revng_assert(Segment.size() == SegmentSize);
+
+  //
+  // Write the output
+  //
+  Elf_Ehdr Header = ToExtend.header();
+  Header.e_phoff = SegmentFileOffset + ProgramHeadersOffset;
+  Header.e_phnum = Segments.size();
+  Header.e_shoff = SegmentFileOffset + SectionHeadersOffset;
+  Header.e_shnum = ToExtend.Sections.size();
+
+  auto WriteBytes = [&Output](ArrayRef<uint8_t> Bytes) {
+    Output.write(reinterpret_cast<const char *>(Bytes.data()), Bytes.size());
+  };
+
+  uint64_t Written = 0;
+  auto PadTo = [&Output, &Written](uint64_t Offset) {
+    revng_assert(Offset >= Written);
+    Output.write_zeros(Offset - Written);
+    Written = Offset;
+  };
+
+  Output.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+  Output << ToExtend.Buffer.drop_front(sizeof(Header));
+  Written = ToExtendSize;
+
+  PadTo(SegmentFileOffset);
+  WriteBytes(Segment.data());
+  Written += Segment.size();
+
+  for (const AdditionalSegment &Additional : AdditionalSegments) {
+    PadTo(Additional.Header.p_offset);
+    WriteBytes(Additional.Contents);
+    Written += Additional.Contents.size();
+  }
+
+  return Error::success();
+}
+
+template<typename CallableT>
+static Error withELFType(StringRef Buffer, CallableT &&Callable) {
+  auto [Class, Encoding] = getElfArchType(Buffer);
+  bool IsLittleEndian = Encoding == ELF::ELFDATA2LSB;
+  bool IsBigEndian = Encoding == ELF::ELFDATA2MSB;
+
+  if (Class == ELF::ELFCLASS32 and IsLittleEndian)
+    return Callable(ELF32LE());
+  else if (Class == ELF::ELFCLASS32 and IsBigEndian)
+    return Callable(ELF32BE());
+  else if (Class == ELF::ELFCLASS64 and IsLittleEndian)
+    return Callable(ELF64LE());
+  else if (Class == ELF::ELFCLASS64 and IsBigEndian)
+    return Callable(ELF64BE());
+  else
+    return createError("Not an ELF file");
+}
+
+Error mergeDynamic(StringRef ToExtend,
+                   StringRef Source,
+                   raw_ostream &Output,
+                   uint64_t Base,
+                   bool MergeLoadSegments) {
+  return withELFType(Source, [&](auto Type) -> Error {
+    using ELFT = decltype(Type);
+
+    auto MaybeSource = DynamicELF<ELFT>::create(Source);
+    if (not MaybeSource)
+      return MaybeSource.takeError();
+
+    // If the original ELF was not dynamic, there's nothing to merge
+    if (not MaybeSource->isDynamic()) {
+      Output << ToExtend;
+      return Error::success();
+    }
+
+    if (getElfArchType(ToExtend) != getElfArchType(Source))
+      return createError("The ELFs have different classes or endianness");
+
+    auto MaybeToExtend = DynamicELF<ELFT>::create(ToExtend);
+    if (not MaybeToExtend)
+      return MaybeToExtend.takeError();
+
+    return merge(*MaybeToExtend,
+                 *MaybeSource,
+                 Output,
+                 Base,
+                 MergeLoadSegments);
+  });
+}
@@ -5,6 +5,9 @@
 //
 
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "revng/Support/Assert.h"
 
 #include "revng/Storage/ReadableFile.h"
 #include "revng/Storage/WritableFile.h"
@@ -35,4 +38,61 @@ public:
   llvm::Error commit() override { return llvm::Error::success(); }
 };
 
+/// A WritableFile that writes to a temporary file next to the destination and
+/// renames it over the destination on commit
+///
+/// The previous content of the destination stays untouched until then, hence
+/// a ReadableFile obtained from it (which might be memory mapped) remains
+/// valid even if the file is re-written while it's alive.
+class LocalReplacingFile : public WritableFile {
+private:
+  std::unique_ptr<llvm::raw_fd_ostream> OS;
+  std::string TemporaryPath;
+  std::string Destination;
+  bool Committed = false;
+
+public:
+  LocalReplacingFile(std::unique_ptr<llvm::raw_fd_ostream> &&OS,
+                     std::string TemporaryPath,
+                     std::string Destination) :
+    OS(std::move(OS)),
+    TemporaryPath(std::move(TemporaryPath)),
+    Destination(std::move(Destination)) {}
+
+  ~LocalReplacingFile() override {
+    if (not Committed) {
+      OS.reset();
+      llvm::sys::fs::remove(TemporaryPath);
+    }
+  }
+
+  llvm::raw_pwrite_stream &os() override { return *OS; }
+
+  llvm::Error commit() override {
+    revng_assert(not Committed);
+    Committed = true;
+
+    OS->close();
+    if (OS->has_error()) {
+      std::error_code EC = OS->error();
+      OS->clear_error();
+      llvm::sys::fs::remove(TemporaryPath);
+      return llvm::createStringError(EC,
+                                     "Could not write file %s",
+                                     Destination.c_str());
+    }
+
+    std::error_code EC = llvm::sys::fs::rename(TemporaryPath, Destination);
+    if (EC) {
+      llvm::sys::fs::remove(TemporaryPath);
+      return llvm::createStringError(EC,
+                                     "Could not rename %s to %s",
+                                     TemporaryPath.c_str(),
+                                     Destination.c_str());
+    }
+
+    return llvm::Error::success();
+  }
+};
+
 } // namespace revng
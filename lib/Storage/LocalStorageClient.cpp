@@ -90,6 +90,9 @@ llvm::Error LocalStorageClient::copy(llvm::StringRef Source,
 llvm::Expected<std::unique_ptr<ReadableFile>>
 LocalStorageClient::getReadableFile(llvm::StringRef Path) {
   std::string ResolvedPath = resolvePath(Path);
+  // Non-volatile files are memory mapped (unless they're very small), so this
+  // does not copy the file. The null terminator is required since the parsers
+  // of textual LLVM IR and YAML expect it.
   auto MaybeBuffer = llvm::MemoryBuffer::getFile(ResolvedPath);
   if (not MaybeBuffer) {
     return llvm::createStringError(MaybeBuffer.getError(),
@@ -104,17 +107,25 @@ llvm::Expected<std::unique_ptr<WritableFile>>
 LocalStorageClient::getWritableFile(llvm::StringRef Path,
                                     ContentEncoding Encoding) {
   std::string ResolvedPath = resolvePath(Path);
-  std::error_code EC;
-  auto OS = std::make_unique<llvm::raw_fd_ostream>(ResolvedPath,
-                                                   EC,
-                                                   llvm::sys::fs::OF_None);
+  // Write to a temporary file in the same directory, which is renamed over
+  // ResolvedPath on commit: truncating ResolvedPath right away would break the
+  // ReadableFiles that have memory mapped it
+  int FD = -1;
+  llvm::SmallString<128> TemporaryPath;
+  std::error_code EC = llvm::sys::fs::createUniqueFile(ResolvedPath
+                                                         + ".tmp-%%%%%%%%",
+                                                       FD,
+                                                       TemporaryPath);
   if (EC) {
     return llvm::createStringError(EC,
                                    "Could not open file %s for writing",
                                    ResolvedPath.c_str());
   }
 
-  return std::make_unique<LocalWritableFile>(std::move(OS));
+  auto OS = std::make_unique<llvm::raw_fd_ostream>(FD, true);
+  return std::make_unique<LocalReplacingFile>(std::move(OS),
+                                              TemporaryPath.str().str(),
+                                              std::move(ResolvedPath));
 }
 
 } // namespace revng
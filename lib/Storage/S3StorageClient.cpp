@@ -203,6 +203,7 @@ public:
     if (not Result.IsSuccess())
       return toError(Result);
 
+    std::lock_guard Lock(Client.FilenameMapMutex);
     Client.FilenameMap[Path] = NewFilename;
     return llvm::Error::success();
   }
@@ -211,12 +212,18 @@ public:
 class S3CredentialsProvider : public Aws::Auth::AWSCredentialsProvider {
 private:
   Aws::Auth::AWSCredentials &Credentials;
+  std::mutex &Mutex;
 
 public:
-  explicit S3CredentialsProvider(Aws::Auth::AWSCredentials &Credentials) :
-    Credentials(Credentials) {}
+  S3CredentialsProvider(Aws::Auth::AWSCredentials &Credentials,
+                        std::mutex &Mutex) :
+    Credentials(Credentials), Mutex(Mutex) {}
   ~S3CredentialsProvider() override = default;
-  Aws::Auth::AWSCredentials GetAWSCredentials() override { return Credentials; }
+
+  Aws::Auth::AWSCredentials GetAWSCredentials() override {
+    std::lock_guard Lock(Mutex);
+    return Credentials;
+  }
 };
 
 S3StorageClient::S3StorageClient(llvm::StringRef RawURL) {
@@ -247,7 +254,8 @@ S3StorageClient::S3StorageClient(llvm::StringRef RawURL) {
   Config.endpointOverride = consumeSplit(URL, '/').str();
   RedactedURL += Config.region + '+' + Config.endpointOverride + '/';
 
-  Client = { std::make_shared<S3CredentialsProvider>(Credentials),
+  Client = { std::make_shared<S3CredentialsProvider>(Credentials,
+                                                     CredentialsMutex),
              Config,
              Aws::Client::AWSAuthV4Signer::PayloadSigningPolicy::Always,
              false };
@@ -306,11 +314,20 @@ std::string S3StorageClient::dumpString() const {
   return RedactedURL;
 }
 
+std::optional<std::string> S3StorageClient::lookup(llvm::StringRef Path) {
+  std::lock_guard Lock(FilenameMapMutex);
+  auto It = FilenameMap.find(Path);
+  if (It == FilenameMap.end())
+    return std::nullopt;
+
+  return It->second;
+}
+
 llvm::Expected<PathType> S3StorageClient::type(llvm::StringRef Path) {
-  if (FilenameMap.count(Path) > 0) {
+  if (auto MaybeFilename = lookup(Path)) {
     Aws::S3::Model::HeadObjectRequest Request;
     Request.SetBucket(Bucket);
-    Request.SetKey(resolvePath(FilenameMap[Path]));
+    Request.SetKey(resolvePath(*MaybeFilename));
 
     Aws::S3::Model::HeadObjectOutcome Result = Client.HeadObject(Request);
     if (not Result.IsSuccess()) {
@@ -324,6 +341,7 @@ llvm::Expected<PathType> S3StorageClient::type(llvm::StringRef Path) {
     return PathType::File;
   } else {
     std::string Prefix = Path.endswith("/") ? Path.str() : (Path.str() + "/");
+    std::lock_guard Lock(FilenameMapMutex);
     for (auto &[MapPath, _] : FilenameMap) {
       if (MapPath.startswith(Prefix))
         return PathType::Directory;
@@ -337,6 +355,7 @@ llvm::Error S3StorageClient::createDirectory(llvm::StringRef Path) {
 }
 
 llvm::Error S3StorageClient::remove(llvm::StringRef Path) {
+  std::lock_guard Lock(FilenameMapMutex);
   revng_assert(FilenameMap.count(Path) != 0);
   FilenameMap.erase(Path);
   return llvm::Error::success();
@@ -348,6 +367,7 @@ llvm::sys::path::Style S3StorageClient::getStyle() const {
 
 llvm::Error S3StorageClient::copy(llvm::StringRef Source,
                                   llvm::StringRef Destination) {
+  std::lock_guard Lock(FilenameMapMutex);
   if (FilenameMap.count(Source) == 0) {
     return llvm::createStringError(llvm::inconvertibleErrorCode(),
                                    "Source file %s does not exist",
@@ -361,7 +381,8 @@ llvm::Error S3StorageClient::copy(llvm::StringRef Source,
 llvm::Expected<std::unique_ptr<ReadableFile>>
 S3StorageClient::getReadableFile(llvm::StringRef Path) {
   using llvm::MemoryBuffer;
-  if (FilenameMap.count(Path) == 0) {
+  auto MaybeFilename = lookup(Path);
+  if (not MaybeFilename) {
     return llvm::createStringError(llvm::inconvertibleErrorCode(),
                                    "File %s does not exist",
                                    Path.str().c_str());
@@ -369,7 +390,7 @@ S3StorageClient::getReadableFile(llvm::StringRef Path) {
 
   Aws::S3::Model::GetObjectRequest Request;
   Request.SetBucket(Bucket);
-  Request.SetKey(resolvePath(FilenameMap[Path]));
+  Request.SetKey(resolvePath(*MaybeFilename));
 
   Aws::S3::Model::GetObjectOutcome Result = Client.GetObject(Request);
   if (not Result.IsSuccess())
@@ -435,6 +456,7 @@ llvm::Error S3StorageClient::commit() {
   std::string SerializedIndex;
 
   {
+    std::lock_guard Lock(FilenameMapMutex);
     llvm::raw_string_ostream OS(SerializedIndex);
     llvm::yaml::Output YAMLOutput(OS);
     YAMLOutput << FilenameMap;
@@ -457,6 +479,7 @@ llvm::Error S3StorageClient::commit() {
 }
 
 llvm::Error S3StorageClient::setCredentials(llvm::StringRef Credentials) {
+  std::lock_guard Lock(CredentialsMutex);
   this->Credentials = readCredentials(Credentials);
   return llvm::Error::success();
 }
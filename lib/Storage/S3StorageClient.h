@@ -4,6 +4,9 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <mutex>
+#include <optional>
+
 #include "aws/core/auth/AWSCredentials.h"
 #include "aws/s3/S3Client.h"
 
@@ -19,11 +22,15 @@ class S3WritableFile;
 class S3StorageClient : public StorageClient {
 private:
   Aws::Auth::AWSCredentials Credentials;
+  /// Protects Credentials, which are read by Client on each request
+  std::mutex CredentialsMutex;
   Aws::S3::S3Client Client;
   std::string Bucket;
   std::string SubPath;
   std::string RedactedURL;
   llvm::StringMap<std::string> FilenameMap;
+  /// Protects FilenameMap. It is never held during a request to S3.
+  std::mutex FilenameMapMutex;
   static constexpr auto IndexName = "index.yml";
 
 public:
@@ -60,6 +67,7 @@ public:
 private:
   std::string dumpString() const override;
   std::string resolvePath(llvm::StringRef Path);
+  std::optional<std::string> lookup(llvm::StringRef Path);
   friend class S3WritableFile;
 };
 
@@ -145,17 +145,36 @@ namespace revng {
 // Append a given file to an archive.
 OffsetDescriptor GzipTarWriter::append(llvm::StringRef Path,
                                        llvm::ArrayRef<char> Data) {
+  return appendImpl(Path, Data.size(), [&] {
+    gzipCompress(*OS, { Data.data(), Data.size() });
+  });
+}
+
+// Append a given file, whose data has already been compressed, to an archive.
+OffsetDescriptor
+GzipTarWriter::appendCompressed(llvm::StringRef Path,
+                                size_t Size,
+                                llvm::ArrayRef<char> CompressedData) {
+  return appendImpl(Path, Size, [&] {
+    OS->write(CompressedData.data(), CompressedData.size());
+  });
+}
+
+OffsetDescriptor
+GzipTarWriter::appendImpl(llvm::StringRef Path,
+                          size_t Size,
+                          llvm::function_ref<void()> WriteData) {
   revng_assert(OS != nullptr);
   revng_assert(not Filenames.contains(Path));
 
   OffsetDescriptor Result = { .Start = OS->tell() };
-  writeFileHeader(*OS, Path, Data.size());
+  writeFileHeader(*OS, Path, Size);
 
   Result.DataStart = OS->tell();
-  gzipCompress(*OS, { Data.data(), Data.size() });
+  WriteData();
 
   Result.PaddingStart = OS->tell();
-  if (size_t Padding = computePadding(Data.size()); Padding % BlockSize != 0)
+  if (size_t Padding = computePadding(Size); Padding % BlockSize != 0)
     compressedPadding(*OS, Padding);
 
   Result.End = OS->tell();
@@ -197,9 +216,9 @@ cppcoro::generator<ArchiveEntry> GzipTarReader::entries() {
     int64_t Size = archive_entry_size(Entry);
     revng_assert(Size >= 0);
 
-    llvm::SmallVector<char, 0> Data;
+    std::string Data;
     if (Size > 0) {
-      Data.resize_for_overwrite(Size);
+      Data.resize(Size);
       size_t SizeRead = archive_read_data(Archive, Data.data(), Size);
       revng_assert(SizeRead == static_cast<size_t>(Size));
     }
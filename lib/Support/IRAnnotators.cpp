@@ -19,6 +19,7 @@
 #include "revng/Support/FunctionTags.h"
 #include "revng/Support/IRAnnotators.h"
 #include "revng/Support/IRHelpers.h"
+#include "revng/Support/OriginalAssemblyAnnotationWriter.h"
 #include "revng/Support/SelfReferencingDbgAnnotationWriter.h"
 
 using namespace llvm;
@@ -85,9 +86,11 @@ void createSelfReferencingDebugInfo(Module *M,
   M->print(NullStream, &Annotator);
 }
 
-static void createDebugInfoFromMetadata(Module *M,
-                                        StringRef SourcePath,
-                                        StringRef MetadataName) {
+using GetTextFunction = function_ref<StringRef(const Instruction *)>;
+
+static void createDebugInfoFromText(Module *M,
+                                    StringRef SourcePath,
+                                    GetTextFunction GetText) {
   createModuleDebugInfo(M, SourcePath);
 
   std::ofstream SourceOutputStream(SourcePath.str());
@@ -95,7 +98,6 @@ static void createDebugInfoFromMetadata(Module *M,
 
   // Generate the source file and the debugging information in tandem
   unsigned LineIndex = 1;
-  unsigned MetadataKind = M->getContext().getMDKindID(MetadataName);
   unsigned DbgKind = M->getContext().getMDKindID("dbg");
 
   StringRef Last;
@@ -107,7 +109,7 @@ static void createDebugInfoFromMetadata(Module *M,
     if (DISubprogram *CurrentSubprogram = F.getSubprogram()) {
       for (BasicBlock &Block : F) {
         for (Instruction &I : Block) {
-          StringRef Body = getText(&I, MetadataKind);
+          StringRef Body = GetText(&I);
 
           if (Body.size() != 0 && Last != Body) {
             Last = Body;
@@ -127,9 +129,17 @@ static void createDebugInfoFromMetadata(Module *M,
 }
 
 void createPTCDebugInfo(Module *M, StringRef SourcePath) {
-  createDebugInfoFromMetadata(M, SourcePath, "pi");
+  unsigned PTCInstrMDKind = M->getContext().getMDKindID("pi");
+  auto GetPTC = [PTCInstrMDKind](const Instruction *I) {
+    return getText(I, PTCInstrMDKind);
+  };
+  createDebugInfoFromText(M, SourcePath, GetPTC);
 }
 
 void createOriginalAssemblyDebugInfo(Module *M, StringRef SourcePath) {
-  createDebugInfoFromMetadata(M, SourcePath, "oi");
+  OriginalAssemblyIndex Index(*M);
+  auto GetOriginalAssembly = [&Index](const Instruction *I) {
+    return Index.get(I);
+  };
+  createDebugInfoFromText(M, SourcePath, GetOriginalAssembly);
 }
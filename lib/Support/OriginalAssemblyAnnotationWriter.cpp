@@ -8,6 +8,8 @@
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support/FormattedStream.h"
 
 #include "revng/ADT/STLExtras.h"
@@ -16,15 +18,49 @@
 
 using namespace llvm;
 
-/// Writes the text contained in the metadata with the specified kind ID to the
-/// output stream, unless that metadata is exactly the same as in the previous
-/// instruction.
-static void writeMetadataIfNew(const Instruction *I,
-                               unsigned MDKind,
-                               formatted_raw_ostream &Output,
-                               StringRef Prefix) {
+OriginalAssemblyIndex::OriginalAssemblyIndex(const Module &M) :
+  OriginalInstrMDKind(M.getContext().getMDKindID("oi")) {
+  Function *NewPC = M.getFunction("newpc");
+  if (NewPC == nullptr)
+    return;
+
+  for (User *U : NewPC->users()) {
+    auto *Call = dyn_cast<CallBase>(U);
+    if (Call == nullptr or not isCallTo(Call, "newpc"))
+      continue;
+
+    using namespace NewPCArguments;
+    Value *Argument = Call->getArgOperand(DissassembledInstruction);
+    Argument = Argument->stripPointerCasts();
+    StringRef Text = extractFromConstantStringPtr(Argument);
+    if (not Text.empty())
+      Disassembly.try_emplace(addressFromNewPC(Call), Text);
+  }
+}
+
+StringRef OriginalAssemblyIndex::get(const Instruction *I) const {
+  MDNode *Node = I->getMetadata(OriginalInstrMDKind);
+  if (Node == nullptr)
+    return StringRef();
+
+  auto *MDPC = cast<ConstantAsMetadata>(Node->getOperand(0));
+  auto It = Disassembly.find(MetaAddress::fromValue(MDPC->getValue()));
+  if (It == Disassembly.end())
+    return StringRef();
+
+  return It->second;
+}
+
+using GetTextFunction = function_ref<StringRef(const Instruction *)>;
+
+/// Writes the text obtained through \p GetText to the output stream, unless
+/// it's exactly the same as in the previous instruction.
+static void writeTextIfNew(const Instruction *I,
+                           GetTextFunction GetText,
+                           formatted_raw_ostream &Output,
+                           StringRef Prefix) {
   auto BeginIt = I->getParent()->begin();
-  StringRef Text = getText(I, MDKind);
+  StringRef Text = GetText(I);
   if (Text.size()) {
     StringRef LastText;
 
@@ -33,7 +69,7 @@ static void writeMetadataIfNew(const Instruction *I,
         I = nullptr;
       } else {
         I = I->getPrevNode();
-        LastText = getText(I, MDKind);
+        LastText = GetText(I);
       }
     } while (I != nullptr && LastText.size() == 0);
 
@@ -51,7 +87,16 @@ void OAAW::emitInstructionAnnot(const Instruction *I,
 
   // Ignore whatever is outside the root and the isolated functions
   if (isRootOrLifted(I->getParent()->getParent())) {
-    writeMetadataIfNew(I, OriginalInstrMDKind, Output, "\n  ; ");
-    writeMetadataIfNew(I, PTCInstrMDKind, Output, "\n  ; ");
+    if (not Index.has_value())
+      Index.emplace(*I->getModule());
+
+    auto GetOriginalAssembly = [this](const Instruction *I) {
+      return Index->get(I);
+    };
+    auto GetPTC = [this](const Instruction *I) {
+      return getText(I, PTCInstrMDKind);
+    };
+    writeTextIfNew(I, GetOriginalAssembly, Output, "\n  ; ");
+    writeTextIfNew(I, GetPTC, Output, "\n  ; ");
   }
 }
@@ -11,90 +11,369 @@ extern "C" {
 }
 #endif
 
+extern "C" {
+#include "unistd.h"
+}
+
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Progress.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h"
 
 #include "revng/Support/Assert.h"
 #include "revng/Support/Debug.h"
+#include "revng/Support/ProgressTrace.h"
 
 static void destroyTraceProgressListener(void *OpaqueListener);
 
+static uint64_t traceMinDuration();
+
+static std::chrono::milliseconds progressRefreshInterval();
+
+/// Records tasks and steps in the binary format described in ProgressTrace.h
+///
+/// Each thread records its events in its own buffer and appends them to the
+/// output as a single chunk, with a single write, when the buffer grows large
+/// enough. Spans are recorded when they end, which allows to drop the ones
+/// shorter than `-trace-min-duration`.
+///
+/// The state of a thread is only accessed by someone else when the listener is
+/// closed. Since this might happen in a signal handler, access to it is
+/// regulated by an atomic flag rather than by a mutex, and the states are
+/// registered in a fixed-size array which can be walked without locking.
 class TraceProgressListener : public llvm::ProgressListener {
 private:
-  std::error_code EC;
+  static constexpr size_t FlushThreshold = 64 * 1024;
+
+  /// Events of threads registered beyond this limit are not recorded
+  static constexpr size_t MaxThreads = 1024;
+
+  /// Size of the buffer used to compose chunks in the signal handler
+  static constexpr size_t ScratchSize = 4 * FlushThreshold;
+
+  struct OpenSpan {
+    llvm::SmallString<32> Name;
+    uint64_t Start = 0;
+  };
+
+  struct ThreadState {
+    /// Set by whoever is accessing the state: the owning thread while
+    /// recording, or close()
+    std::atomic<bool> Busy = false;
+    uint64_t TID = llvm::get_threadid();
+    std::string Buffer;
+    llvm::SmallVector<OpenSpan, 8> Stack;
+  };
+
+private:
+  static inline std::atomic<uint64_t> NextID = 1;
+
+  /// Identifies this listener in the thread-local cache of state(): unlike its
+  /// address, it's never reused
+  const uint64_t ID = NextID++;
+
+  int FD = -1;
+  std::atomic<bool> Closed = false;
 
-  // TODO: consider buffering in thread-local buffers
+  /// Serializes the writes outside of the signal handler and protects Owned
   llvm::sys::Mutex OutputMutex;
-  llvm::raw_fd_ostream Output;
-  bool Closed = false;
+  std::vector<std::unique_ptr<ThreadState>> Owned;
+
+  /// The first ThreadsCount elements are the states of the registered threads
+  std::array<std::atomic<ThreadState *>, MaxThreads> Threads = {};
+  std::atomic<size_t> ThreadsCount = 0;
+
+  std::unique_ptr<char[]> Scratch;
 
 public:
   static constexpr bool AllThreads = true;
 
 public:
-  TraceProgressListener(llvm::StringRef OutputPath) : Output(OutputPath, EC) {
-    revng_assert(!EC);
-    Output << "[\n";
+  TraceProgressListener(llvm::StringRef OutputPath) :
+    Scratch(std::make_unique<char[]>(ScratchSize)) {
+    if (OutputPath == "-") {
+      FD = STDOUT_FILENO;
+    } else {
+      std::error_code EC = llvm::sys::fs::openFileForWrite(OutputPath, FD);
+      revng_assert(!EC);
+    }
+
+    std::string Header;
+    llvm::raw_string_ostream Stream(Header);
+    ProgressTrace::writeHeader(Stream, llvm::sys::Process::getProcessId());
+    Stream.flush();
+    writeAll(Header.data(), Header.size());
+
     llvm::sys::AddSignalHandler(destroyTraceProgressListener, this);
   }
 
-  ~TraceProgressListener() override { close("Graceful exit"); }
+  ~TraceProgressListener() override {
+    close("Graceful exit");
+    if (FD != STDOUT_FILENO)
+      llvm::sys::Process::SafelyCloseFileDescriptor(FD);
+  }
 
 public:
   void close(llvm::StringRef ExitReason) {
-    if (not Closed) {
-      Closed = true;
-      emitEvent<false>(ExitReason, "task", "i");
-      Output << "]\n";
-      Output.flush();
+    llvm::sys::ScopedLock OutputLock(OutputMutex);
+    if (Closed.exchange(true))
+      return;
+
+    // Record the spans that are still open as ending now
+    uint64_t Now = now();
+    for (std::unique_ptr<ThreadState> &State : Owned) {
+      acquire(*State);
+      while (not State->Stack.empty())
+        end(*State, Now);
+      flush(*State);
+      release(*State);
+    }
+
+    // The exit event is recorded on its own: the current thread might not have
+    // a state yet
+    std::string Event;
+    ProgressTrace::appendEvent(Event, ProgressTrace::Instant, ExitReason, Now);
+    std::string Chunk;
+    ProgressTrace::appendChunkHeader(Chunk, llvm::get_threadid(), Event.size());
+    Chunk += Event;
+    writeAll(Chunk.data(), Chunk.size());
+  }
+
+  /// Same as close, but async-signal-safe: it does not allocate memory, take
+  /// locks or wait for other threads. The events of the threads that are in
+  /// the middle of recording one, including the interrupted one, are dropped.
+  void closeFromSignalHandler(llvm::StringRef ExitReason) {
+    if (Closed.exchange(true))
+      return;
+
+    uint64_t Now = now();
+    size_t Count = ThreadsCount.load(std::memory_order_acquire);
+    for (size_t I = 0; I < Count; ++I) {
+      ThreadState &State = *Threads[I].load(std::memory_order_acquire);
+      if (not tryAcquire(State))
+        continue;
+
+      // Compute the size of the chunk
+      size_t Size = State.Buffer.size();
+      for (const OpenSpan &Span : State.Stack)
+        if (uint64_t Duration = Now - Span.Start; recorded(Duration))
+          Size += eventSize(Span, Duration);
+
+      if (Size == 0 or ProgressTrace::MaxChunkHeaderSize + Size > ScratchSize)
+        continue;
+
+      char *Output = Scratch.get();
+      Output += ProgressTrace::encodeChunkHeader(Output, State.TID, Size);
+      Output = std::copy(State.Buffer.begin(), State.Buffer.end(), Output);
+      for (const OpenSpan &Span : llvm::reverse(State.Stack)) {
+        uint64_t Duration = Now - Span.Start;
+        if (recorded(Duration))
+          Output += ProgressTrace::encodeEvent(Output,
+                                               ProgressTrace::Span,
+                                               Span.Name,
+                                               Span.Start,
+                                               Duration);
+      }
+      writeAll(Scratch.get(), Output - Scratch.get());
     }
+
+    char *Output = Scratch.get();
+    size_t Size = ProgressTrace::eventSize(ProgressTrace::Instant,
+                                           ExitReason,
+                                           Now);
+    Output += ProgressTrace::encodeChunkHeader(Output,
+                                               llvm::get_threadid(),
+                                               Size);
+    Output += ProgressTrace::encodeEvent(Output,
+                                         ProgressTrace::Instant,
+                                         ExitReason,
+                                         Now);
+    writeAll(Scratch.get(), Output - Scratch.get());
   }
 
 public:
   void handleNewTask(const llvm::Task *T) override {
-    llvm::sys::ScopedLock Lock(OutputMutex);
-    emitEvent(T->name(), "task", "B");
+    ThreadState *State = state();
+    if (State == nullptr)
+      return;
+
+    acquire(*State);
+    begin(*State, T->name(), now());
+    release(*State);
   }
 
   void handleTaskCompleted(const llvm::Task *T) override {
-    llvm::sys::ScopedLock Lock(OutputMutex);
-    if (T->stepIndex() != -1) {
-      emitEvent(T->stepName(), "task", "E");
-    }
-    emitEvent(T->name(), "task", "E");
+    ThreadState *State = state();
+    if (State == nullptr)
+      return;
+
+    acquire(*State);
+    uint64_t Now = now();
+    if (T->stepIndex() != -1)
+      end(*State, Now);
+    end(*State, Now);
+    bool ShouldFlush = State->Buffer.size() >= FlushThreshold;
+    release(*State);
+
+    if (ShouldFlush)
+      flushFromOwner(*State);
   }
 
   void handleTaskAdvancement(const llvm::Task *T,
                              llvm::StringRef PreviousStepName) override {
-    llvm::sys::ScopedLock Lock(OutputMutex);
+    ThreadState *State = state();
+    if (State == nullptr)
+      return;
+
+    acquire(*State);
+    uint64_t Now = now();
     if (T->stepIndex() != 0)
-      emitEvent(PreviousStepName, "task", "E");
-    emitEvent(T->stepName(), "task", "B");
-  }
-
-  template<bool EmitTrailingComma = true>
-  void emitEvent(llvm::StringRef Name,
-                 llvm::StringRef Category,
-                 llvm::StringRef Phase) {
-    Output << "{";
-    Output << "\"name\": \"" << Name.str() << "\", ";
-    Output << "\"cat\": \"" << Category.str() << "\", ";
-    Output << "\"ph\": \"" << Phase.str() << "\", ";
+      end(*State, Now);
+    begin(*State, T->stepName(), Now);
+    bool ShouldFlush = State->Buffer.size() >= FlushThreshold;
+    release(*State);
+
+    if (ShouldFlush)
+      flushFromOwner(*State);
+  }
+
+private:
+  static uint64_t now() {
     using namespace std::chrono;
-    using std::chrono::microseconds;
     auto Epoch = system_clock::now().time_since_epoch();
-    unsigned long long Timestamp = duration_cast<microseconds>(Epoch).count();
-    Output << "\"ts\": " << Timestamp << ", ";
-    Output << "\"pid\": " << getpid() << ", ";
-    Output << "\"tid\": " << getpid();
-    Output << "}";
-    if (EmitTrailingComma)
-      Output << ",";
-    Output << "\n";
+    return duration_cast<microseconds>(Epoch).count();
+  }
+
+  static bool recorded(uint64_t Duration) {
+    return Duration >= traceMinDuration();
+  }
+
+  static size_t eventSize(const OpenSpan &Span, uint64_t Duration) {
+    return ProgressTrace::eventSize(ProgressTrace::Span,
+                                    Span.Name,
+                                    Span.Start,
+                                    Duration);
+  }
+
+  /// Wait until \p State is not being accessed by anybody else and mark it as
+  /// busy. Only contended while closing.
+  static void acquire(ThreadState &State) {
+    while (State.Busy.exchange(true, std::memory_order_acquire))
+      std::this_thread::yield();
+  }
+
+  static bool tryAcquire(ThreadState &State) {
+    return not State.Busy.exchange(true, std::memory_order_acquire);
+  }
+
+  static void release(ThreadState &State) {
+    State.Busy.store(false, std::memory_order_release);
+  }
+
+  /// Get the state of the current thread, registering it on first use.
+  ///
+  /// \return nullptr if too many threads have been registered
+  ThreadState *state() {
+    struct Cache {
+      uint64_t Owner = 0;
+      ThreadState *State = nullptr;
+    };
+    static thread_local Cache Current;
+
+    if (Current.Owner != ID) {
+      Current.Owner = ID;
+      Current.State = registerThread();
+    }
+
+    return Current.State;
+  }
+
+  ThreadState *registerThread() {
+    llvm::sys::ScopedLock Lock(OutputMutex);
+    size_t Index = ThreadsCount.load(std::memory_order_relaxed);
+    if (Index == MaxThreads)
+      return nullptr;
+
+    auto *State = Owned.emplace_back(std::make_unique<ThreadState>()).get();
+    Threads[Index].store(State, std::memory_order_release);
+    ThreadsCount.store(Index + 1, std::memory_order_release);
+    return State;
+  }
+
+  static void begin(ThreadState &State, llvm::StringRef Name, uint64_t Now) {
+    OpenSpan &Span = State.Stack.emplace_back();
+    Span.Name = Name;
+    Span.Start = Now;
+  }
+
+  /// \note Requires State to be acquired
+  void end(ThreadState &State, uint64_t Now) {
+    // Tolerate events of tasks started before the listener was registered
+    if (State.Stack.empty())
+      return;
+
+    OpenSpan &Span = State.Stack.back();
+    uint64_t Duration = Now - Span.Start;
+    if (recorded(Duration)) {
+      ProgressTrace::appendEvent(State.Buffer,
+                                 ProgressTrace::Span,
+                                 Span.Name,
+                                 Span.Start,
+                                 Duration);
+    }
+    State.Stack.pop_back();
+  }
+
+  void flushFromOwner(ThreadState &State) {
+    llvm::sys::ScopedLock OutputLock(OutputMutex);
+    acquire(State);
+    if (Closed)
+      State.Buffer.clear();
+    else
+      flush(State);
+    release(State);
+  }
+
+  /// \note Requires OutputMutex to be held and State to be acquired
+  void flush(ThreadState &State) {
+    if (State.Buffer.empty())
+      return;
+
+    std::string Chunk;
+    ProgressTrace::appendChunkHeader(Chunk, State.TID, State.Buffer.size());
+    Chunk += State.Buffer;
+    writeAll(Chunk.data(), Chunk.size());
+    State.Buffer.clear();
+  }
+
+  /// Write \p Size bytes as a single write, if possible, so that chunks
+  /// written at the same time by other threads do not interleave with them.
+  /// Async-signal-safe.
+  void writeAll(const char *Data, size_t Size) {
+    while (Size > 0) {
+      ssize_t Written = ::write(FD, Data, Size);
+      if (Written < 0) {
+        if (errno == EINTR)
+          continue;
+        return;
+      }
+      Data += Written;
+      Size -= Written;
+    }
   }
 };
 
@@ -163,10 +442,7 @@ private:
   std::vector<TimePoint> StartTimes;
 
 private:
-  static constexpr auto drawThreshold() {
-    using namespace std::chrono_literals;
-    return 50ms;
-  }
+  static auto drawThreshold() { return progressRefreshInterval(); }
 
 public:
   static constexpr bool AllThreads = false;
@@ -341,7 +617,7 @@ public:
 
 static void destroyTraceProgressListener(void *OpaqueListener) {
   auto *Listener = static_cast<TraceProgressListener *>(OpaqueListener);
-  Listener->close("Exit due to signal");
+  Listener->closeFromSignalHandler("Exit due to signal");
 }
 
 using namespace llvm::cl;
@@ -354,7 +630,20 @@ static auto RegisterTraceProgressListener = [](const std::string &Value) {
 
 static auto TPLCallback = callback(RegisterTraceProgressListener);
 
-static opt<std::string> TraceProgress("trace", TPLCallback);
+static opt<std::string> TraceProgress("trace",
+                                      desc("Record tasks in the given file, "
+                                           "see `revng progress-trace`"),
+                                      TPLCallback);
+
+static opt<uint64_t> TraceMinDuration("trace-min-duration",
+                                      desc("Do not record in the trace tasks "
+                                           "and steps shorter than this many "
+                                           "microseconds"),
+                                      init(0));
+
+static uint64_t traceMinDuration() {
+  return TraceMinDuration;
+}
 
 static auto RegisterTerminalBarsProgressListener = [](const bool &Value) {
   using namespace llvm;
@@ -367,6 +656,20 @@ static auto RTBPLCallback = callback(RegisterTerminalBarsProgressListener);
 
 static opt<bool> ProgressBars("progress", RTBPLCallback);
 
+static opt<unsigned> ProgressMaxRefreshRate("progress-max-refresh-rate",
+                                            desc("maximum number of times "
+                                                 "per second the progress "
+                                                 "bars are redrawn, 0 means "
+                                                 "no limit"),
+                                            init(20));
+
+static std::chrono::milliseconds progressRefreshInterval() {
+  using namespace std::chrono;
+  if (ProgressMaxRefreshRate == 0)
+    return milliseconds(0);
+  return milliseconds(1000 / ProgressMaxRefreshRate);
+}
+
 static auto RegisterProgressPlain = callback([](const bool &Value) {
   if (Value)
     llvm::ProgressReport->registerListener<PlainProgressListener>(llvm::errs());
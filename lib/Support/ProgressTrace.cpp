@@ -0,0 +1,159 @@
+/// \file ProgressTrace.cpp
+/// \brief Encoding and decoding of the binary traces produced by `--trace`
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+
+#include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/LEB128.h"
+
+#include "revng/Support/ProgressTrace.h"
+
+using namespace llvm;
+
+namespace ProgressTrace {
+
+static size_t encodeULEB128(uint64_t Value, char *Output) {
+  return llvm::encodeULEB128(Value, reinterpret_cast<uint8_t *>(Output));
+}
+
+size_t eventSize(EventKind Kind,
+                 StringRef Name,
+                 uint64_t Timestamp,
+                 uint64_t Duration) {
+  size_t Result = 1 + getULEB128Size(Timestamp);
+  if (Kind == Span)
+    Result += getULEB128Size(Duration);
+  return Result + getULEB128Size(Name.size()) + Name.size();
+}
+
+size_t encodeEvent(char *Output,
+                   EventKind Kind,
+                   StringRef Name,
+                   uint64_t Timestamp,
+                   uint64_t Duration) {
+  char *Start = Output;
+  *Output++ = static_cast<char>(Kind);
+  Output += encodeULEB128(Timestamp, Output);
+  if (Kind == Span)
+    Output += encodeULEB128(Duration, Output);
+  Output += encodeULEB128(Name.size(), Output);
+  std::copy(Name.begin(), Name.end(), Output);
+  return Output + Name.size() - Start;
+}
+
+void appendEvent(std::string &Buffer,
+                 EventKind Kind,
+                 StringRef Name,
+                 uint64_t Timestamp,
+                 uint64_t Duration) {
+  size_t Offset = Buffer.size();
+  Buffer.resize(Offset + eventSize(Kind, Name, Timestamp, Duration));
+  encodeEvent(Buffer.data() + Offset, Kind, Name, Timestamp, Duration);
+}
+
+size_t encodeChunkHeader(char *Output, uint64_t TID, uint64_t Size) {
+  size_t Length = encodeULEB128(TID, Output);
+  return Length + encodeULEB128(Size, Output + Length);
+}
+
+void appendChunkHeader(std::string &Buffer, uint64_t TID, uint64_t Size) {
+  char Encoded[MaxChunkHeaderSize];
+  Buffer.append(Encoded, encodeChunkHeader(Encoded, TID, Size));
+}
+
+void writeChunkHeader(raw_ostream &Output, uint64_t TID, uint64_t Size) {
+  char Encoded[MaxChunkHeaderSize];
+  Output.write(Encoded, encodeChunkHeader(Encoded, TID, Size));
+}
+
+void writeHeader(raw_ostream &Output, uint32_t PID) {
+  Output << Magic;
+  support::endian::write<uint32_t>(Output, Version, support::little);
+  support::endian::write<uint32_t>(Output, PID, support::little);
+}
+
+static Error createError(const Twine &Message) {
+  return createStringError(inconvertibleErrorCode(),
+                           "Invalid trace: " + Message);
+}
+
+Error toChromeJSON(StringRef Trace, raw_ostream &Output) {
+  if (not Trace.startswith(Magic))
+    return createError("wrong magic");
+
+  DataExtractor Data(Trace, /* IsLittleEndian */ true, /* AddressSize */ 8);
+  DataExtractor::Cursor Cursor(Magic.size());
+  uint32_t TraceVersion = Data.getU32(Cursor);
+  uint32_t PID = Data.getU32(Cursor);
+  if (not Cursor)
+    return Cursor.takeError();
+  if (TraceVersion != Version)
+    return createError("unsupported version " + Twine(TraceVersion));
+
+  bool Truncated = false;
+  bool InvalidKind = false;
+  json::OStream JSON(Output);
+  JSON.array([&] {
+    while (Cursor and not Data.eof(Cursor)) {
+      uint64_t TID = Data.getULEB128(Cursor);
+      uint64_t Size = Data.getULEB128(Cursor);
+      uint64_t End = Cursor.tell() + Size;
+      if (Cursor and End > Trace.size()) {
+        Truncated = true;
+        break;
+      }
+
+      while (Cursor and Cursor.tell() < End) {
+        auto Kind = static_cast<EventKind>(Data.getU8(Cursor));
+        if (Cursor and Kind != Span and Kind != Instant) {
+          InvalidKind = true;
+          break;
+        }
+        uint64_t Timestamp = Data.getULEB128(Cursor);
+        uint64_t Duration = Kind == Span ? Data.getULEB128(Cursor) : 0;
+        uint64_t NameSize = Data.getULEB128(Cursor);
+        StringRef Name = Data.getBytes(Cursor, NameSize);
+        if (not Cursor)
+          break;
+
+        JSON.object([&] {
+          JSON.attribute("name", Name);
+          JSON.attribute("cat", "task");
+          if (Kind == Span) {
+            JSON.attribute("ph", "X");
+            JSON.attribute("dur", static_cast<int64_t>(Duration));
+          } else {
+            JSON.attribute("ph", "i");
+          }
+          JSON.attribute("ts", static_cast<int64_t>(Timestamp));
+          JSON.attribute("pid", static_cast<int64_t>(PID));
+          JSON.attribute("tid", static_cast<int64_t>(TID));
+        });
+      }
+
+      if (InvalidKind)
+        break;
+    }
+  });
+  Output << "\n";
+
+  if (not Cursor)
+    return Cursor.takeError();
+
+  // Traces of processes that have been killed might end with a partial chunk
+  if (Truncated)
+    return createError("truncated chunk");
+
+  if (InvalidKind)
+    return createError("unknown event kind");
+
+  return Error::success();
+}
+
+} // namespace ProgressTrace
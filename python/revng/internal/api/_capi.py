@@ -55,6 +55,10 @@ class ApiWrapper:
         re.M | re.S,
     )
 
+    # Functions that are safe to call while other functions are running, these
+    # will not take the lock
+    unlocked_functions = {"rp_manager_save_snapshot"}
+
     def __init__(self, api, ffi: FFI):
         self.__api = api
         self.__ffi = ffi
@@ -79,7 +83,10 @@ class ApiWrapper:
             if attribute_name.startswith("RP_") or attribute_name in self.__proxy:
                 continue
             function = getattr(self.__api, attribute_name)
-            self.__proxy[attribute_name] = self.__wrap_lock(function)
+            if attribute_name in self.unlocked_functions:
+                self.__proxy[attribute_name] = function
+            else:
+                self.__proxy[attribute_name] = self.__wrap_lock(function)
 
     def __wrap_gc(self, function, destructor):
         def wrapped_destructor(ptr):
@@ -55,6 +55,15 @@ class Manager:
     def save(self):
         return _api.rp_manager_save(self._manager)
 
+    def snapshot(self):
+        """Take a snapshot of the manager, to be saved with save_snapshot"""
+        return _api.rp_manager_snapshot(self._manager)
+
+    def save_snapshot(self, snapshot) -> bool:
+        """Save a snapshot taken with `snapshot`. This does not prevent other methods from
+        being called while the save is in progress."""
+        return _api.rp_manager_save_snapshot(self._manager, snapshot)
+
     # description utilities
 
     def kind_from_name(self, name: str):
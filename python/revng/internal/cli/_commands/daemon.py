@@ -35,6 +35,9 @@ REVNG_NOTIFY_FIFOS: list of fifo pipes to be notified of changes in the pipeline
 REVNG_ORIGINS: comma-separated list of allowed CORS origins
 REVNG_EXPOSE_HEADERS: comma-separated list of response headers to expose via CORS
 REVNG_C_API_TRACE_PATH: path to file to use to save api tracing, useful for debugging
+REVNG_DAEMON_PREFETCH: if set to "1" artifacts likely to be requested next are produced
+  in the background while the daemon is idle
+REVNG_DAEMON_PREFETCH_IDLE: seconds of inactivity before prefetching starts (default 1)
 
 Persistence:
 If the REVNG_DATA_DIR environment variable is set, the the data is persisted across
@@ -4,6 +4,8 @@
 # mypy: disable-error-code="attr-defined,name-defined"
 
 import sys
+import time
+from contextlib import contextmanager
 from typing import Dict, List, Optional, Set, Tuple, Union
 
 import idb
@@ -98,17 +100,33 @@ class IDBConverter:
         self._ordinal_types_to_fixup: Set[Tuple[m.Type, int]] = set()
         self._unions_to_fixup: Set[Tuple[m.UnionDefinition, idb.typeinf.TInfo]] = set()
 
-        self._import_types()
-        self._fixup_structs()
-        self._fixup_unions()
-        self._fixup_ordinal_types()
-        self._import_functions()
-        self._collect_imports()
+        # Conversions of references to named typedefs, and the prototype used for dynamic
+        # functions without a signature. Both would otherwise emit a new, identical definition
+        # for each use, only for `-deduplicate-equivalent-types` to merge them back.
+        self._typedef_references: Dict[Tuple[str, int, bool], m.Type] = {}
+        self._empty_prototype: Optional[m.Type] = None
+
+        with self.phase("Importing types"):
+            self._import_types()
+        with self.phase("Fixing up types"):
+            self._fixup_structs()
+            self._fixup_unions()
+            self._fixup_ordinal_types()
+        with self.phase("Importing functions"):
+            self._import_functions()
+        with self.phase("Collecting imports"):
+            self._collect_imports()
 
     def log(self, message):
         if self.verbose:
             sys.stderr.write(message + "\n")
 
+    @contextmanager
+    def phase(self, name):
+        start = time.perf_counter()
+        yield
+        self.log(f"{name} took {time.perf_counter() - start:.3f}s")
+
     def _import_types(self):
         """Imports initial types from the IDB. The types will be incomplete and need to be fixed"""
         til = self.idb.til
@@ -189,12 +207,7 @@ class IDBConverter:
         if function_type is not None:
             prototype = self._convert_idb_type_to_revng_type(function_type)
         else:
-            prototype_definition = m.CABIFunctionDefinition(
-                ABI=revng_arch_to_abiname[self.arch],
-                Arguments=[],
-            )
-            self.revng_types_by_id[prototype_definition.ID] = prototype_definition
-            prototype = self._type_for_definition(prototype_definition)
+            prototype = self._get_empty_prototype()
         dynamic_function = m.DynamicFunction(
             OriginalName=function_name,
             Prototype=prototype,
@@ -231,6 +244,16 @@ class IDBConverter:
                 self.imported_libraries.append(mod_name)
             self.api.ida_nalt.enum_import_names(mod_index, import_names_callback)
 
+    def _get_empty_prototype(self) -> m.Type:
+        if self._empty_prototype is None:
+            prototype_definition = m.CABIFunctionDefinition(
+                ABI=revng_arch_to_abiname[self.arch],
+                Arguments=[],
+            )
+            self.revng_types_by_id[prototype_definition.ID] = prototype_definition
+            self._empty_prototype = self._type_for_definition(prototype_definition)
+        return self._empty_prototype
+
     def _fixup_ordinal_types(self):
         """Fixes some types that were referring an ordinal that was not observed yet."""
         while self._ordinal_types_to_fixup:
@@ -344,6 +367,15 @@ class IDBConverter:
                 if aliased_tiltypeinfo:
                     aliased_type_ordinal = aliased_tiltypeinfo.ordinal
 
+            # A reference to a typedef of a type known by ordinal always converts to the same
+            # definition, reuse it.
+            reference_key = None
+            if ordinal is None and aliased_type_ordinal is not None:
+                reference_key = (type_name, aliased_type_ordinal, type.is_decl_const())
+                existing_reference = self._typedef_references.get(reference_key)
+                if existing_reference is not None:
+                    return existing_reference
+
             underlying = self._convert_idb_type_to_revng_type(
                 aliased_type, ordinal=aliased_type_ordinal
             )
@@ -352,6 +384,12 @@ class IDBConverter:
                 OriginalName=type_name, UnderlyingType=underlying
             )
 
+            if reference_key is not None:
+                self.revng_types_by_id[resulting_definition.ID] = resulting_definition
+                result = self._type_for_definition(resulting_definition, type.is_decl_const())
+                self._typedef_references[reference_key] = result
+                return result
+
         elif type.is_decl_enum():
             underlying = m.PrimitiveType(
                 PrimitiveKind=m.PrimitiveKind.Unsigned, Size=type.type_details.storage_size
@@ -44,8 +44,6 @@ class ImportIDBCommand(Command):
             idb_converter = IDBConverter(db, base_address, options.parsed_args.verbose)
             revng_model = idb_converter.get_model()
 
-        yaml_model = yaml.dump(revng_model, Dumper=YamlDumper)
-
         def temporary_file(suffix="", mode="w+"):
             return NamedTemporaryFile(
                 prefix="revng-import-idb-",
@@ -55,50 +53,19 @@ class ImportIDBCommand(Command):
             )
 
         with temporary_file(suffix=".yml") as model_file:
-            model_file.write(yaml_model)
-            model_file.flush()
+            with idb_converter.phase("Serializing the model"):
+                yaml.dump(revng_model, model_file, Dumper=YamlDumper)
+                model_file.flush()
 
-            # Fix the model and do the clean-up.
+            # Fix the model and do the clean-up. All the passes run on a single in-memory copy of
+            # the model, in the order they are listed, so it's parsed and serialized only once.
             run_revng_command(
                 [
                     "model",
                     "opt",
                     "-purge-invalid-types",
-                    model_file.name,
-                    "-o",
-                    model_file.name,
-                ],
-                options,
-            )
-
-            run_revng_command(
-                [
-                    "model",
-                    "opt",
                     "-deduplicate-equivalent-types",
-                    model_file.name,
-                    "-o",
-                    model_file.name,
-                ],
-                options,
-            )
-
-            run_revng_command(
-                [
-                    "model",
-                    "opt",
                     "-promote-original-name",
-                    model_file.name,
-                    "-o",
-                    model_file.name,
-                ],
-                options,
-            )
-
-            run_revng_command(
-                [
-                    "model",
-                    "opt",
                     "-purge-unnamed-and-unreachable-types",
                     model_file.name,
                     "-o",
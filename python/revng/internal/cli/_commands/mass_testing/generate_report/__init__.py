@@ -75,6 +75,11 @@ class MassTestingGenerateReportCommand(Command):
         parser.description = "Generate report for mass-testing"
         parser.add_argument("input", help="Input directory")
         parser.add_argument("output", help="Output directory")
+        parser.add_argument(
+            "--baseline",
+            help="Report of a previous run to compare against, regressions will be shown in "
+            + "the comparison page",
+        )
 
     def run(self, options: Options):
         args = options.parsed_args
@@ -106,6 +111,9 @@ class MassTestingGenerateReportCommand(Command):
         db.unlink(missing_ok=True)
         create_and_populate(db, tests, total_counts, global_meta)
 
+        if args.baseline is not None:
+            copy2(Path(args.baseline) / "main.db", output / "baseline.db")
+
         copytree(get_root() / "share/mass-testing-report", output, dirs_exist_ok=True)
         if global_meta_path.exists():
             copy2(global_meta_path, output)
@@ -38,6 +38,11 @@ DEFAULT_COLUMNS = Schema(
         ("name TEXT PRIMARY KEY NOT NULL", lambda td: td.name),
         ("input_name TEXT NOT NULL", lambda td: td.input_name),
         ("elapsed_time REAL NOT NULL", lambda td: td.elapsed_time),
+        ("user_time REAL NOT NULL", lambda td: td.user_time),
+        ("system_time REAL NOT NULL", lambda td: td.system_time),
+        ("max_rss INTEGER NOT NULL", lambda td: td.max_rss),
+        ("major_page_faults INTEGER NOT NULL", lambda td: td.major_page_faults),
+        ("minor_page_faults INTEGER NOT NULL", lambda td: td.minor_page_faults),
         ("exit_code INTEGER NOT NULL", lambda td: td.exit_code),
         ("status TEXT NOT NULL", lambda td: td.status),
         ("has_input INTEGER NOT NULL", lambda td: td.has_input()),
@@ -89,9 +94,28 @@ def create_components_table(cursor: Cursor, items: Dict[str, Dict[str, int]]):
     cursor.executemany("INSERT INTO crash_components VALUES(?, ?, ?)", res)
 
 
+def create_timings_table(cursor: Cursor, items: Iterable[TestDirectory]):
+    # Each row is either the time spent in a step (`pipe` is empty) or the time
+    # spent in a pipe of a step
+    query = (
+        "CREATE TABLE IF NOT EXISTS timings"
+        + "(name TEXT NOT NULL, step TEXT NOT NULL, pipe TEXT NOT NULL, "
+        + "elapsed_time REAL NOT NULL);"
+    )
+    cursor.execute(query)
+    res: List[Tuple[str, str, str, float]] = []
+    for item in items:
+        for step, value in item.timings["steps"].items():
+            res.append((item.name, step, "", value))
+        for step_and_pipe, value in item.timings["pipes"].items():
+            step, pipe = step_and_pipe.split("/", 1)
+            res.append((item.name, step, pipe, value))
+    cursor.executemany("INSERT INTO timings VALUES(?, ?, ?, ?)", res)
+
+
 def create_and_populate(
     path: str | Path,
-    items: Iterable[TestDirectory],
+    items: List[TestDirectory],
     crash_counts: Dict[str, Dict[str, int]],
     meta: GlobalMeta | None,
 ):
@@ -100,5 +124,6 @@ def create_and_populate(
     cursor = conn.cursor()
     create_main_table(cursor, schema, items)
     create_components_table(cursor, crash_counts)
+    create_timings_table(cursor, items)
     conn.commit()
     conn.close()
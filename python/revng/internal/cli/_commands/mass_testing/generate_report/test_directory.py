@@ -57,6 +57,41 @@ class TestDirectory:
     def elapsed_time(self):
         return self.test_harness_data["time"]["elapsed_time"]
 
+    @property
+    def user_time(self) -> float:
+        return self.test_harness_data["time"]["user_time"]
+
+    @property
+    def system_time(self) -> float:
+        return self.test_harness_data["time"]["system_time"]
+
+    @property
+    def max_rss(self) -> int:
+        # GNU time reports the peak RSS in KiB
+        return self.test_harness_data["time"]["max_resident_set_size"] * 1024
+
+    @property
+    def major_page_faults(self) -> int:
+        return self.test_harness_data["time"]["major_io_page_faults"]
+
+    @property
+    def minor_page_faults(self) -> int:
+        return self.test_harness_data["time"]["minor_reclaim_page_faults"]
+
+    @cached_property
+    def timings(self) -> dict:
+        """Time spent in each step and pipe, as produced by `trace-timings`"""
+        timings_file = self.path / "timings.json"
+        if not timings_file.exists():
+            return {"steps": {}, "pipes": {}}
+
+        # An empty or truncated file means that `trace-timings` failed
+        try:
+            with open(timings_file) as f:
+                return json.load(f)
+        except json.JSONDecodeError:
+            return {"steps": {}, "pipes": {}}
+
     @cached_property
     def stacktrace(self) -> Stacktrace | None:
         stacktrace = self.path / "stacktrace.json"
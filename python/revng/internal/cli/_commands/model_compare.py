@@ -15,6 +15,9 @@ import argparse
 import re
 import sys
 from collections import defaultdict
+from pathlib import Path
+from subprocess import DEVNULL
+from tempfile import TemporaryDirectory
 
 import yaml
 from grandiso import find_motifs
@@ -22,6 +25,7 @@ from networkx import DiGraph
 from networkx.algorithms.shortest_paths.unweighted import all_pairs_shortest_path_length
 
 from revng.internal.cli.commands_registry import Command, CommandsRegistry, Options
+from revng.internal.cli.support import find_command, popen, try_run
 
 args = None
 
@@ -300,63 +304,100 @@ class YAMLGraph:
         return success
 
 
-def selftest():
+# Each entry is (input, reference, exact, expected result)
+selftest_corpus = [
     # Test --exact
-    args.exact = True
-
-    def test_equal(input_, reference):
-        return YAMLGraph(reference).is_equal(YAMLGraph(input_))
-
-    assert test_equal({}, {})
-    assert test_equal(3, 3)
-    assert not test_equal(2, 3)
-    assert test_equal([3], [3])
-    assert not test_equal([2], [3])
-    assert not test_equal([], {})
-    assert test_equal({"a": 2}, {"a": 2})
-    assert not test_equal({"a": 2}, {})
-    assert not test_equal({"a": 2, "b": 3}, {"b": 2, "a": 3})
-    assert test_equal([1, 2, 3], [1, 2, 3])
-    assert not test_equal([1, 3, 2], [1, 2, 3])
-
+    ({}, {}, True, True),
+    (3, 3, True, True),
+    (2, 3, True, False),
+    ([3], [3], True, True),
+    ([2], [3], True, False),
+    ([], {}, True, False),
+    ({"a": 2}, {"a": 2}, True, True),
+    ({"a": 2}, {}, True, False),
+    ({"a": 2, "b": 3}, {"b": 2, "a": 3}, True, False),
+    ([1, 2, 3], [1, 2, 3], True, True),
+    ([1, 3, 2], [1, 2, 3], True, False),
     # Test approximate for inclusion
-    args.exact = False
-
-    def test_subgraph(input_, reference):
-        return YAMLGraph(reference).is_subgraph(YAMLGraph(input_))
-
-    assert test_subgraph({}, {})
-    assert not test_subgraph({}, {"a": 2})
-    assert test_subgraph([3], [3])
-    assert not test_subgraph([2], [3])
-    assert not test_subgraph([], {})
-    assert test_subgraph({"a": 2}, {"a": 2})
-    assert test_subgraph({"a": 2}, {})
-    assert test_subgraph({"a": 2, "b": 3}, {"b": 3, "a": 2})
-    assert test_subgraph([1, 2, 3], [1, 2, 3])
-    assert test_subgraph([1, 3, 2], [1, 2, 3])
-
+    ({}, {}, False, True),
+    ({}, {"a": 2}, False, False),
+    ([3], [3], False, True),
+    ([2], [3], False, False),
+    ([], {}, False, False),
+    ({"a": 2}, {"a": 2}, False, True),
+    ({"a": 2}, {}, False, True),
+    ({"a": 2, "b": 3}, {"b": 3, "a": 2}, False, True),
+    ([1, 2, 3], [1, 2, 3], False, True),
+    ([1, 3, 2], [1, 2, 3], False, True),
     # Test references
-    reference = {
-        "a": "/TypeDefinitions/1-DoesNotMatter",
-        "TypeDefinitions": [{"ID": 1, "b": 3}],
-    }
-    assert test_subgraph(
+    (
         {
             "a": "/TypeDefinitions/2-DoesNotMatter",
             "TypeDefinitions": [{"ID": 1, "b": 5}, {"ID": 2, "b": 3}],
         },
-        reference,
-    )
-    assert not test_subgraph(
+        {"a": "/TypeDefinitions/1-DoesNotMatter", "TypeDefinitions": [{"ID": 1, "b": 3}]},
+        False,
+        True,
+    ),
+    (
         {
             "a": "/TypeDefinitions/2-DoesNotMatter",
             "TypeDefinitions": [{"ID": 1, "b": 5}, {"ID": 2, "b": 4}],
         },
-        reference,
-    )
+        {"a": "/TypeDefinitions/1-DoesNotMatter", "TypeDefinitions": [{"ID": 1, "b": 3}]},
+        False,
+        False,
+    ),
+]
+
+
+def compare_python(input_, reference, exact: bool) -> bool:
+    args.exact = exact
+    reference_graph = YAMLGraph(reference)
+    input_graph = YAMLGraph(input_)
+    if exact:
+        return reference_graph.is_equal(input_graph)
+    else:
+        return reference_graph.is_subgraph(input_graph)
+
+
+def compare_native(input_, reference, exact: bool, options: Options) -> bool:
+    with TemporaryDirectory() as directory:
+        reference_path = Path(directory) / "reference.yml"
+        input_path = Path(directory) / "input.yml"
+        reference_path.write_text(yaml.safe_dump(reference), encoding="utf-8")
+        input_path.write_text(yaml.safe_dump(input_), encoding="utf-8")
+
+        command = ["model-compare", str(reference_path), str(input_path)]
+        if exact:
+            command.append("--exact")
+
+        process = popen(command, options, stderr=DEVNULL)
+        if isinstance(process, int):
+            return process == 0
+        return process.wait() == 0
+
+
+def selftest(options: Options) -> int:
+    """Runs the corpus through both the Python and the native implementation,
+    which must agree with each other and with the expected result"""
+    if find_command("model-compare", options.search_prefixes) is None:
+        log("Cannot find model-compare, the native implementation cannot be tested")
+        return 1
+
+    failures = 0
+    for input_, reference, exact, expected in selftest_corpus:
+        python_result = compare_python(input_, reference, exact)
+        native_result = compare_native(input_, reference, exact, options)
+        if python_result != expected or native_result != expected:
+            failures += 1
+            log(
+                f"Comparing {input_} against {reference} (exact: {exact}):"
+                + f" expected {expected}, Python returned {python_result},"
+                + f" model-compare returned {native_result}"
+            )
 
-    return 0
+    return 0 if failures == 0 else 1
 
 
 def open_argument(path):
@@ -390,7 +431,16 @@ class ModelCompareCommand(Command):
         args = options.parsed_args
 
         if args.selftest:
-            return selftest()
+            return selftest(options)
+
+        # Only the graph dumping requires the Python implementation
+        if not args.dump_graphs:
+            command = ["model-compare", args.reference, args.input]
+            if args.exact:
+                command.append("--exact")
+            if args.__dict__["not"]:
+                command.append("--not")
+            return try_run(command, options)
 
         with open_argument(args.reference) as reference_file, open_argument(
             args.input
@@ -65,8 +65,7 @@ class PTMLCommand(Command):
         )
 
     def run(self, options: Options) -> Optional[int]:
-        args = options.parsed_args
-        return suppress_brokenpipe(cmd_text, args)
+        return suppress_brokenpipe(cmd_text, options.parsed_args, options.search_prefixes)
 
 
 def setup(commands_registry: CommandsRegistry):
@@ -5,11 +5,14 @@
 import re
 import sys
 from io import TextIOWrapper
-from typing import Dict
+from shutil import copyfileobj
+from subprocess import PIPE, Popen
+from typing import BinaryIO, Callable, Dict, Iterable, Optional
 from xml.dom import Node
 from xml.dom.minidom import Document, parseString
 
-from .common import handle_file, log, normalize_filter_extract
+from ...support import find_command, is_tar
+from .common import handle_file, is_ptml, log, normalize_filter_extract
 
 COLOR_CONVERSION = {
     "asm.label": "bright_red",
@@ -39,6 +42,62 @@ COLOR_CONVERSION = {
 }
 
 
+# ANSI escape sequences used to highlight YAML keys when rendering natively
+YAML_KEY_COLOR = "\x1b[38;5;226m"
+RESET_COLOR = "\x1b[0m"
+
+# Renders a PTML document, given the content, whether to colorize and the indent
+NativeRenderer = Callable[[str, bool, str], str]
+
+
+def load_native_renderer() -> Optional[NativeRenderer]:
+    """Returns the PTML renderer implemented in the C API, which is much faster
+    than parsing the document with minidom, if the C API is available"""
+    try:
+        from revng.internal.api._capi import _api, ffi
+        from revng.internal.api.errors import Error
+        from revng.internal.api.utils import convert_buffer, make_c_string
+    except (ImportError, AssertionError, OSError):
+        return None
+
+    def render(content: str, color: bool, indent: str) -> str:
+        data = content.encode("utf-8")
+        error = Error()
+        _indent = make_c_string(indent)
+        buffer = _api.rp_ptml_render(len(data), data, int(color), _indent, error._error)
+        if buffer == ffi.NULL:
+            raise error.to_exception()
+
+        size = _api.rp_buffer_size(buffer)
+        return convert_buffer(_api.rp_buffer_data(buffer), size, "text/plain")
+
+    return render
+
+
+def stream_native(executable: str, input_: BinaryIO, output: TextIOWrapper, color: bool) -> int:
+    """Renders a plain PTML document with `ptml-text`, which reads its input in
+    chunks, without ever holding the whole document in memory"""
+    command = [executable]
+    if color:
+        command.append("--color")
+
+    output.flush()
+    process = Popen(command, stdin=PIPE, stdout=output)
+    assert process.stdin is not None
+    with process.stdin:
+        copyfileobj(input_, process.stdin)
+    return process.wait()
+
+
+def is_plain_ptml(input_: BinaryIO) -> bool:
+    """Checks, without consuming it, whether the input is a plain PTML document"""
+    if not hasattr(input_, "peek"):
+        return False
+
+    prefix = input_.peek(512)
+    return not is_tar(prefix) and is_ptml(prefix.decode("utf-8", errors="ignore"))
+
+
 class PlainConsole:
     def __init__(self, file: TextIOWrapper):
         self.file = file
@@ -83,12 +142,38 @@ def _parse_ptml_node(node: Document, console, indent: str, metadata: Dict[str, s
             _parse_ptml_node(node, console, indent, new_metadata)
 
 
-def cmd_text(args):
+def render_ptml_plain(content: str, console: PlainConsole, render: NativeRenderer, color: bool):
+    console.print(render(content, color, ""), end="")
+
+
+def render_ptml_yaml(
+    content: Dict[str, str], console: PlainConsole, render: NativeRenderer, color: bool
+):
+    for key, value in content.items():
+        # See parse_ptml_yaml
+        if color:
+            console.print(f"{YAML_KEY_COLOR}{key}:{RESET_COLOR} |-")
+        else:
+            console.print(f"{key}: |-")
+        console.print(f"  {render(value, color, '  ')}")
+
+
+def cmd_text(args, search_prefixes: Iterable[str]):
     if args.inplace and args.input == sys.stdin.buffer:
         log("Cannot strip inplace while reading from stdin")
         return 1
 
     filters = normalize_filter_extract(args.filter, args.extract)
+
+    if not args.inplace and is_plain_ptml(args.input):
+        if len(filters) > 0:
+            log("Cannot extract/filter a plain ptml file")
+            return 1
+
+        executable = find_command("ptml-text", search_prefixes)
+        if executable is not None:
+            return stream_native(executable, args.input, args.output, args.color)
+
     content = args.input.read()
 
     if args.inplace:
@@ -98,6 +183,16 @@ def cmd_text(args):
     else:
         output = args.output
 
+    render = load_native_renderer()
+    if render is not None:
+        plain_console = PlainConsole(output)
+        return handle_file(
+            content,
+            lambda x: render_ptml_plain(x, plain_console, render, args.color),
+            lambda x: render_ptml_yaml(x, plain_console, render, args.color),
+            filters,
+        )
+
     if not args.color:
         console = PlainConsole(output)
     else:
@@ -122,16 +122,23 @@ def exec_run(command, options: Options, environment: OptionalEnv) -> Union[int,
     return os.execvpe(command[0], command, environment)
 
 
-def get_command(command: str, search_prefixes: Iterable[str]) -> str:
+def find_command(command: str, search_prefixes: Iterable[str]) -> Optional[str]:
     for additional_bin_path in additional_bin_paths:
         for executable in collect_files(search_prefixes, [additional_bin_path], command):
             return executable
 
     path = which(command)
     if not path:
+        return None
+    return os.path.abspath(path)
+
+
+def get_command(command: str, search_prefixes: Iterable[str]) -> str:
+    path = find_command(command, search_prefixes)
+    if path is None:
         log_error(f'Couldn\'t find "{command}".')
         assert False
-    return os.path.abspath(path)
+    return path
 
 
 def interleave(base: List[str], repeat: str):
@@ -31,7 +31,8 @@ from revng.internal.api._capi import initialize as capi_initialize
 from revng.internal.api._capi import shutdown as capi_shutdown
 
 from .event_manager import EventManager
-from .graphql import get_schema
+from .graphql import get_schema, run_in_executor
+from .prefetch import Prefetcher
 from .util import project_workdir
 
 config = Config()
@@ -132,6 +133,7 @@ def make_startlette() -> Starlette:
     hooks = load_plugins()
     event_manager = EventManager(manager, hooks.save_hooks)
     event_manager.start()
+    prefetcher = Prefetcher.from_environment(manager, run_in_executor)
     startup_done = False
 
     if DEBUG:
@@ -156,6 +158,7 @@ def make_startlette() -> Starlette:
             # is checked and when the analysis actually bumps the index.
             "index_lock": asyncio.Lock(),
             "headers": request.headers,
+            "prefetcher": prefetcher,
         }
 
     routes = [
@@ -177,9 +180,13 @@ def make_startlette() -> Starlette:
 
     def startup():
         nonlocal startup_done
+        if prefetcher is not None:
+            prefetcher.start()
         startup_done = True
 
     def shutdown():
+        if prefetcher is not None:
+            prefetcher.stop()
         event_manager.running = False
         store_result = event_manager.save()
         if not store_result:
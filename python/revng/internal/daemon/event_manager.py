@@ -55,9 +55,14 @@ class EventManager(Thread):
             time.sleep(10)
 
     def save(self):
-        result = self.manager.save()
+        # Only taking the snapshot blocks the manager, writing it to storage happens while the
+        # manager keeps serving requests
+        scheduled_save = self.next_save
+        result = self.manager.save_snapshot(self.manager.snapshot())
         if result:
-            self.next_save = None
+            # Do not drop a save scheduled by an event handled while saving
+            if self.next_save == scheduled_save:
+                self.next_save = None
             for hook in self.save_hooks:
                 hook(self.manager, self.credentials)
         return result
@@ -23,6 +23,7 @@ from revng.internal.api.target import Target
 
 from .event_manager import EventType, emit_event
 from .multiqueue import MultiQueue
+from .prefetch import Prefetcher
 from .util import produce_serializer
 
 
@@ -50,6 +51,20 @@ def run_in_executor(function: Callable[P, T], *args: P.args, **kwargs: P.kwargs)
     return loop.run_in_executor(executor, partial(function, *args, **kwargs))
 
 
+def get_prefetcher(info) -> Optional[Prefetcher]:
+    prefetcher = info.context.get("prefetcher")
+    if prefetcher is not None:
+        prefetcher.touch()
+    return prefetcher
+
+
+async def notify_invalidation(info, index: int, invalidations: str):
+    prefetcher = get_prefetcher(info)
+    if prefetcher is not None:
+        prefetcher.invalidate(index)
+    await invalidation_queue.send(Invalidation(index, invalidations))
+
+
 @dataclass
 class Diff:
     diff: str
@@ -95,6 +110,7 @@ async def resolve_produce(
 ):
     manager: Manager = info.context["manager"]
     index_lock: asyncio.Lock = info.context["index_lock"]
+    get_prefetcher(info)
     async with index_lock:
         current_index = await run_in_executor(manager.get_context_commit_index)
         if current_index != index:
@@ -122,6 +138,7 @@ async def resolve_produce_artifacts(
 ):
     manager: Manager = info.context["manager"]
     index_lock: asyncio.Lock = info.context["index_lock"]
+    prefetcher = get_prefetcher(info)
     async with index_lock:
         current_index = await run_in_executor(manager.get_context_commit_index)
         if current_index != index:
@@ -134,6 +151,8 @@ async def resolve_produce_artifacts(
         if isinstance(result, Error):
             return result.unwrap()
         else:
+            if prefetcher is not None:
+                prefetcher.record(step, targets, current_index)
             return Produced(produce_serializer(result))
 
 
@@ -169,6 +188,12 @@ async def resolve_context_commit_index(_, info) -> int:
     return await run_in_executor(manager.get_context_commit_index)
 
 
+@query.field("prefetchStatistics")
+async def resolve_prefetch_statistics(_, info) -> str:
+    prefetcher: Optional[Prefetcher] = info.context.get("prefetcher")
+    return json.dumps(prefetcher.statistics() if prefetcher is not None else {})
+
+
 @mutation.field("uploadB64")
 @emit_event(EventType.BEGIN)
 async def resolve_upload_b64(_, info, *, input: str, container: str):  # noqa: A002
@@ -177,7 +202,7 @@ async def resolve_upload_b64(_, info, *, input: str, container: str):  # noqa: A
     async with index_lock:
         invalidations = await run_in_executor(manager.set_input, container, b64decode(input))
         index = await run_in_executor(manager.get_context_commit_index)
-        await invalidation_queue.send(Invalidation(index, str(invalidations)))
+        await notify_invalidation(info, index, str(invalidations))
         logging.info(f"Saved file for container {container}")
         return True
 
@@ -191,7 +216,7 @@ async def resolve_upload_file(_, info, *, file: UploadFile, container: str):
         contents = await file.read()
         invalidations = await run_in_executor(manager.set_input, container, contents)
         index = await run_in_executor(manager.get_context_commit_index)
-        await invalidation_queue.send(Invalidation(index, str(invalidations)))
+        await notify_invalidation(info, index, str(invalidations))
         logging.info(f"Saved file for container {container}")
         return True
 
@@ -224,7 +249,7 @@ async def resolve_run_analysis(
         if result:
             real_result = result.unwrap()
             new_index = await run_in_executor(manager.get_context_commit_index)
-            await invalidation_queue.send(Invalidation(new_index, str(real_result.invalidations)))
+            await notify_invalidation(info, new_index, str(real_result.invalidations))
             return Diff(json.dumps(real_result.result))
         else:
             return result.error.unwrap()
@@ -246,7 +271,7 @@ async def resolve_run_analyses_list(_, info, *, name: str, options: str | None =
         if result:
             real_result = result.unwrap()
             new_index = await run_in_executor(manager.get_context_commit_index)
-            await invalidation_queue.send(Invalidation(new_index, str(real_result.invalidations)))
+            await notify_invalidation(info, new_index, str(real_result.invalidations))
             return Diff(json.dumps(real_result.result))
         else:
             return result.error.unwrap()
@@ -0,0 +1,225 @@
+#
+# This file is distributed under the MIT License. See LICENSE.md for details.
+#
+
+import asyncio
+import logging
+import os
+import time
+from collections import deque
+from typing import Awaitable, Callable, Deque, Dict, List, Set, Tuple
+
+from revng.internal.api.errors import Error
+from revng.internal.api.manager import Manager
+
+# (step, path) of an artifact
+Artifact = Tuple[str, str]
+
+logger = logging.getLogger(__name__)
+
+
+class Prefetcher:
+    """Speculatively produces the artifacts the user is likely to request next.
+
+    Every time artifacts are produced on request, the artifacts with adjacent
+    paths in the same step and the artifacts with the same path in the recently
+    used steps become candidates. Once the daemon has been idle for
+    `idle_delay` seconds, candidates are produced one at a time through the
+    same executor used by the GraphQL handlers, hence a foreground request
+    waits at most for the production of a single speculative artifact.
+
+    Candidates are tied to the commit index they have been predicted at, as
+    soon as the index changes they are dropped."""
+
+    def __init__(
+        self,
+        manager: Manager,
+        run_in_executor: Callable[..., Awaitable],
+        idle_delay: float = 1.0,
+        neighbors: int = 2,
+        recent_steps: int = 3,
+    ):
+        self.manager = manager
+        self.run_in_executor = run_in_executor
+        self.idle_delay = idle_delay
+        self.neighbors = neighbors
+
+        # Artifacts requested in the foreground whose neighbors are yet to be
+        # computed
+        self.to_expand: Deque[Artifact] = deque()
+        # Artifacts to produce, most likely first
+        self.to_produce: Deque[Artifact] = deque()
+        self.queued: Set[Artifact] = set()
+        self.prefetched: Set[Artifact] = set()
+        self.recent: Deque[str] = deque(maxlen=recent_steps)
+        self.paths_cache: Dict[str, List[str]] = {}
+        self.commit_index: int | None = None
+        self.last_activity = time.monotonic()
+        self.wakeup = asyncio.Event()
+        self.task: asyncio.Task | None = None
+
+        self.hits = 0
+        self.misses = 0
+        self.produced = 0
+        self.failed = 0
+
+    @staticmethod
+    def from_environment(manager: Manager, run_in_executor) -> "Prefetcher | None":
+        if os.environ.get("REVNG_DAEMON_PREFETCH", "0") in ("0", ""):
+            return None
+        idle_delay = float(os.environ.get("REVNG_DAEMON_PREFETCH_IDLE", "1.0"))
+        return Prefetcher(manager, run_in_executor, idle_delay)
+
+    def start(self):
+        self.task = asyncio.get_event_loop().create_task(self.run())
+
+    def stop(self):
+        if self.task is not None:
+            self.task.cancel()
+            self.task = None
+
+    def touch(self):
+        """Postpone speculative work, to be called whenever a request starts"""
+        self.last_activity = time.monotonic()
+
+    def invalidate(self, commit_index: int):
+        if commit_index == self.commit_index:
+            return
+        self.commit_index = commit_index
+        self.to_expand.clear()
+        self.to_produce.clear()
+        self.queued.clear()
+        self.prefetched.clear()
+        self.paths_cache.clear()
+
+    def record(self, step: str, paths: List[str] | None, commit_index: int):
+        """Account for a foreground production of artifacts and predict the
+        next ones"""
+        self.touch()
+        self.invalidate(commit_index)
+        if paths is None:
+            return
+
+        for path in paths:
+            if (step, path) in self.prefetched:
+                self.hits += 1
+            else:
+                self.misses += 1
+
+        if step in self.recent:
+            self.recent.remove(step)
+        self.recent.append(step)
+
+        # The latest request is the most relevant, drop stale predictions
+        self.to_expand.clear()
+        self.to_produce.clear()
+        self.queued.clear()
+        self.to_expand.extend((step, path) for path in paths)
+        self.wakeup.set()
+
+    def statistics(self) -> Dict[str, int]:
+        return {
+            "hits": self.hits,
+            "misses": self.misses,
+            "produced": self.produced,
+            "failed": self.failed,
+            "queued": len(self.to_produce),
+        }
+
+    async def run(self):
+        while True:
+            await self.wakeup.wait()
+
+            # Wait until no request has been received for a while
+            while (delay := self.last_activity + self.idle_delay - time.monotonic()) > 0:
+                await asyncio.sleep(delay)
+
+            # Prefetching is best-effort: a failure must not stop it for the
+            # rest of the daemon's life
+            try:
+                await self._step()
+            except Exception as exception:
+                logger.warning(f"Prefetching failed: {exception}")
+                self.failed += 1
+
+    async def _step(self):
+        if self.to_expand:
+            step, path = self.to_expand.popleft()
+            await self._expand(step, path)
+        elif self.to_produce:
+            artifact = self.to_produce.popleft()
+            self.queued.discard(artifact)
+            await self._produce(*artifact)
+        else:
+            self.wakeup.clear()
+
+    async def _paths(self, step: str) -> List[str]:
+        if step not in self.paths_cache:
+            try:
+                paths = await self.run_in_executor(self._list_paths, step)
+            except Exception as exception:
+                # Do not try again until the next invalidation
+                logger.warning(f"Cannot list the artifacts of {step}: {exception}")
+                self.failed += 1
+                paths = []
+            self.paths_cache[step] = paths
+        return self.paths_cache[step]
+
+    async def _expand(self, step: str, path: str):
+        candidates: List[Artifact] = []
+
+        # The same object in the other views the user has been looking at
+        for other_step in reversed(self.recent):
+            if other_step != step and path in await self._paths(other_step):
+                candidates.append((other_step, path))
+
+        # The objects preceding and following it
+        paths = await self._paths(step)
+        if path in paths:
+            index = paths.index(path)
+            for distance in range(1, self.neighbors + 1):
+                for neighbor in (index + distance, index - distance):
+                    if 0 <= neighbor < len(paths):
+                        candidates.append((step, paths[neighbor]))
+
+        for candidate in candidates:
+            if candidate not in self.queued and candidate not in self.prefetched:
+                self.to_produce.append(candidate)
+                self.queued.add(candidate)
+
+    async def _produce(self, step: str, path: str):
+        try:
+            result = await self.run_in_executor(self._produce_if_unchanged, step, path)
+        except Exception as exception:
+            logger.debug(f"Prefetching {step}/{path} failed: {exception}")
+            self.failed += 1
+            return
+
+        if result is None:
+            return
+        elif isinstance(result, Error):
+            self.failed += 1
+        else:
+            self.produced += 1
+            self.prefetched.add((step, path))
+
+    def _list_paths(self, step: str) -> List[str]:
+        step_obj = self.manager.step_from_name(step)
+        if step_obj is None or step_obj.Artifacts.Container == "":
+            return []
+        targets = self.manager.get_targets(step, step_obj.Artifacts.Container)
+        return [target.joined_path() for target in targets]
+
+    def _produce_if_unchanged(self, step: str, path: str):
+        # This runs in the executor, hence no mutation can happen between the
+        # check and the production
+        if self.manager.get_context_commit_index() != self.commit_index:
+            return None
+
+        step_obj = self.manager.step_from_name(step)
+        assert step_obj is not None
+        target = self.manager.create_target(step, step_obj.Artifacts.Container, path, True)
+        if target.is_ready:
+            return None
+
+        return self.manager.produce_target(step, path)
@@ -3,11 +3,13 @@
 #
 
 import sys
+import weakref
 from collections.abc import MutableSequence
 from dataclasses import dataclass, fields
 from enum import Enum, EnumType
 from functools import lru_cache
-from typing import Any, Callable, Dict, Generic, List, Type, TypeVar, get_args, get_origin
+from typing import Any, Callable, ClassVar, Dict, Generic, List, Optional, Tuple, Type, TypeVar
+from typing import get_args, get_origin
 from typing import get_type_hints
 
 import yaml
@@ -22,6 +24,11 @@ except ImportError:
 
 no_default = object()
 
+
+def make_key(*values) -> str:
+    """Builds the string representation of a key, as used in references"""
+    return "-".join(value.name if isinstance(value, Enum) else str(value) for value in values)
+
 dataclass_kwargs = {}
 if sys.version_info >= (3, 10, 0):
     # Performance optimization available since python 3.10
@@ -52,6 +59,9 @@ def get_type_hint_cached(class_, name):
 
 @dataclass
 class StructBase:
+    # Names of the fields composing the key, overridden by the generated classes of keyed objects
+    _key_fields: ClassVar[Tuple[str, ...]] = ()
+
     @classmethod
     def from_dict(cls, **kwargs):
         """Constructs an instance of the object using the values supplied as kwargs"""
@@ -155,8 +165,23 @@ class StructBase:
         # Prevent setting undefined attributes
         if self.__dataclass_fields__.get(key) is None:
             raise AttributeError(f"Cannot set attribute {key} for class {type(self).__name__}")
+        if key in self._key_fields and self._is_set(key):
+            self._invalidate_owner_index()
         super().__setattr__(key, value)
 
+    def _invalidate_owner_index(self):
+        # The key is about to change, the index of the TypedList holding this object is now stale
+        owner = self.__dict__.get("_owner")
+        typed_list = owner() if owner is not None else None
+        if typed_list is not None:
+            typed_list._index = None
+
+    def _is_set(self, name):
+        if dataclass_kwargs.get("slots", False):
+            return hasattr(self, name)
+        # Without slots fields with a default value are also class attributes
+        return name in self.__dict__
+
 
 class AbstractStructBase(StructBase):
     _children: Dict[str, Type] = {}
@@ -231,6 +256,27 @@ class Reference(Generic[_PointedType, _RootType]):
     def is_valid(self):
         return self._ref_str != ""
 
+    def resolve(self, root):
+        """Returns the object pointed by this reference within root, None if there's no such
+        object. The lookup is performed every time, hence the result always reflects the current
+        content of root."""
+        if self.referenced_obj is not None:
+            return self.referenced_obj
+        if not self.is_valid():
+            return None
+
+        # The path alternates field names and keys, e.g. /TypeDefinitions/1-StructDefinition
+        components = self._ref_str.split("/")[1:]
+        obj = root
+        for index, component in enumerate(components):
+            if index % 2 == 0:
+                obj = getattr(obj, component, None)
+            else:
+                obj = obj.get(component)
+            if obj is None:
+                return None
+        return obj
+
 
 def init_reference_yaml_classes(_: Type[yaml.Loader], dumper: Type[yaml.Dumper]):
     dumper.add_representer(Reference, Reference.yaml_representer)
@@ -274,33 +320,89 @@ class YamlDumper(Dumper):
 
 
 class TypedList(MutableSequence):
+    """A list whose elements must be instances of a given class. If the class is keyed, elements
+    can also be looked up by key (e.g. `binary.TypeDefinitions["1-StructDefinition"]`), in
+    constant time."""
+
     def __init__(self, base_class: type):
         self._data: List[Any] = []
         self._base_class = base_class
+        # Elements by key, built upon the first lookup and then kept up to date. Elements hold a weak
+        # reference to the list (see _adopt), so that changing their key only drops this index.
+        self._index: Optional[Dict[str, Any]] = None
 
-    def __setitem__(self, idx, obj):
+    def _check_type(self, obj):
         if not isinstance(obj, self._base_class):
             raise ValueError(
                 f"Cannot insert object, must be of type {self._base_class.__name__} (or subclass)"
             )
+
+    def _is_keyed(self) -> bool:
+        return hasattr(self._base_class, "key")
+
+    def _adopt(self, obj):
+        if self._is_keyed():
+            # Bypass StructBase.__setattr__, the owner is not a field
+            object.__setattr__(obj, "_owner", weakref.ref(self))
+
+    def _index_add(self, obj):
+        self._adopt(obj)
+        if self._index is not None:
+            self._index[obj.key()] = obj
+
+    def _index_remove(self, obj):
+        if self._index is not None:
+            key = obj.key()
+            if self._index.get(key) is obj:
+                del self._index[key]
+
+    def __setitem__(self, idx, obj):
+        self._check_type(obj)
+        self._index_remove(self._data[idx])
         self._data[idx] = obj
+        self._index_add(obj)
 
     def insert(self, index: int, obj):
-        if not isinstance(obj, self._base_class):
-            raise ValueError(
-                f"Cannot insert object, must be of type {self._base_class.__name__} (or subclass)"
-            )
+        self._check_type(obj)
         self._data.insert(index, obj)
+        self._index_add(obj)
+
+    def get(self, key: str, default=None):
+        """Returns the element with the given key, default if there's none"""
+        if not self._is_keyed():
+            raise TypeError(f"{self._base_class.__name__} has no key")
+
+        if self._index is None:
+            self._index = {obj.key(): obj for obj in self._data}
+
+        return self._index.get(key, default)
+
+    def __getstate__(self):
+        # Copies get their own index, built from the copied elements
+        return {**self.__dict__, "_index": None}
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        for obj in self._data:
+            self._adopt(obj)
 
     @classmethod
     def yaml_representer(cls, dumper: YamlDumper, instance) -> yaml.Node:
         return dumper.represent_list(instance._data)
 
     def __getitem__(self, idx):
+        if isinstance(idx, str):
+            result = self.get(idx, no_default)
+            if result is no_default:
+                raise KeyError(idx)
+            return result
         return self._data[idx]
 
     def __delitem__(self, idx):
+        removed = self._data[idx]
         del self._data[idx]
+        for obj in removed if isinstance(idx, slice) else (removed,):
+            self._index_remove(obj)
 
     def __len__(self) -> int:
         return len(self._data)
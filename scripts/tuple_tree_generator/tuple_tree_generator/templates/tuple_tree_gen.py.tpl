@@ -14,6 +14,7 @@ from revng.tupletree import (
     StructBase,
     AbstractStructBase,
     dataclass_kwargs,
+    make_key,
     no_default,
     typedlist_factory,
     force_constructor_kwarg,
@@ -102,6 +103,19 @@ class 'struct.name'(
         ## endif ##
     )
     ##- endfor ##
+    ##- if struct.key_fields ##
+
+    _key_fields = (
+        ##- for key_field in struct.key_fields -##
+        "'key_field.name'" ##- if not loop.last or loop.length == 1 ## , ##- endif -##
+        ##- endfor -## )
+
+    def key(self) -> str:
+        return make_key(
+            ##- for key_field in struct.key_fields -##
+            self.'key_field.name' ##- if not loop.last ## , ##- endif -##
+            ##- endfor -## )
+    ##- endif ##
 
     def __hash__(self):
         return id(self)
@@ -0,0 +1,138 @@
+#
+# This file is distributed under the MIT License. See LICENSE.md for details.
+#
+
+import asyncio
+from types import SimpleNamespace
+from typing import Dict, List
+
+from revng.internal.daemon.prefetch import Prefetcher
+
+
+class StubManager:
+    """Mimics the subset of Manager used by Prefetcher, records productions"""
+
+    def __init__(self, paths: Dict[str, List[str]]):
+        self.paths = paths
+        self.commit_index = 0
+        self.produced: List[tuple] = []
+        self.ready: set = set()
+
+    def step_from_name(self, step: str):
+        if step == "broken":
+            raise RuntimeError("cannot list broken")
+        if step not in self.paths:
+            return None
+        return SimpleNamespace(Artifacts=SimpleNamespace(Container="artifacts"))
+
+    def get_targets(self, step: str, container: str):
+        return [SimpleNamespace(joined_path=lambda p=path: p) for path in self.paths[step]]
+
+    def get_context_commit_index(self) -> int:
+        return self.commit_index
+
+    def create_target(self, step: str, container: str, path: str, exact: bool):
+        return SimpleNamespace(is_ready=(step, path) in self.ready)
+
+    def produce_target(self, step: str, path: str):
+        self.produced.append((step, path))
+        self.ready.add((step, path))
+        return "produced"
+
+
+async def run_in_executor(function, *args):
+    return function(*args)
+
+
+async def drain(prefetcher: Prefetcher):
+    """Wait until the prefetcher has nothing left to do"""
+    for _ in range(1000):
+        if not prefetcher.wakeup.is_set():
+            return
+        await asyncio.sleep(0)
+    raise AssertionError("The prefetcher did not go idle")
+
+
+def foreground(manager: StubManager, prefetcher: Prefetcher, step: str, path: str):
+    """Simulate the production of an artifact requested by the user"""
+    manager.ready.add((step, path))
+    prefetcher.record(step, [path], manager.commit_index)
+
+
+def make(paths: Dict[str, List[str]]):
+    manager = StubManager(paths)
+    prefetcher = Prefetcher(manager, run_in_executor, idle_delay=0, neighbors=1)  # type: ignore
+    return manager, prefetcher
+
+
+def test_record_expand_produce():
+    async def body():
+        manager, prefetcher = make({"disassemble": ["/a", "/b", "/c"], "decompile": ["/b"]})
+        prefetcher.start()
+
+        foreground(manager, prefetcher, "decompile", "/b")
+        await drain(prefetcher)
+        foreground(manager, prefetcher, "disassemble", "/b")
+        await drain(prefetcher)
+
+        # Neighbors of /b in disassemble, nothing new for decompile
+        assert sorted(manager.produced) == [("disassemble", "/a"), ("disassemble", "/c")]
+        assert prefetcher.statistics()["misses"] == 2
+
+        foreground(manager, prefetcher, "disassemble", "/c")
+        await drain(prefetcher)
+        statistics = prefetcher.statistics()
+        assert statistics["hits"] == 1
+        assert statistics["produced"] == 2
+        assert statistics["failed"] == 0
+
+        prefetcher.stop()
+
+    asyncio.run(body())
+
+
+def test_invalidate():
+    async def body():
+        manager, prefetcher = make({"disassemble": ["/a", "/b", "/c"]})
+        prefetcher.start()
+
+        foreground(manager, prefetcher, "disassemble", "/b")
+        await drain(prefetcher)
+        assert len(manager.produced) == 2
+
+        # A new commit drops what has been prefetched so far
+        manager.commit_index = 1
+        manager.ready.clear()
+        foreground(manager, prefetcher, "disassemble", "/a")
+        assert prefetcher.statistics()["hits"] == 0
+        assert prefetcher.statistics()["misses"] == 2
+
+        # Predictions made at a stale commit index are not produced
+        manager.produced.clear()
+        foreground(manager, prefetcher, "disassemble", "/c")
+        manager.commit_index = 2
+        await drain(prefetcher)
+        assert manager.produced == []
+
+        prefetcher.stop()
+
+    asyncio.run(body())
+
+
+def test_failures_do_not_stop_prefetching():
+    async def body():
+        manager, prefetcher = make({"disassemble": ["/a", "/b"]})
+        prefetcher.start()
+
+        # Listing the artifacts of a recently used step fails
+        foreground(manager, prefetcher, "broken", "/b")
+        await drain(prefetcher)
+        foreground(manager, prefetcher, "disassemble", "/b")
+        await drain(prefetcher)
+
+        assert prefetcher.statistics()["failed"] == 1
+        assert manager.produced == [("disassemble", "/a")]
+
+        prefetcher.stop()
+
+    asyncio.run(body())
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+#
+# This file is distributed under the MIT License. See LICENSE.md for details.
+#
+
+import argparse
+import sys
+import time
+
+import yaml
+
+from revng.model import Binary, YamlLoader  # type: ignore[attr-defined]
+
+
+def generate_model(count: int) -> str:
+    """Generates a model with `count` prototypes and a function using each of them"""
+    lines = ["---", "Architecture: x86_64", "DefaultABI: SystemV_x86_64", "TypeDefinitions:"]
+    for index in range(count):
+        lines.append(f"  - ID: {index + 1}")
+        lines.append("    Kind: CABIFunctionDefinition")
+        lines.append("    ABI: SystemV_x86_64")
+    lines.append("Functions:")
+    for index in range(count):
+        lines.append(f"  - Entry: '0x{0x1000 + index * 0x10:x}:Code_x86_64'")
+        lines.append("    Prototype:")
+        lines.append("      Kind: DefinedType")
+        lines.append(f"      Definition: '/TypeDefinitions/{index + 1}-CABIFunctionDefinition'")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measures the time required to load a model and resolve the references to the "
+        + "prototypes of all its functions."
+    )
+    parser.add_argument("count", type=int, nargs="?", default=100000, help="Number of types")
+    args = parser.parse_args()
+
+    serialized = generate_model(args.count)
+
+    start = time.perf_counter()
+    binary = yaml.load(serialized, Loader=YamlLoader)
+    loaded = time.perf_counter()
+    assert isinstance(binary, Binary)
+
+    resolved = 0
+    for function in binary.Functions:
+        prototype = function.Prototype.Definition.resolve(binary)
+        assert prototype is not None
+        assert prototype.ID == binary.TypeDefinitions[prototype.key()].ID
+        resolved += 1
+    end = time.perf_counter()
+
+    assert resolved == args.count
+    sys.stdout.write(f"Types: {args.count}\n")
+    sys.stdout.write(f"Load: {loaded - start:.3f}s\n")
+    sys.stdout.write(f"Resolution: {end - loaded:.3f}s\n")
+
+
+if __name__ == "__main__":
+    main()
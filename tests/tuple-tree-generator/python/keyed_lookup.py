@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+#
+# This file is distributed under the MIT License. See LICENSE.md for details.
+#
+
+import yaml
+from testmodule.keyed import Item, ItemKind, RootType, YamlLoader
+
+
+def test_keyed_lookup():
+    """Tests that elements of keyed sequences can be looked up by key, and that the lookup reflects
+    changes to the sequence and to the keys of its elements"""
+    with open("keyed.yml", encoding="utf-8") as f:
+        root = yaml.load(f, Loader=YamlLoader)
+    assert isinstance(root, RootType)
+
+    assert root.Items["1-Small"] is root.Items[0]
+    assert root.Items.get("1-Large") is None
+    assert root.Users["bob"].Name == "bob"
+
+    # Mutations of the sequence
+    new_item = Item(ID=3, Kind=ItemKind.Small)
+    root.Items.append(new_item)
+    assert root.Items["3-Small"] is new_item
+    del root.Items[0]
+    assert root.Items.get("1-Small") is None
+    root.Items[0] = Item(ID=4, Kind=ItemKind.Large)
+    assert root.Items.get("2-Large") is None
+    assert root.Items["4-Large"] is root.Items[0]
+
+    # Mutations of the key of an element
+    new_item.ID = 5
+    assert root.Items.get("3-Small") is None
+    assert root.Items["5-Small"] is new_item
+
+    # Only the index of the sequence holding the element is dropped
+    assert root.Users._index is not None
+
+    try:
+        root.Items["6-Small"]
+    except KeyError:
+        pass
+    else:
+        raise Exception("Lookup of a missing key did not fail")
+
+    print("test_keyed_lookup: OK")
+
+
+def test_reference_resolution():
+    """Tests that references are resolved against the current content of the root"""
+    with open("keyed.yml", encoding="utf-8") as f:
+        root = yaml.load(f, Loader=YamlLoader)
+
+    alice = root.Users["alice"]
+    bob = root.Users["bob"]
+    assert alice.Favorite.resolve(root) is root.Items["2-Large"]
+    assert bob.Favorite.resolve(root) is None
+
+    root.Items.append(Item(ID=3, Kind=ItemKind.Small))
+    assert bob.Favorite.resolve(root) is root.Items["3-Small"]
+
+    print("test_reference_resolution: OK")
+
+
+test_keyed_lookup()
+test_reference_resolution()
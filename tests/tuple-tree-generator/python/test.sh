@@ -22,6 +22,7 @@ rm -rf testmodule
 mkdir testmodule
 mkdir testmodule/v1
 mkdir testmodule/v2
+mkdir testmodule/keyed
 
 # Copy required files from the model module in the test module directory
 cp -ar "$SOURCE_ROOT/python/revng/model/metaaddress.py" testmodule
@@ -39,6 +40,16 @@ for INDEX in 1 2; do
   cp "$SOURCE_ROOT/python/revng/model/v1/external.py" "testmodule/v${INDEX}/external.py"
 done
 
+# Generate python model with keyed sequences and references
+"$SOURCE_ROOT/scripts/tuple_tree_generator/tuple-tree-generate-python.py" \
+  --namespace dummy \
+  --root-type RootType \
+  --output "testmodule/keyed/__init__.py" \
+  --string-type "string" \
+  "$SCRIPT_DIR/keyed_schema.yml"
+cp "$SOURCE_ROOT/python/revng/model/v1/external.py" "testmodule/keyed/external.py"
+
 export PYTHONPATH="$PWD:$SOURCE_ROOT/python:${PYTHONPATH:+:${PYTHONPATH}}"
 cd "$SCRIPT_DIR"
 "$SCRIPT_DIR/deserialize_multiple_versions.py"
+"$SCRIPT_DIR/keyed_lookup.py"
@@ -68,3 +68,45 @@ BOOST_AUTO_TEST_CASE(GzipTarFileTest) {
   checkOffset(Buffer, Offset1.DataStart, Offset1.dataSize(), "foo2");
   checkOffset(Buffer, Offset2.DataStart, Offset2.dataSize(), "bar2");
 }
+
+BOOST_AUTO_TEST_CASE(GzipTarFileAppendCompressedTest) {
+  using revng::ArchiveEntry;
+  using revng::OffsetDescriptor;
+
+  const char Data[5] = "foo2";
+
+  // Write an archive the ordinary way
+  llvm::SmallVector<char> Buffer;
+  llvm::raw_svector_ostream OS(Buffer);
+  revng::GzipTarWriter Writer(OS);
+  OffsetDescriptor Offset = Writer.append("foo", { Data, 4 });
+  Writer.close();
+
+  // Write an archive reusing the compressed data of the first one
+  llvm::SmallVector<char> CompressedBuffer;
+  llvm::raw_svector_ostream CompressedOS(CompressedBuffer);
+  revng::GzipTarWriter CompressedWriter(CompressedOS);
+  llvm::ArrayRef<char> CompressedData(Buffer.data() + Offset.DataStart,
+                                      Offset.dataSize());
+  OffsetDescriptor CompressedOffset = CompressedWriter
+                                        .appendCompressed("foo",
+                                                          4,
+                                                          CompressedData);
+  CompressedWriter.close();
+
+  BOOST_TEST(CompressedOffset.Start == Offset.Start);
+  BOOST_TEST(CompressedOffset.DataStart == Offset.DataStart);
+  BOOST_TEST(CompressedOffset.PaddingStart == Offset.PaddingStart);
+  BOOST_TEST(CompressedOffset.End == Offset.End);
+  BOOST_TEST((CompressedBuffer == Buffer));
+
+  revng::GzipTarReader Reader({ CompressedBuffer.data(),
+                                CompressedBuffer.size() });
+  cppcoro::generator<ArchiveEntry> Gen = Reader.entries();
+  std::vector<ArchiveEntry> Entries(Gen.begin(), Gen.end());
+  BOOST_TEST(Entries.size() == 1ULL);
+
+  llvm::StringRef RefData(Entries[0].Data.data(), Entries[0].Data.size());
+  BOOST_TEST(Entries[0].Filename == "foo");
+  BOOST_TEST(RefData.str() == "foo2");
+}
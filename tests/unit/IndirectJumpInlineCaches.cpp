@@ -0,0 +1,187 @@
+/// \file IndirectJumpInlineCaches.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE IndirectJumpInlineCaches
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/Model/LoadModelPass.h"
+#include "revng/Recompile/IndirectJumpInlineCaches.h"
+#include "revng/Support/IRHelpers.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+static const char *OptionName = "indirect-jump-inline-cache-size";
+
+static const char *RootModule = R"LLVM(
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@pc = internal global i64 0
+@pc_epoch = internal global i32 0
+@pc_address_space = internal global i16 0
+@pc_type = internal global i16 0
+
+@jt0 = internal constant [21 x i8] c"0x401000:Code_x86_64\00"
+@jt1 = internal constant [21 x i8] c"0x402000:Code_x86_64\00"
+
+declare void @newpc(i8*, i64, i32, i8*, ...)
+
+define void @root() {
+entrypoint:
+  br label %jt0
+
+jt0:
+  call void (i8*, i64, i32, i8*, ...) @newpc(i8* @jt0, i64 1, i32 1, i8* null)
+  br label %anypc
+
+jt1:
+  call void (i8*, i64, i32, i8*, ...) @newpc(i8* @jt1, i64 1, i32 1, i8* null)
+  br label %anypc
+
+anypc:
+  unreachable, !revng.block.type !0
+}
+
+!0 = !{!"AnyPCBlock"}
+)LLVM";
+
+static bool setCacheSize(StringRef Value) {
+  cl::ResetAllOptionOccurrences();
+  cl::Option *Size = cl::getRegisteredOptions().lookup(OptionName);
+  revng_check(Size != nullptr);
+  return not Size->addOccurrence(0, OptionName, Value);
+}
+
+static std::unique_ptr<Module> run(LLVMContext &Context) {
+  SMDiagnostic Diagnostic;
+  auto Buffer = MemoryBuffer::getMemBuffer(RootModule);
+  std::unique_ptr<Module> M = parseIR(Buffer->getMemBufferRef(),
+                                      Diagnostic,
+                                      Context);
+  if (M == nullptr) {
+    Diagnostic.print("revng", dbgs());
+    revng_abort();
+  }
+
+  TupleTree<model::Binary> Model;
+  Model->Architecture() = model::Architecture::x86_64;
+
+  legacy::PassManager PM;
+  PM.add(new LoadModelWrapperPass(ModelWrapper(Model)));
+  PM.add(new IndirectJumpInlineCachesPass());
+  PM.run(*M);
+
+  return M;
+}
+
+static BasicBlock *blockByName(Function *F, StringRef Name) {
+  for (BasicBlock &BB : *F)
+    if (BB.getName() == Name)
+      return &BB;
+  return nullptr;
+}
+
+static SmallVector<BasicBlock *, 2> jumpBlocks(Function *F) {
+  SmallVector<BasicBlock *, 2> Result;
+  for (BasicBlock &BB : *F)
+    if (BB.getName().startswith("ic.jump"))
+      Result.push_back(&BB);
+  return Result;
+}
+
+static AllocaInst *allocaByName(Function *F, StringRef Name) {
+  for (Instruction &I : F->getEntryBlock())
+    if (auto *Alloca = dyn_cast<AllocaInst>(&I))
+      if (Alloca->getName() == Name)
+        return Alloca;
+  return nullptr;
+}
+
+BOOST_AUTO_TEST_CASE(RejectTooLargeCaches) {
+  BOOST_TEST(setCacheSize("4"));
+  BOOST_TEST(not setCacheSize("5"));
+  BOOST_TEST(setCacheSize("0"));
+}
+
+BOOST_AUTO_TEST_CASE(DisabledWithZeroSize) {
+  BOOST_TEST(setCacheSize("0"));
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = run(Context);
+  Function *Root = M->getFunction("root");
+  BasicBlock *AnyPC = blockByName(Root, "anypc");
+
+  BOOST_TEST(jumpBlocks(Root).empty());
+  BOOST_TEST(allocaByName(Root, "ic.target") == nullptr);
+  for (const char *Name : { "jt0", "jt1" }) {
+    auto *Branch = cast<BranchInst>(blockByName(Root, Name)->getTerminator());
+    BOOST_TEST(Branch->isUnconditional());
+    BOOST_TEST(Branch->getSuccessor(0) == AnyPC);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EmitCaches) {
+  BOOST_TEST(setCacheSize("2"));
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = run(Context);
+  BOOST_TEST(not verifyModule(*M, &dbgs()));
+
+  Function *Root = M->getFunction("root");
+  BasicBlock *AnyPC = blockByName(Root, "anypc");
+
+  // Each site now probes its cache instead of jumping to anypc
+  for (const char *Name : { "jt0", "jt1" }) {
+    auto *Branch = cast<BranchInst>(blockByName(Root, Name)->getTerminator());
+    BOOST_TEST(Branch->isConditional());
+  }
+
+  // Two entries for each of the two sites
+  for (const char *Name : { "revng.ic.0.pc.0",
+                            "revng.ic.0.pc.1",
+                            "revng.ic.1.pc.0",
+                            "revng.ic.1.pc.1" })
+    BOOST_TEST(M->getGlobalVariable(Name, true) != nullptr);
+  BOOST_TEST(M->getGlobalVariable("revng.ic.0.pc.2", true) == nullptr);
+  BOOST_TEST(M->getGlobalVariable("revng.ic.2.pc.0", true) == nullptr);
+
+  // The lookup state is local to root, not shared through globals
+  BOOST_TEST(M->getGlobalVariable("revng.ic.target", true) == nullptr);
+  BOOST_TEST(M->getGlobalVariable("revng.ic.return", true) == nullptr);
+  BOOST_TEST(allocaByName(Root, "ic.target") != nullptr);
+  BOOST_TEST(allocaByName(Root, "ic.return") != nullptr);
+
+  // Each site has its own jump block, which can reach anypc and both jump
+  // targets, and is reached by the two hits and the fill of that site only
+  SmallVector<BasicBlock *, 2> Jumps = jumpBlocks(Root);
+  BOOST_TEST(Jumps.size() == 2U);
+  for (BasicBlock *Jump : Jumps) {
+    auto *IndirectBranch = cast<IndirectBrInst>(Jump->getTerminator());
+    BOOST_TEST(IndirectBranch->getNumDestinations() == 3U);
+    BOOST_TEST(IndirectBranch->getDestination(0) == AnyPC);
+    BOOST_TEST(pred_size(Jump) == 3U);
+  }
+
+  // On a miss, the lookup returns to one of the two sites
+  BasicBlock *Resolved = blockByName(Root, "ic.resolved");
+  BOOST_TEST(Resolved != nullptr);
+  auto *Return = cast<IndirectBrInst>(Resolved->getTerminator());
+  BOOST_TEST(Return->getNumDestinations() == 2U);
+}
@@ -0,0 +1,139 @@
+/// \file InlineSmallHelpers.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE InlineSmallHelpers
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include "revng/Recompile/InlineSmallHelpers.h"
+#include "revng/Support/FunctionTags.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+static const char *RootModule = R"LLVM(
+define internal i32 @small(i32 %a) {
+  %r = add i32 %a, 1
+  ret i32 %r
+}
+
+define internal i32 @medium(i32 %a) {
+  %b = add i32 %a, 1
+  %c = mul i32 %b, 3
+  %r = xor i32 %c, 5
+  ret i32 %r
+}
+
+define internal i32 @large(i32 %a) {
+  %b = add i32 %a, 1
+  %c = mul i32 %b, 3
+  %d = xor i32 %c, 5
+  %e = add i32 %d, 7
+  %f = mul i32 %e, 11
+  %r = xor i32 %f, 13
+  ret i32 %r
+}
+
+define internal i32 @recursive(i32 %a) {
+  %r = call i32 @recursive(i32 %a)
+  ret i32 %r
+}
+
+define i32 @root(i32 %a) {
+  %1 = call i32 @small(i32 %a)
+  %2 = call i32 @small(i32 %1)
+  %3 = call i32 @medium(i32 %2)
+  %4 = call i32 @large(i32 %3)
+  %5 = call i32 @recursive(i32 %4)
+  ret i32 %5
+}
+)LLVM";
+
+static void setOption(StringRef Name, StringRef Value) {
+  cl::Option *Option = cl::getRegisteredOptions().lookup(Name);
+  revng_check(Option != nullptr);
+  revng_check(not Option->addOccurrence(0, Name, Value));
+}
+
+/// Run the pass with a size threshold of 5 instructions: small (2
+/// instructions) and medium (4) are eligible, large (7) is not
+static std::unique_ptr<Module> run(LLVMContext &Context, StringRef Budget) {
+  cl::ResetAllOptionOccurrences();
+  setOption("inline-helpers-size-threshold", "5");
+  setOption("inline-helpers-budget", Budget);
+
+  SMDiagnostic Diagnostic;
+  auto Buffer = MemoryBuffer::getMemBuffer(RootModule);
+  std::unique_ptr<Module> M = parseIR(Buffer->getMemBufferRef(),
+                                      Diagnostic,
+                                      Context);
+  if (M == nullptr) {
+    Diagnostic.print("revng", dbgs());
+    revng_abort();
+  }
+
+  FunctionTags::Root.addTo(M->getFunction("root"));
+  for (const char *Name : { "small", "medium", "large", "recursive" })
+    FunctionTags::Helper.addTo(M->getFunction(Name));
+
+  legacy::PassManager PM;
+  PM.add(new InlineSmallHelpersPass());
+  PM.run(*M);
+
+  revng_check(not verifyModule(*M, &dbgs()));
+  return M;
+}
+
+static bool isCalled(Module &M, StringRef Name) {
+  Function *F = M.getFunction(Name);
+  return F != nullptr and not F->use_empty();
+}
+
+BOOST_AUTO_TEST_CASE(InlineWithinBudget) {
+  LLVMContext Context;
+  std::unique_ptr<Module> M = run(Context, "1000");
+
+  // Inlined and dropped, since they are no longer used
+  BOOST_TEST(M->getFunction("small") == nullptr);
+  BOOST_TEST(M->getFunction("medium") == nullptr);
+
+  // Too large: left to the optimizer, which is free to inline it
+  BOOST_TEST(isCalled(*M, "large"));
+  BOOST_TEST(not M->getFunction("large")->hasFnAttribute(Attribute::NoInline));
+
+  // Recursive helpers are never inlined
+  BOOST_TEST(isCalled(*M, "recursive"));
+}
+
+BOOST_AUTO_TEST_CASE(OutOfBudget) {
+  LLVMContext Context;
+
+  // Inlining small in both call sites costs exactly the budget
+  std::unique_ptr<Module> M = run(Context, "4");
+  BOOST_TEST(M->getFunction("small") == nullptr);
+
+  // medium does not fit anymore: it must not be inlined by later passes either
+  BOOST_TEST(isCalled(*M, "medium"));
+  BOOST_TEST(M->getFunction("medium")->hasFnAttribute(Attribute::NoInline));
+}
+
+BOOST_AUTO_TEST_CASE(DisabledWithZeroBudget) {
+  LLVMContext Context;
+  std::unique_ptr<Module> M = run(Context, "0");
+
+  for (const char *Name : { "small", "medium", "large", "recursive" }) {
+    BOOST_TEST(isCalled(*M, Name));
+    BOOST_TEST(not M->getFunction(Name)->hasFnAttribute(Attribute::NoInline));
+  }
+}
@@ -0,0 +1,405 @@
+/// \file MergeDynamic.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE MergeDynamic
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/Object/ELF.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Recompile/MergeDynamic.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+using namespace llvm::object;
+
+using ELFT = ELF64LE;
+using Elf_Ehdr = ELFT::Ehdr;
+using Elf_Phdr = ELFT::Phdr;
+using Elf_Shdr = ELFT::Shdr;
+using Elf_Sym = ELFT::Sym;
+using Elf_Rela = ELFT::Rela;
+using Elf_Dyn = ELFT::Dyn;
+
+struct TestSymbol {
+  std::string Name;
+  bool Defined = false;
+  uint64_t Value = 0;
+};
+
+struct TestRelocation {
+  uint64_t Offset = 0;
+  uint32_t Symbol = 0;
+  uint32_t Type = 0;
+};
+
+/// Minimal dynamic ELF: a single PT_LOAD segment mapping the whole file,
+/// containing `.dynstr`, `.dynsym`, `.rela.dyn` and `.dynamic`
+class ELFBuilder {
+private:
+  std::string Data;
+
+public:
+  std::string build(uint64_t Base,
+                    ArrayRef<TestSymbol> Symbols,
+                    ArrayRef<TestRelocation> Relocations,
+                    ArrayRef<std::pair<int64_t, uint64_t>> ExtraTags) {
+    Data.clear();
+    Data.resize(sizeof(Elf_Ehdr) + 2 * sizeof(Elf_Phdr), '\0');
+
+    // .dynstr
+    uint64_t DynstrOffset = Data.size();
+    Data.push_back('\0');
+    std::vector<uint32_t> Names;
+    for (const TestSymbol &Symbol : Symbols) {
+      Names.push_back(Data.size() - DynstrOffset);
+      appendString(Symbol.Name);
+    }
+    uint64_t DynstrSize = Data.size() - DynstrOffset;
+
+    // .dynsym
+    uint64_t DynsymOffset = align(8);
+    append(zeroed<Elf_Sym>());
+    for (size_t I = 0; I < Symbols.size(); ++I) {
+      Elf_Sym Symbol = zeroed<Elf_Sym>();
+      Symbol.st_name = Names[I];
+      Symbol.setBindingAndType(ELF::STB_GLOBAL, ELF::STT_OBJECT);
+      Symbol.st_shndx = Symbols[I].Defined ? ELF::SHN_ABS : ELF::SHN_UNDEF;
+      Symbol.st_value = Symbols[I].Value;
+      append(Symbol);
+    }
+    uint64_t DynsymSize = Data.size() - DynsymOffset;
+
+    // .rela.dyn
+    uint64_t RelaOffset = align(8);
+    for (const TestRelocation &Relocation : Relocations) {
+      Elf_Rela Entry = zeroed<Elf_Rela>();
+      Entry.r_offset = Relocation.Offset;
+      Entry.setSymbolAndType(Relocation.Symbol, Relocation.Type, false);
+      append(Entry);
+    }
+    uint64_t RelaSize = Data.size() - RelaOffset;
+
+    // .dynamic
+    std::vector<std::pair<int64_t, uint64_t>> Tags = {
+      { ELF::DT_STRTAB, Base + DynstrOffset },
+      { ELF::DT_STRSZ, DynstrSize },
+      { ELF::DT_SYMTAB, Base + DynsymOffset },
+      { ELF::DT_SYMENT, sizeof(Elf_Sym) },
+      { ELF::DT_RELA, Base + RelaOffset },
+      { ELF::DT_RELASZ, RelaSize },
+      { ELF::DT_RELAENT, sizeof(Elf_Rela) },
+    };
+    Tags.insert(Tags.end(), ExtraTags.begin(), ExtraTags.end());
+    Tags.emplace_back(ELF::DT_NULL, 0);
+
+    uint64_t DynamicOffset = align(8);
+    for (auto [Tag, Value] : Tags) {
+      Elf_Dyn Entry = zeroed<Elf_Dyn>();
+      Entry.d_tag = Tag;
+      Entry.d_un.d_val = Value;
+      append(Entry);
+    }
+    uint64_t DynamicSize = Data.size() - DynamicOffset;
+
+    // .shstrtab
+    uint64_t ShstrtabOffset = Data.size();
+    Data.push_back('\0');
+    struct SectionInfo {
+      const char *Name;
+      uint32_t Type;
+      uint64_t Offset;
+      uint64_t Size;
+      uint64_t EntrySize;
+    };
+    std::vector<SectionInfo> Sections = {
+      { ".dynstr", ELF::SHT_STRTAB, DynstrOffset, DynstrSize, 0 },
+      { ".dynsym", ELF::SHT_DYNSYM, DynsymOffset, DynsymSize, sizeof(Elf_Sym) },
+      { ".rela.dyn", ELF::SHT_RELA, RelaOffset, RelaSize, sizeof(Elf_Rela) },
+      { ".dynamic",
+        ELF::SHT_DYNAMIC,
+        DynamicOffset,
+        DynamicSize,
+        sizeof(Elf_Dyn) },
+      { ".shstrtab", ELF::SHT_STRTAB, ShstrtabOffset, 0, 0 },
+    };
+    std::vector<uint32_t> SectionNames;
+    for (const SectionInfo &Section : Sections) {
+      SectionNames.push_back(Data.size() - ShstrtabOffset);
+      appendString(Section.Name);
+    }
+    Sections.back().Size = Data.size() - ShstrtabOffset;
+
+    // Section headers
+    uint64_t SectionHeadersOffset = align(8);
+    append(zeroed<Elf_Shdr>());
+    for (size_t I = 0; I < Sections.size(); ++I) {
+      const SectionInfo &Info = Sections[I];
+      Elf_Shdr Section = zeroed<Elf_Shdr>();
+      Section.sh_name = SectionNames[I];
+      Section.sh_type = Info.Type;
+      if (StringRef(Info.Name) != ".shstrtab")
+        Section.sh_flags = ELF::SHF_ALLOC;
+      Section.sh_addr = Base + Info.Offset;
+      Section.sh_offset = Info.Offset;
+      Section.sh_size = Info.Size;
+      Section.sh_addralign = 8;
+      Section.sh_entsize = Info.EntrySize;
+      append(Section);
+    }
+
+    // Program headers
+    Elf_Phdr Load = zeroed<Elf_Phdr>();
+    Load.p_type = ELF::PT_LOAD;
+    Load.p_flags = ELF::PF_R | ELF::PF_W;
+    Load.p_vaddr = Base;
+    Load.p_paddr = Base;
+    Load.p_filesz = Data.size();
+    Load.p_memsz = Data.size();
+    Load.p_align = 0x1000;
+    writeAt(sizeof(Elf_Ehdr), Load);
+
+    Elf_Phdr Dynamic = zeroed<Elf_Phdr>();
+    Dynamic.p_type = ELF::PT_DYNAMIC;
+    Dynamic.p_flags = ELF::PF_R | ELF::PF_W;
+    Dynamic.p_offset = DynamicOffset;
+    Dynamic.p_vaddr = Base + DynamicOffset;
+    Dynamic.p_paddr = Base + DynamicOffset;
+    Dynamic.p_filesz = DynamicSize;
+    Dynamic.p_memsz = DynamicSize;
+    Dynamic.p_align = 8;
+    writeAt(sizeof(Elf_Ehdr) + sizeof(Elf_Phdr), Dynamic);
+
+    // ELF header
+    Elf_Ehdr Header = zeroed<Elf_Ehdr>();
+    std::memcpy(Header.e_ident, ELF::ElfMagic, strlen(ELF::ElfMagic));
+    Header.e_ident[ELF::EI_CLASS] = ELF::ELFCLASS64;
+    Header.e_ident[ELF::EI_DATA] = ELF::ELFDATA2LSB;
+    Header.e_ident[ELF::EI_VERSION] = ELF::EV_CURRENT;
+    Header.e_type = ELF::ET_EXEC;
+    Header.e_machine = ELF::EM_X86_64;
+    Header.e_version = ELF::EV_CURRENT;
+    Header.e_phoff = sizeof(Elf_Ehdr);
+    Header.e_shoff = SectionHeadersOffset;
+    Header.e_ehsize = sizeof(Elf_Ehdr);
+    Header.e_phentsize = sizeof(Elf_Phdr);
+    Header.e_phnum = 2;
+    Header.e_shentsize = sizeof(Elf_Shdr);
+    Header.e_shnum = Sections.size() + 1;
+    Header.e_shstrndx = Sections.size();
+    writeAt(0, Header);
+
+    return Data;
+  }
+
+private:
+  template<typename T>
+  static T zeroed() {
+    T Result;
+    std::memset(&Result, 0, sizeof(T));
+    return Result;
+  }
+
+  uint64_t align(uint64_t Alignment) {
+    Data.resize(alignTo(Data.size(), Alignment), '\0');
+    return Data.size();
+  }
+
+  void appendString(StringRef String) {
+    Data.append(String.data(), String.size());
+    Data.push_back('\0');
+  }
+
+  template<typename T>
+  void append(const T &Value) {
+    Data.append(reinterpret_cast<const char *>(&Value), sizeof(T));
+  }
+
+  template<typename T>
+  void writeAt(uint64_t Offset, const T &Value) {
+    std::memcpy(Data.data() + Offset, &Value, sizeof(T));
+  }
+};
+
+static uint32_t elfHash(StringRef Name) {
+  uint32_t Hash = 0;
+  for (uint8_t Character : Name.bytes()) {
+    Hash = (Hash << 4) + Character;
+    uint32_t High = Hash & 0xf0000000;
+    Hash ^= High >> 24;
+    Hash &= ~High;
+  }
+  return Hash;
+}
+
+template<typename T>
+static const T *at(const ELFFile<ELFT> &File, uint64_t Address) {
+  return reinterpret_cast<const T *>(cantFail(File.toMappedAddr(Address)));
+}
+
+BOOST_AUTO_TEST_CASE(MergeSymbolsRelocationsAndHashTable) {
+  // The ELF obtained linking the translated code
+  const uint64_t ToExtendBase = 0x400000;
+  std::vector<TestSymbol> ToExtendSymbols = { { "translated", true, 0x400100 },
+                                              { "puts", false, 0 } };
+  std::vector<TestRelocation> ToExtendRelocations = {
+    { 0x400180, 2, ELF::R_X86_64_GLOB_DAT },
+  };
+  std::string ToExtend = ELFBuilder().build(ToExtendBase,
+                                            ToExtendSymbols,
+                                            ToExtendRelocations,
+                                            { { ELF::DT_GNU_HASH, 0 } });
+
+  // The original ELF
+  const uint64_t SourceBase = 0x10000000;
+  std::vector<TestSymbol> SourceSymbols = { { "environ", true, 0x10000100 },
+                                            { "stdout", true, 0x10000108 },
+                                            { "optarg", true, 0x10000110 },
+                                            { "printf", false, 0 } };
+  std::vector<TestRelocation> SourceRelocations = {
+    { 0x10000100, 1, ELF::R_X86_64_COPY },
+    { 0x10000108, 2, ELF::R_X86_64_COPY },
+    { 0x10000110, 3, ELF::R_X86_64_COPY },
+    { 0x10000118, 4, ELF::R_X86_64_JUMP_SLOT },
+  };
+  std::string Source = ELFBuilder().build(SourceBase,
+                                          SourceSymbols,
+                                          SourceRelocations,
+                                          {});
+
+  std::string Merged;
+  raw_string_ostream Stream(Merged);
+  cantFail(mergeDynamic(ToExtend, Source, Stream, 0));
+  Stream.flush();
+
+  auto File = cantFail(ELFFile<ELFT>::create(Merged));
+
+  //
+  // .dynamic
+  //
+  std::map<int64_t, uint64_t> Tags;
+  unsigned HashTables = 0;
+  for (const Elf_Dyn &Entry : cantFail(File.dynamicEntries())) {
+    if (Entry.getTag() == ELF::DT_NULL)
+      break;
+    if (Entry.getTag() == ELF::DT_HASH or Entry.getTag() == ELF::DT_GNU_HASH)
+      ++HashTables;
+    Tags[Entry.getTag()] = Entry.getVal();
+  }
+
+  // The GNU hash table is replaced by a single DT_HASH
+  BOOST_TEST(HashTables == 1U);
+  BOOST_TEST(Tags.count(ELF::DT_HASH) == 1U);
+  BOOST_TEST(Tags.count(ELF::DT_GNU_HASH) == 0U);
+
+  // The tables have been moved to a new segment past the end of ToExtend
+  for (int64_t Tag : { ELF::DT_STRTAB, ELF::DT_SYMTAB, ELF::DT_RELA })
+    BOOST_TEST(Tags.at(Tag) >= ToExtendBase + ToExtend.size());
+
+  const unsigned SymbolsCount = 1 + ToExtendSymbols.size()
+                                + SourceSymbols.size();
+  BOOST_TEST(Tags.at(ELF::DT_RELASZ)
+             == (ToExtendRelocations.size() + SourceRelocations.size())
+                  * sizeof(Elf_Rela));
+
+  //
+  // .dynsym
+  //
+  const char *Strings = at<char>(File, Tags.at(ELF::DT_STRTAB));
+  const Elf_Sym *Symbols = at<Elf_Sym>(File, Tags.at(ELF::DT_SYMTAB));
+  auto NameOf = [&](uint32_t Index) -> StringRef {
+    revng_check(Symbols[Index].st_name < Tags.at(ELF::DT_STRSZ));
+    return Strings + Symbols[Index].st_name;
+  };
+
+  std::vector<StringRef> ExpectedNames = { "",        "translated", "puts",
+                                           "environ", "stdout",     "optarg",
+                                           "printf" };
+  for (uint32_t Index = 0; Index < SymbolsCount; ++Index)
+    BOOST_TEST(NameOf(Index) == ExpectedNames[Index]);
+  BOOST_TEST(Symbols[3].st_value == 0x10000100U);
+  BOOST_TEST(Symbols[6].st_shndx == ELF::SHN_UNDEF);
+
+  bool FoundDynsym = false;
+  for (const Elf_Shdr &Section : cantFail(File.sections())) {
+    if (cantFail(File.getSectionName(Section)) != ".dynsym")
+      continue;
+    FoundDynsym = true;
+    BOOST_TEST(Section.sh_addr == Tags.at(ELF::DT_SYMTAB));
+    BOOST_TEST(Section.sh_size == SymbolsCount * sizeof(Elf_Sym));
+  }
+  BOOST_TEST(FoundDynsym);
+
+  // The relocations of Source refer to the shifted symbols
+  const Elf_Rela *Relocations = at<Elf_Rela>(File, Tags.at(ELF::DT_RELA));
+  BOOST_TEST(Relocations[0].getSymbol(false) == 2U);
+  for (size_t I = 0; I < SourceRelocations.size(); ++I) {
+    const Elf_Rela &Relocation = Relocations[1 + I];
+    BOOST_TEST(Relocation.getSymbol(false)
+               == SourceRelocations[I].Symbol + ToExtendSymbols.size());
+    BOOST_TEST(Relocation.getType(false) == SourceRelocations[I].Type);
+  }
+
+  //
+  // DT_HASH
+  //
+  const uint32_t *Hash = at<uint32_t>(File, Tags.at(ELF::DT_HASH));
+  uint32_t BucketsCount = Hash[0];
+  const uint32_t *Buckets = Hash + 2;
+  const uint32_t *Chains = Buckets + BucketsCount;
+  BOOST_TEST(BucketsCount == 3U);
+  BOOST_TEST(Hash[1] == SymbolsCount);
+
+  // Look up as the loader does
+  auto Lookup = [&](StringRef Name) -> uint32_t {
+    uint32_t Index = Buckets[elfHash(Name) % BucketsCount];
+    for (; Index != 0; Index = Chains[Index])
+      if (NameOf(Index) == Name)
+        return Index;
+    return 0;
+  };
+
+  BOOST_TEST(Lookup("translated") == 1U);
+  BOOST_TEST(Lookup("environ") == 3U);
+  BOOST_TEST(Lookup("stdout") == 4U);
+  BOOST_TEST(Lookup("optarg") == 5U);
+
+  // Undefined symbols are not part of the hash table
+  BOOST_TEST(Lookup("puts") == 0U);
+  BOOST_TEST(Lookup("printf") == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(NonDynamicSourceIsCopied) {
+  std::string ToExtend = ELFBuilder().build(0x400000,
+                                            { { "translated", true, 1 } },
+                                            { { 0x400180, 1, 0 } },
+                                            {});
+
+  // Turn the PT_DYNAMIC of the source into a PT_NULL
+  std::string Source = ToExtend;
+  Elf_Phdr Dynamic;
+  uint64_t Offset = sizeof(Elf_Ehdr) + sizeof(Elf_Phdr);
+  std::memcpy(&Dynamic, Source.data() + Offset, sizeof(Elf_Phdr));
+  Dynamic.p_type = ELF::PT_NULL;
+  std::memcpy(Source.data() + Offset, &Dynamic, sizeof(Elf_Phdr));
+
+  std::string Merged;
+  raw_string_ostream Stream(Merged);
+  cantFail(mergeDynamic(ToExtend, Source, Stream, 0));
+  Stream.flush();
+
+  BOOST_TEST(Merged == ToExtend);
+}
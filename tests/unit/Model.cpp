@@ -11,6 +11,7 @@ bool init_unit_test();
 #include "revng/Model/Binary.h"
 #include "revng/Model/Pass/AllPasses.h"
 #include "revng/Model/Processing.h"
+#include "revng/Model/StreamingDiff.h"
 #include "revng/Support/MetaAddress.h"
 #include "revng/Support/MetaAddress/YAMLTraits.h"
 #include "revng/Support/YAMLTraits.h"
@@ -281,6 +282,58 @@ BOOST_AUTO_TEST_CASE(TestTupleTreeDiffDeserialization) {
   BOOST_TEST(S == S2);
 }
 
+BOOST_AUTO_TEST_CASE(TestStreamingDiff) {
+  auto UInt32 = model::PrimitiveType::makeGeneric(4);
+
+  TupleTree<model::Binary> Old;
+  Old->Functions()[ARM1000].OriginalName() = "first";
+  Old->Functions()[ARM2000].OriginalName() = "removed";
+  Old->Functions()[ARM3000].OriginalName() = "third";
+  Old->makeTypedefDefinition(UInt32.copy()).first.OriginalName() = "Old";
+
+  TupleTree<model::Binary> New = Old;
+  New->Functions().erase(ARM2000);
+  New->Functions()[ARM3000].OriginalName() = "changed";
+  New->ImportedLibraries().insert("libc.so.6");
+  New->makeTypedefDefinition(UInt32.copy()).first.OriginalName() = "New";
+
+  std::string OldText = toString(*Old);
+  std::string NewText = toString(*New);
+
+  // The streaming diff must be equivalent to the regular one
+  std::string DiffText;
+  {
+    llvm::raw_string_ostream Stream(DiffText);
+    size_t Count = llvm::cantFail(model::streamingDiff(OldText,
+                                                       NewText,
+                                                       Stream));
+    BOOST_TEST(Count == diff(*Old, *New).Changes.size());
+  }
+
+  using Diff = TupleTreeDiff<model::Binary>;
+  auto StreamingDiff = llvm::cantFail(fromString<Diff>(DiffText));
+
+  // Applying it without streaming produces the new model
+  TupleTree<model::Binary> Patched = Old;
+  llvm::cantFail(StreamingDiff.apply(Patched));
+  BOOST_TEST(toString(*Patched) == NewText);
+
+  // Applying it with streaming produces the new model too
+  std::string StreamingPatched;
+  {
+    llvm::raw_string_ostream Stream(StreamingPatched);
+    llvm::cantFail(model::streamingApply(OldText, StreamingDiff, Stream));
+  }
+  auto Reloaded = TupleTree<model::Binary>::fromString(StreamingPatched);
+  BOOST_TEST(toString(**llvm::cantFail(std::move(Reloaded))) == NewText);
+
+  // Identical models have no differences
+  std::string Empty;
+  llvm::raw_string_ostream Stream(Empty);
+  BOOST_TEST(llvm::cantFail(model::streamingDiff(OldText, OldText, Stream))
+             == 0);
+}
+
 BOOST_AUTO_TEST_CASE(CABIFunctionTypePathShouldParse) {
   const char *Path = "/TypeDefinitions/10000-CABIFunctionDefinition";
   auto MaybeParsed = stringAsPath<model::Binary>(Path);
@@ -406,3 +459,46 @@ BOOST_AUTO_TEST_CASE(CollectReadFieldsShouldCollectAllSegments) {
   };
   BOOST_TEST(Collected.ExactVectors == Paths);
 }
+
+BOOST_AUTO_TEST_CASE(ReadOnlyVersionShouldChangeAfterModifications) {
+  TupleTree<model::Binary> Model;
+  BOOST_TEST(Model.readOnlyVersion() == 0);
+
+  Model.cacheReferences();
+  uint64_t FirstVersion = Model.readOnlyVersion();
+  BOOST_TEST(FirstVersion != 0);
+
+  // Caching twice does not start a new read-only period
+  Model.cacheReferences();
+  BOOST_TEST(Model.readOnlyVersion() == FirstVersion);
+
+  // Copies are not read-only
+  TupleTree<model::Binary> Copy = Model;
+  BOOST_TEST(Copy.readOnlyVersion() == 0);
+
+  Model.evictCachedReferences();
+  BOOST_TEST(Model.readOnlyVersion() == 0);
+
+  Model.cacheReferences();
+  BOOST_TEST(Model.readOnlyVersion() != 0);
+  BOOST_TEST(Model.readOnlyVersion() != FirstVersion);
+}
+
+BOOST_AUTO_TEST_CASE(PromoteOriginalNameShouldResolveCollisions) {
+  TupleTree<model::Binary> Model;
+  auto ARM4000 = MetaAddress::fromString("0x4000:Code_arm");
+  Model->Functions()[ARM1000].OriginalName() = "foo::bar";
+  Model->Functions()[ARM2000].OriginalName() = "foo::bar";
+  Model->Functions()[ARM3000].CustomName() = "foo__bar__";
+  Model->Functions()[ARM4000].OriginalName() = "foo::bar";
+
+  model::promoteOriginalName(Model);
+
+  auto NameOf = [&Model](const MetaAddress &Entry) {
+    return Model->Functions().at(Entry).CustomName().str().str();
+  };
+  BOOST_TEST(NameOf(ARM1000) == "foo__bar");
+  BOOST_TEST(NameOf(ARM2000) == "foo__bar_");
+  BOOST_TEST(NameOf(ARM3000) == "foo__bar__");
+  BOOST_TEST(NameOf(ARM4000) == "foo__bar___");
+}
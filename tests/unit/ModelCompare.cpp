@@ -0,0 +1,100 @@
+/// \file ModelCompare.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE ModelCompare
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "revng/Model/Compare.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+static bool isEqual(StringRef Input, StringRef Reference) {
+  return cantFail(model::compareYAML(Reference, Input, true)).Matches;
+}
+
+static bool isSubgraph(StringRef Input, StringRef Reference) {
+  return cantFail(model::compareYAML(Reference, Input, false)).Matches;
+}
+
+BOOST_AUTO_TEST_CASE(Exact) {
+  revng_check(isEqual("{}", "{}"));
+  revng_check(isEqual("3", "3"));
+  revng_check(not isEqual("2", "3"));
+  revng_check(isEqual("[3]", "[3]"));
+  revng_check(not isEqual("[2]", "[3]"));
+  revng_check(not isEqual("[]", "{}"));
+  revng_check(isEqual("{a: 2}", "{a: 2}"));
+  revng_check(not isEqual("{a: 2}", "{}"));
+  revng_check(not isEqual("{a: 2, b: 3}", "{b: 2, a: 3}"));
+  revng_check(isEqual("[1, 2, 3]", "[1, 2, 3]"));
+  revng_check(not isEqual("[1, 3, 2]", "[1, 2, 3]"));
+}
+
+BOOST_AUTO_TEST_CASE(Subgraph) {
+  revng_check(isSubgraph("{}", "{}"));
+  revng_check(not isSubgraph("{}", "{a: 2}"));
+  revng_check(isSubgraph("[3]", "[3]"));
+  revng_check(not isSubgraph("[2]", "[3]"));
+  revng_check(not isSubgraph("[]", "{}"));
+  revng_check(isSubgraph("{a: 2}", "{a: 2}"));
+  revng_check(isSubgraph("{a: 2}", "{}"));
+  revng_check(isSubgraph("{a: 2, b: 3}", "{b: 3, a: 2}"));
+  revng_check(isSubgraph("[1, 2, 3]", "[1, 2, 3]"));
+  revng_check(isSubgraph("[1, 3, 2]", "[1, 2, 3]"));
+
+  // Each element of the input can be matched only once
+  revng_check(not isSubgraph("[1]", "[1, 1]"));
+
+  // The reference can match a nested part of the input
+  revng_check(isSubgraph("{a: {b: {c: 1}}}", "{c: 1}"));
+}
+
+BOOST_AUTO_TEST_CASE(ScalarTypes) {
+  revng_check(isSubgraph("{a: '1'}", "{a: '1'}"));
+  revng_check(not isSubgraph("{a: 1}", "{a: '1'}"));
+  revng_check(isSubgraph("{a: 0x10}", "{a: 16}"));
+  revng_check(isSubgraph("{a: yes}", "{a: true}"));
+}
+
+BOOST_AUTO_TEST_CASE(Markers) {
+  // -Key requires Key to be absent
+  revng_check(isSubgraph("{x: [{a: 1}, {a: 2, b: 1}]}",
+                         "{x: [{a: 2}, {a: 1, -b: 1}]}"));
+  revng_check(not isSubgraph("{x: [{a: 1, b: 2}]}", "{x: [{a: 1, -b: 1}]}"));
+
+  // $Key requires Key to have the same size
+  revng_check(isSubgraph("{x: [1, 2]}", "{$x: [2, 1]}"));
+  revng_check(not isSubgraph("{x: [1, 2, 3]}", "{$x: [2, 1]}"));
+}
+
+BOOST_AUTO_TEST_CASE(References) {
+  StringRef Reference = "{ a: /TypeDefinitions/1-DoesNotMatter,"
+                        "  TypeDefinitions: [{ ID: 1, b: 3 }] }";
+
+  revng_check(isSubgraph("{ a: /TypeDefinitions/2-DoesNotMatter,"
+                         "  TypeDefinitions: [{ ID: 1, b: 5 },"
+                         "                    { ID: 2, b: 3 }] }",
+                         Reference));
+  revng_check(not isSubgraph("{ a: /TypeDefinitions/2-DoesNotMatter,"
+                             "  TypeDefinitions: [{ ID: 1, b: 5 },"
+                             "                    { ID: 2, b: 4 }] }",
+                             Reference));
+}
+
+BOOST_AUTO_TEST_CASE(BestMatch) {
+  auto Result = cantFail(model::compareYAML("[1, 2, 3]", "[1, 2]", false));
+  revng_check(not Result.Matches);
+  revng_check(Result.ReferenceNodes == 4);
+  revng_check(Result.MatchedNodes == 3);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidYAML) {
+  auto Result = model::compareYAML("{a", "{}", false);
+  revng_check(not Result);
+  consumeError(Result.takeError());
+}
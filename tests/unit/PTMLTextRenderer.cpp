@@ -0,0 +1,51 @@
+/// \file PTMLTextRenderer.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE PTMLTextRenderer
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/PTML/TextRenderer.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+static const char *Document = "<div data-token=\"c.keyword\">int "
+                              "<span data-token='c.variable'>x</span>"
+                              "<br/><!-- a > b --> &lt;&#65;&#x42;</div>\n"
+                              "<span data-token=\"unknown\">y</span>\n";
+
+static std::string render(StringRef Input, bool Color, size_t ChunkSize) {
+  std::string Result;
+  raw_string_ostream OS(Result);
+  ptml::TextRenderer Renderer(OS, Color, "  ");
+  for (size_t I = 0; I < Input.size(); I += ChunkSize)
+    Renderer.feed(Input.substr(I, ChunkSize));
+  revng_check(not Renderer.finish());
+  OS.flush();
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(Plain) {
+  for (size_t ChunkSize : { 1, 3, 1024 })
+    BOOST_TEST(render(Document, false, ChunkSize) == "int x <AB\n  y\n  ");
+}
+
+BOOST_AUTO_TEST_CASE(Color) {
+  std::string Expected = "\x1b[38;5;33mint \x1b[38;5;214mx\x1b[38;5;33m <AB"
+                         "\x1b[0m\n  y\n  ";
+  for (size_t ChunkSize : { 1, 3, 1024 })
+    BOOST_TEST(render(Document, true, ChunkSize) == Expected);
+}
+
+BOOST_AUTO_TEST_CASE(Malformed) {
+  std::string Result;
+  raw_string_ostream OS(Result);
+  for (StringRef Input : { "<a>x</a></b>", "<a>x", "<a x=\"", "&nope;" })
+    BOOST_TEST(errorToBool(ptml::TextRenderer::render(OS, Input, false)));
+}
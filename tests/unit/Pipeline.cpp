@@ -5,7 +5,9 @@
 //
 
 #include <algorithm>
+#include <array>
 #include <memory>
+#include <thread>
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
@@ -18,6 +20,8 @@
 #include "llvm/InitializePasses.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Transforms/Utils/Cloning.h"
@@ -38,9 +42,12 @@
 #include "revng/Pipeline/LLVMContainerFactory.h"
 #include "revng/Pipeline/LLVMKind.h"
 #include "revng/Pipeline/Loader.h"
+#include "revng/Pipeline/PipeOutputCache.h"
 #include "revng/Pipeline/Runner.h"
 #include "revng/Pipeline/Target.h"
+#include "revng/Pipes/ModelGlobal.h"
 #include "revng/Support/Assert.h"
+#include "revng/Support/TemporaryFile.h"
 
 #define BOOST_TEST_MODULE Pipeline
 bool init_unit_test();
@@ -1281,6 +1288,101 @@ BOOST_AUTO_TEST_CASE(InspectorKindTest) {
   BOOST_TEST(Container->enumerate().contains(RootF));
 }
 
+BOOST_AUTO_TEST_CASE(LLVMContainerStoreOverLoadedFile) {
+  Context Ctx;
+  llvm::LLVMContext C;
+
+  using Cont = LLVMContainer;
+  auto Factory = ContainerFactory::fromGlobal<Cont>(&Ctx, &C);
+
+  auto Container = Factory("dont-care");
+  makeF(cast<Cont>(*Container).getModule(), "root");
+
+  TemporaryFile Temporary("revng-llvm-container", "ll");
+  auto Path = revng::FilePath::fromLocalStorage(Temporary.path());
+  cantFail(Container->store(Path));
+
+  // The module is not parsed yet, hence storing it again writes back the file
+  // it has been loaded from, which is still in use
+  auto Loaded = Factory("dont-care");
+  cantFail(Loaded->load(Path));
+  Target RootF({ "root" }, InspKindExample);
+  BOOST_TEST(Loaded->enumerate().contains(RootF));
+  cantFail(Loaded->store(Path));
+  BOOST_TEST(cast<Cont>(*Loaded).getModule().getFunction("root") != nullptr);
+
+  auto Reloaded = Factory("dont-care");
+  cantFail(Reloaded->load(Path));
+  BOOST_TEST(cast<Cont>(*Reloaded).getModule().getFunction("root") != nullptr);
+}
+
+static void addFunctionCreatorSteps(Runner &Pipeline,
+                                    Context &Ctx,
+                                    llvm::LLVMContext &C) {
+  using Cont = LLVMContainer;
+  Pipeline.addContainerFactory(CName,
+                               ContainerFactory::fromGlobal<Cont>(&Ctx, &C));
+  Pipeline.emplaceStep("", "first-step", "");
+  Pipeline.emplaceStep("first-step",
+                       "end",
+                       "",
+                       Cont::wrapLLVMPasses(CName, LLVMPassFunctionCreator()));
+}
+
+BOOST_AUTO_TEST_CASE(StoreSnapshotWhileProducing) {
+  llvm::SmallString<128> Directory;
+  revng_check(not llvm::sys::fs::createUniqueDirectory("revng-pipeline",
+                                                       Directory));
+  auto Path = revng::DirectoryPath::fromLocalStorage(Directory);
+
+  llvm::LLVMContext C;
+  {
+    Context Ctx;
+    Runner Pipeline(Ctx);
+    addFunctionCreatorSteps(Pipeline, Ctx, C);
+    makeF(Pipeline["first-step"]
+            .containers()
+            .getOrCreate<LLVMContainer>(CName)
+            .getModule(),
+          "root");
+    cantFail(Pipeline.store(Path));
+  }
+
+  Context Ctx;
+  Runner Pipeline(Ctx);
+  addFunctionCreatorSteps(Pipeline, Ctx, C);
+  cantFail(Pipeline.load(Path));
+
+  // The loaded module has not been parsed yet: producing parses it from the
+  // file that the snapshot is being written to
+  auto Snapshot = Pipeline.snapshot();
+  std::thread Saver([&Snapshot, &Path]() {
+    for (int I = 0; I < 20; ++I)
+      cantFail(Snapshot.store(Path));
+  });
+
+  ContainerToTargetsMap Targets;
+  Targets.add(CName, Target({ "f1" }, FunctionKind));
+  auto Error = Pipeline.run("end", Targets);
+  Saver.join();
+  BOOST_TEST(!Error);
+
+  const auto &Final = Pipeline["end"].containers().get<LLVMContainer>(CName);
+  BOOST_TEST(Final.getModule().getFunction("f1") != nullptr);
+
+  Context ReloadedCtx;
+  Runner Reloaded(ReloadedCtx);
+  addFunctionCreatorSteps(Reloaded, ReloadedCtx, C);
+  cantFail(Reloaded.load(Path));
+  auto &First = Reloaded["first-step"].containers();
+  const auto *Root = First.getOrCreate<LLVMContainer>(CName)
+                       .getModule()
+                       .getFunction("root");
+  BOOST_TEST(Root != nullptr);
+
+  llvm::sys::fs::remove_directories(Directory);
+}
+
 BOOST_AUTO_TEST_CASE(MultiStepInvalidationTest) {
   Context Ctx;
   Runner Pipeline(Ctx);
@@ -1369,4 +1471,94 @@ BOOST_AUTO_TEST_CASE(PipeOptions) {
     BOOST_FAIL("unreachable");
 }
 
+class ReadOnlyTestAnalysis {
+public:
+  constexpr static const char *Name = "read-only";
+  static constexpr std::array<const char *, 0> WrittenGlobals = {};
+
+  std::vector<std::vector<pipeline::Kind *>> AcceptedKinds = { { &RootKind } };
+
+  void run(const ExecutionContext &EC, const MapContainer &Cont) {}
+};
+
+BOOST_AUTO_TEST_CASE(AnalysesDeclareWrittenGlobals) {
+  pipeline::AnalysisWrapperImpl ReadOnly(ReadOnlyTestAnalysis(),
+                                         { "container-name" });
+  auto ReadOnlyWrittenGlobals = ReadOnly.getWrittenGlobals();
+  BOOST_TEST(ReadOnlyWrittenGlobals.has_value());
+  BOOST_TEST(ReadOnlyWrittenGlobals->empty());
+
+  pipeline::AnalysisWrapperImpl Undeclared(ArgumentTestAnalysis(),
+                                           { "container-name" });
+  BOOST_TEST(not Undeclared.getWrittenGlobals().has_value());
+}
+
+static bool setCommandLineOption(llvm::StringRef Name, llvm::StringRef Value) {
+  llvm::cl::Option *Option = llvm::cl::getRegisteredOptions().lookup(Name);
+  revng_check(Option != nullptr);
+  return not Option->addOccurrence(0, Name, Value);
+}
+
+BOOST_AUTO_TEST_CASE(PipeOutputCacheHitsMissesAndInvalidations) {
+  BOOST_TEST(setCommandLineOption("pipe-output-cache-size", "1"));
+  PipeOutputCache &Cache = PipeOutputCache::get();
+  Cache.clear();
+
+  Context Ctx;
+  Ctx.addGlobal<revng::ModelGlobal>("model");
+  auto &Model = cantFail(Ctx.getGlobal<revng::ModelGlobal>("model"))->get();
+  Model->Architecture() = model::Architecture::x86_64;
+
+  auto CName2 = CName + "2";
+  auto Factory = ContainerFactory::create<MapContainer>();
+  ContainerSet Containers;
+  Containers.add(CName, Factory);
+  Containers.add(CName2, Factory);
+
+  const Target F1({ "f1" }, FunctionKind);
+  const Target F2({ "f2" }, FunctionKind);
+  cast<MapContainer>(Containers[CName]).get(F1) = 1;
+  Containers[CName2];
+
+  PipeWrapper Pipe = PipeWrapper::bind<CopyPipe>(CName, CName2);
+  ContainerToTargetsMap Slice;
+  Slice[CName].push_back(F1);
+  ContainerToTargetsMap Requested;
+  Requested[CName2].push_back(F1);
+
+  std::string Key = Cache.computeKey(Pipe, Containers, Slice, Requested);
+  BOOST_TEST(not Cache.restore(Key, Ctx, Pipe, Containers));
+
+  // Pretend that producing f1 read the architecture
+  auto Architecture = stringAsPath<model::Binary>("/Architecture");
+  BOOST_TEST(Architecture.has_value());
+  Pipe.InvalidationMetadata.getPathCache("model")
+    .insert(TargetInContainer(F1, CName2), *Architecture);
+  Cache.record(Key, Ctx, Pipe, Containers, Requested);
+  BOOST_TEST(Cache.restore(Key, Ctx, Pipe, Containers));
+
+  // Fields that have not been read do not affect the cached result
+  Model->ImportedLibraries().insert("libc.so.6");
+  BOOST_TEST(Cache.restore(Key, Ctx, Pipe, Containers));
+
+  // Requesting other targets is a different invocation
+  ContainerToTargetsMap OtherRequested;
+  OtherRequested[CName2].push_back(F2);
+  BOOST_TEST(Cache.computeKey(Pipe, Containers, Slice, OtherRequested) != Key);
+
+  // Changing a field that has been read drops the entry
+  Model->Architecture() = model::Architecture::aarch64;
+  BOOST_TEST(not Cache.restore(Key, Ctx, Pipe, Containers));
+  Model->Architecture() = model::Architecture::x86_64;
+  BOOST_TEST(not Cache.restore(Key, Ctx, Pipe, Containers));
+
+  auto Statistics = Cache.statistics().lookup(CopyPipe::Name);
+  BOOST_TEST(Statistics.Hits == 2U);
+  BOOST_TEST(Statistics.Misses == 3U);
+  BOOST_TEST(Statistics.Invalidations == 1U);
+
+  Cache.clear();
+  BOOST_TEST(setCommandLineOption("pipe-output-cache-size", "0"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+/// \file ProgressTrace.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE ProgressTrace
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Support/ProgressTrace.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+static std::string makeTrace() {
+  std::string Result;
+  raw_string_ostream OS(Result);
+  ProgressTrace::writeHeader(OS, 42);
+
+  std::string Events;
+  ProgressTrace::appendEvent(Events, ProgressTrace::Span, "\"lift\"", 100, 20);
+  ProgressTrace::appendEvent(Events, ProgressTrace::Instant, "exit", 130);
+  ProgressTrace::writeChunkHeader(OS, 7, Events.size());
+  OS << Events;
+
+  OS.flush();
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(EventsShouldBeConvertedToChromeJSON) {
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  revng_check(not ProgressTrace::toChromeJSON(makeTrace(), OS));
+  OS.flush();
+
+  Expected<json::Value> Parsed = json::parse(Buffer);
+  revng_check(static_cast<bool>(Parsed));
+  json::Array *Events = Parsed->getAsArray();
+  revng_check(Events != nullptr and Events->size() == 2);
+
+  json::Object *Span = (*Events)[0].getAsObject();
+  revng_check(*Span->getString("name") == "\"lift\"");
+  revng_check(*Span->getString("ph") == "X");
+  revng_check(*Span->getInteger("ts") == 100);
+  revng_check(*Span->getInteger("dur") == 20);
+  revng_check(*Span->getInteger("pid") == 42);
+  revng_check(*Span->getInteger("tid") == 7);
+
+  json::Object *Instant = (*Events)[1].getAsObject();
+  revng_check(*Instant->getString("ph") == "i");
+  revng_check(*Instant->getInteger("ts") == 130);
+}
+
+BOOST_AUTO_TEST_CASE(TruncatedTracesShouldBeRejected) {
+  std::string Trace = makeTrace();
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  Error Result = ProgressTrace::toChromeJSON(StringRef(Trace).drop_back(1), OS);
+  revng_check(static_cast<bool>(Result));
+  consumeError(std::move(Result));
+}
@@ -0,0 +1,91 @@
+/// \file Main.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+#include "revng/Recompile/MergeDynamic.h"
+#include "revng/Support/InitRevng.h"
+
+using namespace llvm;
+
+static cl::OptionCategory ThisToolCategory("Tool options", "");
+
+static cl::opt<std::string> ToExtendPath(cl::Positional,
+                                         cl::cat(ThisToolCategory),
+                                         cl::desc("<to extend>"),
+                                         cl::Required,
+                                         cl::value_desc("the ELF to extend"));
+
+static cl::opt<std::string> SourcePath(cl::Positional,
+                                       cl::cat(ThisToolCategory),
+                                       cl::desc("<source>"),
+                                       cl::Required,
+                                       cl::value_desc("the original ELF"));
+
+static cl::opt<std::string> OutputPath(cl::Positional,
+                                       cl::cat(ThisToolCategory),
+                                       cl::desc("<output>"),
+                                       cl::init("-"),
+                                       cl::value_desc("the output ELF"));
+
+static cl::opt<uint64_t> Base("base",
+                              cl::cat(ThisToolCategory),
+                              cl::desc("The base address where dynamic "
+                                       "objects have been loaded."),
+                              cl::init(0x400000),
+                              cl::value_desc("address"));
+
+static cl::opt<bool> MergeLoadSegments("merge-load-segments",
+                                       cl::cat(ThisToolCategory),
+                                       cl::desc("Merge the LOADed segments "
+                                                "from the source ELF into the "
+                                                "output ELF."),
+                                       cl::init(false));
+
+int main(int Argc, char *Argv[]) {
+  revng::InitRevng X(Argc, Argv, "", { &ThisToolCategory });
+
+  ExitOnError ExitOnError;
+
+  auto Read = [&ExitOnError](StringRef Path) {
+    auto MaybeBuffer = MemoryBuffer::getFile(Path);
+    if (not MaybeBuffer)
+      ExitOnError(errorCodeToError(MaybeBuffer.getError()));
+    return std::move(*MaybeBuffer);
+  };
+
+  auto ToExtend = Read(ToExtendPath);
+  auto Source = Read(SourcePath);
+
+  std::error_code EC;
+  ToolOutputFile OutputFile(OutputPath, EC, sys::fs::OpenFlags::OF_None);
+  if (EC)
+    ExitOnError(createStringError(EC, EC.message()));
+
+  ExitOnError(mergeDynamic(ToExtend->getBuffer(),
+                           Source->getBuffer(),
+                           OutputFile.os(),
+                           Base,
+                           MergeLoadSegments));
+  OutputFile.keep();
+
+  if (OutputPath != "-") {
+    auto Permissions = sys::fs::getPermissions(OutputPath);
+    if (not Permissions)
+      ExitOnError(errorCodeToError(Permissions.getError()));
+
+    using namespace sys::fs;
+    auto Executable = *Permissions | owner_exe | group_exe | others_exe;
+    ExitOnError(errorCodeToError(setPermissions(OutputPath, Executable)));
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -8,8 +8,11 @@
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "revng/Model/StreamingDiff.h"
 #include "revng/Model/ToolHelpers.h"
 #include "revng/Support/InitRevng.h"
 #include "revng/Support/MetaAddress/YAMLTraits.h"
@@ -33,11 +36,43 @@ static cl::opt<std::string> DiffPath(cl::Positional,
 
 static ModelOutputOptions<false> Options(ThisToolCategory);
 
+static cl::opt<bool> Streaming("streaming",
+                               cl::cat(ThisToolCategory),
+                               cl::desc("Patch the model one top-level element "
+                                        "at a time, without loading it in "
+                                        "memory. Requires the model to be "
+                                        "sorted, as revng emits it."),
+                               cl::init(false));
+
+static int streamingApply(ExitOnError &ExitOnError) {
+  auto MaybeBuffer = MemoryBuffer::getFileOrSTDIN(PathModel);
+  if (not MaybeBuffer)
+    ExitOnError(errorCodeToError(MaybeBuffer.getError()));
+
+  using TypeDiff = TupleTreeDiff<model::Binary>;
+  auto Diff = ExitOnError(fromFileOrSTDIN<TypeDiff>(DiffPath));
+
+  std::error_code EC;
+  ToolOutputFile OutputFile(Options.getPath(), EC, sys::fs::OF_Text);
+  if (EC)
+    ExitOnError(createStringError(EC, EC.message()));
+
+  ExitOnError(model::streamingApply((*MaybeBuffer)->getBuffer(),
+                                    Diff,
+                                    OutputFile.os()));
+  OutputFile.keep();
+
+  return EXIT_SUCCESS;
+}
+
 int main(int Argc, char *Argv[]) {
   revng::InitRevng X(Argc, Argv, "", { &ThisToolCategory });
 
   ExitOnError ExitOnError;
 
+  if (Streaming)
+    return streamingApply(ExitOnError);
+
   using Type = TupleTree<model::Binary>;
   auto Model = Type::fromFileOrSTDIN(PathModel);
   if (not Model)
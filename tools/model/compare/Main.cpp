@@ -0,0 +1,71 @@
+/// \file Main.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Model/Compare.h"
+#include "revng/Support/InitRevng.h"
+
+using namespace llvm;
+
+static cl::OptionCategory ThisToolCategory("Tool options", "");
+
+static cl::opt<std::string> ReferencePath(cl::Positional,
+                                          cl::cat(ThisToolCategory),
+                                          cl::desc("<reference>"),
+                                          cl::Required,
+                                          cl::value_desc("reference"));
+
+static cl::opt<std::string> InputPath(cl::Positional,
+                                      cl::cat(ThisToolCategory),
+                                      cl::desc("<input>"),
+                                      cl::init("-"),
+                                      cl::value_desc("input"));
+
+static cl::opt<bool> Exact("exact",
+                           cl::cat(ThisToolCategory),
+                           cl::desc("Match exactly, containing the reference "
+                                    "is not enough."),
+                           cl::init(false));
+
+static cl::opt<bool> Not("not",
+                         cl::cat(ThisToolCategory),
+                         cl::desc("If it matches, return an error."),
+                         cl::init(false));
+
+static Expected<std::unique_ptr<MemoryBuffer>> read(StringRef Path) {
+  auto Buffer = MemoryBuffer::getFileOrSTDIN(Path);
+  if (not Buffer)
+    return createStringError(Buffer.getError(),
+                             "Cannot read " + Path + ": "
+                               + Buffer.getError().message());
+  return std::move(*Buffer);
+}
+
+int main(int Argc, char *Argv[]) {
+  revng::InitRevng X(Argc, Argv, "", { &ThisToolCategory });
+
+  ExitOnError ExitOnError;
+
+  auto Reference = ExitOnError(read(ReferencePath));
+  auto Input = ExitOnError(read(InputPath));
+
+  auto Result = ExitOnError(model::compareYAML(Reference->getBuffer(),
+                                               Input->getBuffer(),
+                                               Exact));
+
+  if (not Result.Matches) {
+    dbgs() << "No match found, the best match covers " << Result.MatchedNodes
+           << " nodes out of " << Result.ReferenceNodes << ".\n";
+  }
+
+  bool Success = Result.Matches != Not;
+  return Success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
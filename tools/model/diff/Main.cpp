@@ -8,9 +8,11 @@
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include "revng/Model/StreamingDiff.h"
 #include "revng/Model/ToolHelpers.h"
 #include "revng/Support/InitRevng.h"
 #include "revng/Support/MetaAddress/YAMLTraits.h"
@@ -40,11 +42,48 @@ static cl::opt<std::string> OutputFilename("o",
                                                           "filename"),
                                            llvm::cl::value_desc("filename"));
 
+static cl::opt<bool> Streaming("streaming",
+                               cl::cat(ThisToolCategory),
+                               cl::desc("Compare the models one top-level "
+                                        "element at a time, without loading "
+                                        "them in memory. Requires the models "
+                                        "to be sorted, as revng emits them."),
+                               cl::init(false));
+
+static int streamingDiff(ExitOnError &ExitOnError) {
+  auto Read = [&ExitOnError](StringRef Path) {
+    auto MaybeBuffer = MemoryBuffer::getFileOrSTDIN(Path);
+    if (not MaybeBuffer)
+      ExitOnError(errorCodeToError(MaybeBuffer.getError()));
+    return std::move(*MaybeBuffer);
+  };
+
+  auto LeftBuffer = Read(LeftModelPath);
+  auto RightBuffer = Read(RightModelPath);
+
+  std::error_code EC;
+  llvm::ToolOutputFile OutputFile(OutputFilename,
+                                  EC,
+                                  sys::fs::OpenFlags::OF_Text);
+  if (EC)
+    ExitOnError(llvm::createStringError(EC, EC.message()));
+
+  size_t Changes = ExitOnError(model::streamingDiff(LeftBuffer->getBuffer(),
+                                                    RightBuffer->getBuffer(),
+                                                    OutputFile.os()));
+  OutputFile.keep();
+
+  return Changes == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int Argc, char *Argv[]) {
   revng::InitRevng X(Argc, Argv, "", { &ThisToolCategory });
 
   ExitOnError ExitOnError;
 
+  if (Streaming)
+    return streamingDiff(ExitOnError);
+
   using Model = TupleTree<model::Binary>;
   auto LeftModel = Model::fromFileOrSTDIN(LeftModelPath);
   if (not LeftModel)
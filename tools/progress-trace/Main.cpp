@@ -0,0 +1,56 @@
+/// \file Main.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+#include "revng/Support/InitRevng.h"
+#include "revng/Support/ProgressTrace.h"
+
+using namespace llvm;
+
+static cl::OptionCategory ThisToolCategory("Tool options", "");
+
+static cl::opt<std::string> InputPath(cl::Positional,
+                                      cl::cat(ThisToolCategory),
+                                      cl::desc("<input trace>"),
+                                      cl::init("-"),
+                                      cl::value_desc("trace"));
+
+static cl::opt<std::string> OutputPath("o",
+                                       cl::cat(ThisToolCategory),
+                                       cl::init("-"),
+                                       cl::desc("Override output filename"),
+                                       cl::value_desc("filename"));
+
+int main(int Argc, char *Argv[]) {
+  revng::InitRevng X(Argc,
+                     Argv,
+                     "Convert a trace produced by --trace to the Chrome trace "
+                     "event format",
+                     { &ThisToolCategory });
+
+  ExitOnError ExitOnError;
+
+  auto MaybeBuffer = MemoryBuffer::getFileOrSTDIN(InputPath);
+  if (not MaybeBuffer)
+    ExitOnError(errorCodeToError(MaybeBuffer.getError()));
+
+  std::error_code EC;
+  ToolOutputFile OutputFile(OutputPath, EC, sys::fs::OpenFlags::OF_Text);
+  if (EC)
+    ExitOnError(createStringError(EC, EC.message()));
+
+  ExitOnError(ProgressTrace::toChromeJSON((*MaybeBuffer)->getBuffer(),
+                                          OutputFile.os()));
+  OutputFile.keep();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+/// \file Main.cpp
+/// Render a PTML document as plain or colorized text.
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/PTML/TextRenderer.h"
+#include "revng/Support/InitRevng.h"
+
+using namespace llvm;
+
+static cl::OptionCategory ThisToolCategory("Tool options", "");
+
+static cl::opt<std::string> InputPath(cl::Positional,
+                                      cl::cat(ThisToolCategory),
+                                      cl::desc("<input PTML>"),
+                                      cl::init("-"),
+                                      cl::value_desc("input"));
+
+static cl::opt<std::string> OutputFilename("o",
+                                           cl::cat(ThisToolCategory),
+                                           cl::init("-"),
+                                           cl::desc("Override output "
+                                                    "filename"),
+                                           cl::value_desc("filename"));
+
+static cl::opt<bool> Color("color",
+                           cl::cat(ThisToolCategory),
+                           cl::desc("Colorize the output"),
+                           cl::init(false));
+
+static cl::opt<std::string> Indent("indent",
+                                   cl::cat(ThisToolCategory),
+                                   cl::desc("String to print after each "
+                                            "newline"),
+                                   cl::init(""));
+
+int main(int Argc, char *Argv[]) {
+  revng::InitRevng X(Argc, Argv, "", { &ThisToolCategory });
+
+  ExitOnError ExitOnError;
+
+  sys::fs::file_t Input = sys::fs::getStdinHandle();
+  if (InputPath != "-")
+    Input = ExitOnError(sys::fs::openNativeFileForRead(InputPath));
+
+  std::error_code EC;
+  ToolOutputFile OutputFile(OutputFilename, EC, sys::fs::OpenFlags::OF_Text);
+  if (EC)
+    ExitOnError(createStringError(EC, EC.message()));
+
+  // Read the input in fixed size chunks, so that the memory usage does not
+  // depend on the size of the document
+  ptml::TextRenderer Renderer(OutputFile.os(), Color, Indent);
+  constexpr size_t ChunkSize = 64 * 1024;
+  SmallVector<char, 0> Buffer(ChunkSize);
+  while (size_t Read = ExitOnError(sys::fs::readNativeFile(Input, Buffer)))
+    Renderer.feed(StringRef(Buffer.data(), Read));
+
+  if (InputPath != "-")
+    sys::fs::closeFile(Input);
+
+  ExitOnError(Renderer.finish());
+  OutputFile.keep();
+
+  return EXIT_SUCCESS;
+}
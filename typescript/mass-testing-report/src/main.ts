@@ -46,11 +46,30 @@ interface Metadata {
     notes?: string;
     reproducer_prelude?: string;
 
+    // Ratios between the current and the baseline run above which a binary is
+    // considered to have regressed, see `populateComparison`
+    regression_thresholds?: Partial<RegressionThresholds>;
+
     // Autogenerated by `revng mass-testing run`
     cpu_count: number;
     start_time: number;
 }
 
+interface RegressionThresholds {
+    elapsed_time: number;
+    max_rss: number;
+    step_time: number;
+    // Times (in seconds) below this value are too noisy to be compared
+    min_time: number;
+}
+
+const DEFAULT_REGRESSION_THRESHOLDS: RegressionThresholds = {
+    elapsed_time: 1.2,
+    max_rss: 1.2,
+    step_time: 1.5,
+    min_time: 1,
+};
+
 async function initSqlite3(): Promise<Sqlite3Static> {
     if (window._sqlite3 !== undefined) {
         return window._sqlite3;
@@ -197,6 +216,7 @@ const NAV_ITEMS: Record<string, string[]> = {
     Timeouts: ["timeouts.html"],
     OOMs: ["ooms.html"],
     Successes: ["successes.html"],
+    Comparison: ["compare.html"],
     "Raw Data": ["raw_data.html"],
 };
 
@@ -402,6 +422,13 @@ function getColumns(meta: Metadata): Columns[] {
             render: RENDERERS["time"],
             className: "dt-body-right",
         },
+        {
+            name: "max_rss",
+            data: "max_rss",
+            title: "peak RSS",
+            render: RENDERERS["filesize"],
+            className: "dt-body-right",
+        },
         { name: "exit_code", data: "exit_code", title: "exit code", className: "dt-body-right" },
         { name: "status", data: "status", title: "status" },
         { name: "stacktrace_id", data: "stacktrace_id", title: "stacktrace id", orderable: false },
@@ -674,6 +701,190 @@ function populateBinaryDetail(element: HTMLElement, db: Database, meta: Metadata
             tdValue.innerHTML = data[column.data as string];
         }
     }
+
+    for (const key of ["user_time", "system_time", "major_page_faults", "minor_page_faults"]) {
+        const tr = createAndAppend(tbody, "tr");
+        createAndAppend(tr, "td").innerHTML = key.replaceAll("_", " ");
+        createAndAppend(tr, "td").innerHTML = data[key];
+    }
+
+    // Time spent in each step, followed by the time spent in each of its pipes
+    const timings = db.exec({
+        sql: "SELECT step, pipe, elapsed_time FROM timings WHERE name = ? ORDER BY step, pipe",
+        bind: [name],
+        rowMode: "object",
+        returnValue: "resultRows",
+    });
+    if (timings.length === 0) {
+        return;
+    }
+
+    const timingsTitle = createAndAppend(element, "h3");
+    timingsTitle.innerHTML = "Timings";
+    const timingsTable = createAndAppend(element, "table");
+    timingsTable.className = "table table-bordered table-sm";
+    timingsTable.style.width = "70%";
+    const timingsBody = createAndAppend(timingsTable, "tbody");
+    for (const entry of timings) {
+        const tr = createAndAppend(timingsBody, "tr");
+        const tdName = createAndAppend(tr, "td");
+        if (entry.pipe === "") {
+            tdName.innerHTML = `<b>${entry.step}</b>`;
+        } else {
+            tdName.innerHTML = `&nbsp;&nbsp;${entry.pipe}`;
+        }
+        const tdTime = createAndAppend(tr, "td");
+        tdTime.className = "dt-body-right";
+        tdTime.innerHTML = formatTime(entry.elapsed_time as number, false);
+    }
+}
+
+interface Regression {
+    name: string;
+    metric: string;
+    baseline: number | string;
+    current: number | string;
+    ratio: number | null;
+}
+
+// Compares the current run with the baseline one (`baseline.db`, or the URL
+// specified by the `baseline` search parameter) and lists all the binaries
+// that got worse above the thresholds specified in `meta.yml`
+async function populateComparison(element: HTMLElement, db: Database, meta: Metadata) {
+    const thresholds: RegressionThresholds = {
+        ...DEFAULT_REGRESSION_THRESHOLDS,
+        ...(meta.regression_thresholds || {}),
+    };
+    const searchParams = new URLSearchParams(window.location.search);
+    const baselineUrl = searchParams.get("baseline") ?? "baseline.db";
+
+    const pre = createAndAppend(element, "pre");
+    let baseline: Database;
+    try {
+        baseline = await loadDBFromURL(baselineUrl);
+        baseline.exec("SELECT name FROM main LIMIT 1");
+    } catch (e) {
+        pre.innerHTML = `Could not load the baseline from ${baselineUrl}`;
+        return;
+    }
+
+    const query = (target: Database, sql: string) =>
+        target.exec({ sql, rowMode: "object", returnValue: "resultRows" });
+    const byName = (rows: Record<string, any>[], key: (row: Record<string, any>) => string) =>
+        new Map(rows.map((row) => [key(row), row]));
+
+    // Baselines produced by older versions might lack some of the columns
+    const wantedColumns = ["name", "status", "elapsed_time", "max_rss"];
+    const mainQuery = (target: Database) => {
+        const existing = new Set(
+            query(target, "PRAGMA table_info(main)").map((row) => row.name as string),
+        );
+        const columns = wantedColumns.filter((column) => existing.has(column));
+        return `SELECT ${columns.join(", ")} FROM main`;
+    };
+    const current = byName(query(db, mainQuery(db)), (row) => row.name);
+    const previous = byName(query(baseline, mainQuery(baseline)), (row) => row.name);
+
+    const stepsQuery = "SELECT name, step, elapsed_time FROM timings WHERE pipe = ''";
+    const stepKey = (row: Record<string, any>) => `${row.name}\0${row.step}`;
+    const currentSteps = byName(query(db, stepsQuery), stepKey);
+    let previousSteps = new Map<string, Record<string, any>>();
+    try {
+        previousSteps = byName(query(baseline, stepsQuery), stepKey);
+    } catch (e) {
+        // The baseline predates the timings table
+        if (!(e instanceof SQLite3Error)) {
+            throw e;
+        }
+    }
+
+    const regressions: Regression[] = [];
+    const check = (name: string, metric: string, before: number, after: number, limit: number) => {
+        if (before === undefined || after === undefined) {
+            return;
+        }
+        const isTime = metric !== "max_rss";
+        if (isTime && before < thresholds.min_time && after < thresholds.min_time) {
+            return;
+        }
+        const ratio = after / Math.max(before, Number.EPSILON);
+        if (ratio > limit) {
+            regressions.push({ name, metric, baseline: before, current: after, ratio });
+        }
+    };
+
+    let compared = 0;
+    for (const [name, after] of current) {
+        const before = previous.get(name);
+        if (before === undefined) {
+            continue;
+        }
+        compared++;
+
+        if (before.status === "OK" && after.status !== "OK") {
+            const entry = { name, metric: "status", ratio: null };
+            regressions.push({ ...entry, baseline: before.status, current: after.status });
+            continue;
+        }
+        if (before.status !== "OK" || after.status !== "OK") {
+            continue;
+        }
+
+        const timeLimit = thresholds.elapsed_time;
+        check(name, "elapsed_time", before.elapsed_time, after.elapsed_time, timeLimit);
+        check(name, "max_rss", before.max_rss, after.max_rss, thresholds.max_rss);
+    }
+
+    for (const [key, after] of currentSteps) {
+        const before = previousSteps.get(key);
+        const status = current.get(after.name)?.status;
+        if (before === undefined || status !== "OK" || previous.get(after.name)?.status !== "OK") {
+            continue;
+        }
+        const metric = `step ${after.step}`;
+        check(after.name, metric, before.elapsed_time, after.elapsed_time, thresholds.step_time);
+    }
+
+    const regressed = new Set(regressions.map((r) => r.name)).size;
+    pre.innerHTML = `Baseline: ${baselineUrl}\n`;
+    pre.innerHTML += `Binaries compared: ${compared}\n`;
+    pre.innerHTML += `Binaries regressed: ${regressed} (${percent(regressed, compared)})\n`;
+    pre.innerHTML += `Thresholds: ${JSON.stringify(thresholds)}`;
+
+    const renderValue = (data: any, type: string, row: Regression) => {
+        if (typeof data !== "number" || type !== "display") {
+            return data;
+        }
+        return row.metric === "max_rss" ? filesize(data, { base: 2 }) : formatTime(data, false);
+    };
+    const table = createAndAppend(element, "table");
+    table.className = "compact";
+    new DataTable(table, {
+        data: regressions,
+        columns: [
+            {
+                data: "name",
+                title: "name",
+                render: (data: string, type: string) =>
+                    type === "display" ? `<a href="binary.html#${data}">${data}</a>` : data,
+            },
+            { data: "metric", title: "metric" },
+            {
+                data: "baseline",
+                title: "baseline",
+                render: renderValue,
+                className: "dt-body-right",
+            },
+            { data: "current", title: "current", render: renderValue, className: "dt-body-right" },
+            {
+                data: "ratio",
+                title: "ratio",
+                render: (data: number | null) => (data === null ? "" : `${truncate(data, 2)}x`),
+                className: "dt-body-right",
+            },
+        ],
+        order: [[4, "desc"]],
+    });
 }
 
 // Entrypoint, will dispatch to the right function based on element ids or
@@ -708,6 +919,11 @@ async function main() {
     if (binaryDetail !== null) {
         populateBinaryDetail(binaryDetail, db, meta);
     }
+
+    const comparison = document.getElementById("comparison");
+    if (comparison !== null) {
+        await populateComparison(comparison, db, meta);
+    }
 }
 
 main().then(() => {});